@@ -14,7 +14,49 @@ namespace EngineConfig
         .inputMode = InputMode::eEngine };
 
     constexpr std::string_view defaultScenePath = "~/Assets/Scenes/Duck/Duck.glb";
+    
+    // Pipeline cache is saved on exit and every interval (seconds, 0 disables) if it has grown, so crashes keep it
+    constexpr float pipelineCacheSaveInterval = 60.0f;
 
     // Feature to copy the whole scene with random transforms many times to reach significant amount of issued draws
     constexpr bool randomlyCopyScene = true;
+    constexpr size_t randomlyCopiedSceneDrawCount = 4'194'304;
+    constexpr uint32_t randomlyCopiedSceneSeed = 228;
+    
+    // Generates the copies by RandomlyCopyScene.comp in device memory instead of building and uploading them on CPU,
+    // both produce the same draws for the same seed (see SceneCopy.h)
+    constexpr bool randomlyCopySceneOnGpu = true;
+    
+    // Orders draws inside each draw cluster by Morton code of their position and then by primitive index, so neighbouring
+    // culling threads and indirect commands reference spatially close draws and the same primitives
+    constexpr bool sortDrawsByMortonCode = true;
+    
+    // Merges small primitives of the loaded scene sharing a material into 1 primitive per cell of a world grid, so they
+    // cost 1 draw (cull thread, commands, task workgroups) together, sizes are fractions of the scene bounding radius
+    // Batches are made of the LODs of their primitives, so they don't get coarser than the primitives would be
+    constexpr bool batchSmallPrimitives = true;
+    constexpr float smallPrimitiveRadius = 0.01f; // Primitives with smaller world bounding radius are batched
+    constexpr float primitiveBatchCellSize = 0.1f;
+    
+    // Task command buffer is sized for every draw at its most detailed LOD, but not bigger than this budget,
+    // commands past it are dropped and counted (see gpu::DrawCounters::overflowCommandCount)
+    constexpr size_t maxTaskCommandBufferSize = 512ull * 1024 * 1024;
+    
+    // Same for commands (1 per task command) and triangle indices of visible meshlets with vertex pipeline meshlet culling
+    constexpr size_t maxMeshletCommandBufferSize = 128ull * 1024 * 1024;
+    constexpr size_t maxMeshletIndexBufferSize = 256ull * 1024 * 1024;
+    
+    // Commands and instances each extra view can emit per frame (see gpu::ExtraViews), the rest are dropped and counted
+    constexpr size_t extraViewCommandCapacity = 65'536;
+    
+    // Camera cut is a jump of the culling camera farther than the distance or a turn by an angle with smaller cosine,
+    // visibility of the previous frame is useless after it, so the first occlusion culling pass is seeded on CPU
+    constexpr float cameraCutDistance = 10.0f;
+    constexpr float cameraCutMinCosAngle = 0.7f;
+    
+    // Software occlusion culling on camera cuts (see SoftwareOcclusionCuller), extent must be a multiple of 8
+    constexpr uint32_t softwareOcclusionWidth = 256;
+    constexpr uint32_t softwareOcclusionHeight = 144;
+    constexpr size_t maxSoftwareOccluderCount = 256;
+    constexpr float minSoftwareOccluderSize = 0.05f; // Bounding sphere radius divided by view depth
 }
@@ -18,6 +18,8 @@ namespace FileSystem
     };
 
     std::vector<char> ReadFile(const FilePath& path);
+    // Creates missing directories, data is written next to the file and moved over it, so it's never left truncated
+    bool WriteFile(const FilePath& path, std::span<const char> data);
     void CreateDirectories(const FilePath& path);
 
     FilePath ShowOpenFileDialog(const DialogDescription& description);
@@ -25,6 +25,28 @@ namespace FileSystem
         return buffer;
     }
 
+    bool WriteFile(const FilePath& path, const std::span<const char> data)
+    {
+        CreateDirectories(path);
+        
+        const std::string temporaryPath = path.GetAbsolute() + ".tmp";
+        
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            
+            if (!file.good())
+            {
+                return false;
+            }
+        }
+        
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, path.GetAbsolute(), error);
+        
+        return !error;
+    }
+
     void CreateDirectories(const FilePath& path)
     {
         std::filesystem::create_directories(path.GetDirectory());
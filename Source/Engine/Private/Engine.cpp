@@ -52,6 +52,7 @@ void Engine::Run()
     using namespace std::chrono;
 
     time_point<high_resolution_clock> lastFrameTime = high_resolution_clock::now();
+    float pipelineCacheSaveTimer = 0.0f;
 
     while (!window->ShouldClose())
     {
@@ -69,6 +70,14 @@ void Engine::Run()
         {
             renderSystem->Render();
         }        
+
+        pipelineCacheSaveTimer += deltaSeconds;
+
+        if (EngineConfig::pipelineCacheSaveInterval > 0.0f && pipelineCacheSaveTimer >= EngineConfig::pipelineCacheSaveInterval)
+        {
+            vulkanContext->GetDevice().SavePipelineCache();
+            pipelineCacheSaveTimer = 0.0f;
+        }
     }
 
     vulkanContext->GetDevice().WaitIdle();
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Shaders/Common.h"
+#include "Utils/ThreadPool.hpp"
+
+enum class CpuCullingCommands
+{
+    eTask = 0, // Mesh pipeline
+    eIndexed, // Vertex pipeline with draw indirect count, commands of visible draws only
+    eIndexedPerDraw, // Vertex pipeline without draw indirect count, culled draws have empty commands
+};
+
+// Output of 1 culling pass in the formats PrimitiveCull.comp writes, visible draws are in increasing draw index order
+struct CpuCullingOutput
+{
+    std::vector<gpu::VisibleInstance> visibleInstances;
+    std::vector<uint32_t> instanceLods; // LOD index of each visible instance, see VISUALIZE_LODS
+    std::vector<uint32_t> instancePrimitiveLods; // Primitive and LOD of each visible instance, see VISIBILITY_BUFFER
+    std::vector<uint32_t> visibleDraws; // Draw index of each visible instance, see DEBUG_BOUNDS
+    std::vector<gpu::TaskCommand> taskCommands;
+    std::vector<gpu::VkDrawIndexedIndirectCommand> indirectCommands;
+    uint32_t overflowCommandCount = 0; // Task commands past maxCommandCount, see gpu::DrawCounters
+};
+
+// CPU implementation of PrimitiveCull.comp without occlusion culling: frustum and contribution culling and LOD selection
+// Doesn't depend on Vulkan, it needs only a ThreadPool and spans of scene data, so GPU results can be validated against it
+// by driving it directly, see PrimitiveCullStage::ValidateCpuCulling
+// World bounding spheres of the draws are precomputed as SoA and culled by SIMD kernels (AVX / SSE / NEON, scalar
+// fallback) in chunks distributed across the thread pool
+// Primitives and draws are referenced, not copied, so they must outlive the culler
+class CpuCuller
+{
+public:
+    CpuCuller(ThreadPool& threadPool, std::span<const gpu::Primitive> primitives,
+        std::span<const gpu::PrimitiveBounds> primitiveBounds, std::span<const gpu::Draw> draws);
+    ~CpuCuller();
+
+    CpuCuller(const CpuCuller&) = delete;
+    CpuCuller& operator=(const CpuCuller&) = delete;
+
+    CpuCuller(CpuCuller&&) = delete;
+    CpuCuller& operator=(CpuCuller&&) = delete;
+
+    // Culls first globals.drawCount draws with globals.cullData, task commands are limited by maxCommandCount
+    void Cull(const gpu::PushConstants& globals, CpuCullingCommands commands, size_t maxCommandCount,
+        CpuCullingOutput& output);
+
+private:
+    struct ChunkResult
+    {
+        std::vector<uint32_t> visibleDraws;
+        std::vector<uint32_t> lodIndices;
+        size_t commandCount = 0;
+    };
+
+    void CullChunk(const gpu::PushConstants& globals, CpuCullingCommands commands, size_t begin, size_t end,
+        ChunkResult& result) const;
+    void WriteChunk(const ChunkResult& result, CpuCullingCommands commands, size_t firstInstance, size_t firstCommand,
+        CpuCullingOutput& output) const;
+
+    ThreadPool* threadPool = nullptr;
+
+    std::span<const gpu::Primitive> primitives;
+    std::span<const gpu::Draw> draws;
+
+    // World space bounding spheres of the draws, padded to SIMD width
+    std::vector<float> centersX;
+    std::vector<float> centersY;
+    std::vector<float> centersZ;
+    std::vector<float> radii;
+
+    std::vector<ChunkResult> chunkResults; // Reused between passes
+};
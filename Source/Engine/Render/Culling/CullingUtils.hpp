@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Shaders/Common.h"
+#include "Utils/DataStructures.hpp"
+
+// CPU versions of the culling functions of the shaders
+namespace CullingUtils
+{
+    // World bounding sphere of the draw, same as in PrimitiveCull.comp
+    Sphere GetWorldSphere(const gpu::Draw& draw, const gpu::PrimitiveBounds& bounds);
+
+    // Same as frustumCull() in Culling.glsl, center is in view space
+    bool FrustumCull(const gpu::CullData& cullData, const glm::vec3& center, float radius);
+
+    // Same as sphereNdcExtents() in Math.glsl: NDC rect (Y up) of the view space sphere, empty if it crosses near plane
+    std::optional<glm::vec4> SphereNdcExtents(const glm::vec3& center, float radius, float p00, float p11, float near);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Shaders/Common.h"
+
+// Low resolution software depth buffer for occlusion culling on CPU
+// Stores 1 / w (reverse linear depth, 0 is infinitely far) which is linear in screen space, occluder triangles are
+// rasterized with SIMD rows of pixels keeping the closest depth, then the farthest depth of each tile is used to test
+// bounding spheres conservatively
+class OcclusionRasterizer
+{
+public:
+    static constexpr uint32_t tileSize = 8;
+
+    // Extent must be a multiple of tileSize
+    OcclusionRasterizer(uint32_t width, uint32_t height);
+
+    // Clears depth and sets the view projection of the following rasterization and tests
+    void Begin(const glm::mat4& view, const glm::mat4& projection, float near);
+
+    // Triangles crossing the near plane are skipped, so fewer occluders are rasterized, but never a wrong depth
+    // Indices are relative to vertices, transform is from object to world space
+    void RasterizeTriangles(const glm::mat4& transform, std::span<const gpu::Vertex> vertices,
+        std::span<const uint32_t> indices);
+
+    // Builds tile depths, call after all occluders are rasterized
+    void End();
+
+    // View space sphere is occluded if its closest point is behind the farthest occluder depth in every tile it covers
+    bool IsOccluded(const glm::vec3& center, float radius) const;
+
+private:
+    // Vertices are in screen space: pixel coordinates and 1 / w
+    void RasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    glm::mat4 view = glm::mat4(1.0f);
+    float p00 = 1.0f;
+    float p11 = 1.0f;
+    float near = 0.0f;
+
+    std::vector<float> depth;
+    std::vector<float> tileDepth;
+};
@@ -0,0 +1,323 @@
+#include "Engine/Render/Culling/CpuCuller.hpp"
+
+#include "Utils/Math.hpp"
+#include "Utils/Helpers.hpp"
+#include "Engine/Render/Culling/SimdFloats.hpp"
+#include "Engine/Render/Culling/CullingUtils.hpp"
+
+#include <bit>
+
+namespace CpuCullerDetails
+{
+    using namespace Simd;
+
+    static constexpr size_t chunkSize = 16384; // Draws per thread pool job, multiple of Simd::maxWidth
+
+    static_assert(chunkSize % maxWidth == 0);
+
+    // Pass constants splatted to SIMD registers
+    struct CullConstants
+    {
+        std::array<std::array<Floats, 4>, 3> view; // First 3 rows of view matrix
+
+        Floats frustumRightX;
+        Floats frustumRightZ;
+        Floats frustumTopY;
+        Floats frustumTopZ;
+        Floats negativeNear;
+
+        Floats p00;
+        Floats negativeP11;
+        Floats contributionThreshold;
+    };
+
+    static CullConstants CreateCullConstants(const gpu::PushConstants& globals)
+    {
+        const gpu::CullData& cullData = globals.cullData;
+
+        CullConstants constants{};
+        constants.frustumRightX = Floats::Splat(cullData.frustumRightX);
+        constants.frustumRightZ = Floats::Splat(cullData.frustumRightZ);
+        constants.frustumTopY = Floats::Splat(cullData.frustumTopY);
+        constants.frustumTopZ = Floats::Splat(cullData.frustumTopZ);
+        constants.negativeNear = Floats::Splat(-cullData.near);
+        constants.p00 = Floats::Splat(globals.projection[0][0]);
+        constants.negativeP11 = Floats::Splat(-globals.projection[1][1]);
+        constants.contributionThreshold = Floats::Splat(cullData.contributionThreshold);
+
+        for (uint32_t row = 0; row < 3; ++row)
+        {
+            for (uint32_t column = 0; column < 4; ++column)
+            {
+                constants.view[row][column] = Floats::Splat(cullData.view[column][row]);
+            }
+        }
+
+        return constants;
+    }
+
+    // Same tests as frustumCull() and contribution culling with sphereNdcExtents() in PrimitiveCull.comp,
+    // returns bits of visible spheres among Floats::width ones starting from the pointers
+    static uint32_t CullSpheres(const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+        const CullConstants& constants)
+    {
+        const auto& view = constants.view;
+
+        const Floats worldX = Floats::Load(centersX);
+        const Floats worldY = Floats::Load(centersY);
+        const Floats worldZ = Floats::Load(centersZ);
+        const Floats radius = Floats::Load(radii);
+
+        const Floats x = view[0][0] * worldX + view[0][1] * worldY + view[0][2] * worldZ + view[0][3];
+        const Floats y = view[1][0] * worldX + view[1][1] * worldY + view[1][2] * worldZ + view[1][3];
+        const Floats z = view[2][0] * worldX + view[2][1] * worldY + view[2][2] * worldZ + view[2][3];
+
+        const Floats zero = Floats::Splat(0.0f);
+        const Floats negativeRadius = zero - radius;
+        const Floats negativeZ = zero - z;
+
+        Mask culled = constants.frustumRightX * Abs(x) + constants.frustumRightZ * z < negativeRadius;
+        culled = culled | (constants.frustumTopY * Abs(y) + constants.frustumTopZ * z < negativeRadius);
+        culled = culled | (z - radius > constants.negativeNear);
+
+        // Extents are valid only for spheres completely in front of the camera, NaNs of the others are masked out
+        const Mask invalidExtents = z + radius > constants.negativeNear;
+
+        const Floats rad2 = radius * radius;
+        const Floats d = negativeZ * radius;
+
+        const Floats hv = Sqrt(x * x + z * z - rad2);
+        const Floats ha = x * hv;
+        const Floats hb = x * radius;
+        const Floats hc = negativeZ * hv;
+        const Floats left = (ha - d) * constants.p00 / (hc + hb);
+        const Floats right = (ha + d) * constants.p00 / (hc - hb);
+
+        const Floats vv = Sqrt(y * y + z * z - rad2);
+        const Floats va = y * vv;
+        const Floats vb = y * radius;
+        const Floats vc = negativeZ * vv;
+        const Floats bottom = (va - d) * constants.negativeP11 / (vc + vb);
+        const Floats top = (va + d) * constants.negativeP11 / (vc - vb);
+
+        const Mask belowContribution = Max(right - left, top - bottom) < constants.contributionThreshold;
+        culled = culled | AndNot(belowContribution, invalidExtents);
+
+        return ~ToBits(culled) & ((1u << Floats::width) - 1);
+    }
+
+    // Same as calculateLodIndex() in PrimitiveCull.comp, center is in view space
+    static uint32_t CalculateLodIndex(const gpu::Primitive& primitive, const float scale, const glm::vec3& center,
+        const float radius, const float lodTarget)
+    {
+        const float distanceToSphere = std::max(glm::length(center) - radius, 0.0f);
+        const float threshold = distanceToSphere * lodTarget / scale;
+
+        uint32_t lodIndex = 0;
+
+        while (lodIndex < primitive.lodCount - 1 && primitive.lods[lodIndex + 1].error < threshold)
+        {
+            ++lodIndex;
+        }
+
+        return lodIndex;
+    }
+
+    // Same as composeTransform() in Math.glsl
+    static glm::mat3x4 ComposeTransform(const gpu::Draw& draw)
+    {
+        const glm::quat rotation = Math::UnpackQuatSmallestThree(draw.rotation);
+        const glm::vec3 q2 = glm::vec3(rotation.x, rotation.y, rotation.z) * 2.0f;
+
+        const float xx = rotation.x * q2.x, yy = rotation.y * q2.y, zz = rotation.z * q2.z;
+        const float xy = rotation.x * q2.y, xz = rotation.x * q2.z, yz = rotation.y * q2.z;
+        const float wx = rotation.w * q2.x, wy = rotation.w * q2.y, wz = rotation.w * q2.z;
+
+        return {
+            glm::vec4(glm::vec3(1.0f - (yy + zz), xy - wz, xz + wy) * draw.scale, draw.position.x),
+            glm::vec4(glm::vec3(xy + wz, 1.0f - (xx + zz), yz - wx) * draw.scale, draw.position.y),
+            glm::vec4(glm::vec3(xz - wy, yz + wx, 1.0f - (xx + yy)) * draw.scale, draw.position.z) };
+    }
+
+    static uint32_t GetTaskCommandCount(const gpu::Lod& lod)
+    {
+        return (lod.meshletCount + gpu::taskWgSize - 1) / gpu::taskWgSize;
+    }
+}
+
+CpuCuller::CpuCuller(ThreadPool& aThreadPool, const std::span<const gpu::Primitive> aPrimitives,
+    const std::span<const gpu::PrimitiveBounds> primitiveBounds, const std::span<const gpu::Draw> aDraws)
+    : threadPool{ &aThreadPool }
+    , primitives{ aPrimitives }
+    , draws{ aDraws }
+{
+    using namespace CpuCullerDetails;
+
+    ScopeTimer timer("Build CPU culling data");
+
+    const size_t paddedDrawCount = (draws.size() + maxWidth - 1) / maxWidth * maxWidth;
+
+    centersX.resize(paddedDrawCount, 0.0f);
+    centersY.resize(paddedDrawCount, 0.0f);
+    centersZ.resize(paddedDrawCount, 0.0f);
+    radii.resize(paddedDrawCount, 0.0f);
+
+    // Draws are static, so world bounds are computed once instead of rotating primitive bounds every pass
+    threadPool->ParallelFor(draws.size(), chunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const Sphere sphere = CullingUtils::GetWorldSphere(draws[i], primitiveBounds[draws[i].primitiveIndex]);
+
+            centersX[i] = sphere.center.x;
+            centersY[i] = sphere.center.y;
+            centersZ[i] = sphere.center.z;
+            radii[i] = sphere.radius;
+        }
+    });
+}
+
+CpuCuller::~CpuCuller() = default;
+
+void CpuCuller::Cull(const gpu::PushConstants& globals, const CpuCullingCommands commands, const size_t maxCommandCount,
+    CpuCullingOutput& output)
+{
+    using namespace CpuCullerDetails;
+
+    const size_t drawCount = std::min(static_cast<size_t>(globals.drawCount), draws.size());
+    const size_t chunkCount = (drawCount + chunkSize - 1) / chunkSize;
+
+    chunkResults.resize(chunkCount);
+
+    threadPool->ParallelFor(chunkCount, 1, [&](const size_t chunk, size_t) {
+        CullChunk(globals, commands, chunk * chunkSize, std::min((chunk + 1) * chunkSize, drawCount), chunkResults[chunk]);
+    });
+
+    // Chunks write their visible draws in chunk order, so the output doesn't depend on thread scheduling
+    std::vector<size_t> firstInstances(chunkCount);
+    std::vector<size_t> firstCommands(chunkCount);
+
+    size_t instanceCount = 0;
+    size_t commandCount = 0;
+
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        firstInstances[chunk] = instanceCount;
+        firstCommands[chunk] = commandCount;
+
+        instanceCount += chunkResults[chunk].visibleDraws.size();
+        commandCount += chunkResults[chunk].commandCount;
+    }
+
+    output.visibleInstances.resize(instanceCount);
+    output.instanceLods.resize(instanceCount);
+    output.instancePrimitiveLods.resize(instanceCount);
+    output.visibleDraws.resize(instanceCount);
+    output.taskCommands.clear();
+    output.indirectCommands.clear();
+    output.overflowCommandCount = 0;
+
+    switch (commands)
+    {
+    case CpuCullingCommands::eTask:
+        output.taskCommands.resize(std::min(commandCount, maxCommandCount));
+        output.overflowCommandCount = static_cast<uint32_t>(commandCount - output.taskCommands.size());
+        break;
+    case CpuCullingCommands::eIndexed:
+        output.indirectCommands.resize(commandCount);
+        break;
+    case CpuCullingCommands::eIndexedPerDraw:
+        output.indirectCommands.resize(drawCount); // Value initialized commands have 0 instances
+        break;
+    }
+
+    threadPool->ParallelFor(chunkCount, 1, [&](const size_t chunk, size_t) {
+        WriteChunk(chunkResults[chunk], commands, firstInstances[chunk], firstCommands[chunk], output);
+    });
+}
+
+void CpuCuller::CullChunk(const gpu::PushConstants& globals, const CpuCullingCommands commands, const size_t begin,
+    const size_t end, ChunkResult& result) const
+{
+    using namespace CpuCullerDetails;
+
+    result.visibleDraws.clear();
+    result.lodIndices.clear();
+    result.commandCount = 0;
+
+    const CullConstants constants = CreateCullConstants(globals);
+
+    for (size_t first = begin; first < end; first += Floats::width)
+    {
+        uint32_t visibleBits = CullSpheres(&centersX[first], &centersY[first], &centersZ[first], &radii[first], constants);
+
+        if (end - first < Floats::width) // Padding and draws past the draw count
+        {
+            visibleBits &= (1u << (end - first)) - 1;
+        }
+
+        for (; visibleBits != 0; visibleBits &= visibleBits - 1)
+        {
+            const auto drawIndex = static_cast<uint32_t>(first + std::countr_zero(visibleBits));
+
+            const gpu::Draw& draw = draws[drawIndex];
+            const gpu::Primitive& primitive = primitives[draw.primitiveIndex];
+
+            uint32_t lodIndex = 0;
+
+            if (globals.bUseLods == 1)
+            {
+                const glm::vec4 worldCenter(centersX[drawIndex], centersY[drawIndex], centersZ[drawIndex], 1.0f);
+                const glm::vec3 center(globals.cullData.view * worldCenter);
+
+                lodIndex = CalculateLodIndex(primitive, draw.scale, center, radii[drawIndex], globals.lodTarget);
+            }
+
+            result.visibleDraws.push_back(drawIndex);
+            result.lodIndices.push_back(lodIndex);
+            result.commandCount += commands == CpuCullingCommands::eTask ? GetTaskCommandCount(primitive.lods[lodIndex]) : 1;
+        }
+    }
+}
+
+void CpuCuller::WriteChunk(const ChunkResult& result, const CpuCullingCommands commands, const size_t firstInstance,
+    size_t firstCommand, CpuCullingOutput& output) const
+{
+    using namespace CpuCullerDetails;
+
+    for (size_t i = 0; i < result.visibleDraws.size(); ++i)
+    {
+        const uint32_t drawIndex = result.visibleDraws[i];
+        const uint32_t lodIndex = result.lodIndices[i];
+        const auto instanceIndex = static_cast<uint32_t>(firstInstance + i);
+
+        const gpu::Draw& draw = draws[drawIndex];
+        const gpu::Primitive& primitive = primitives[draw.primitiveIndex];
+        const gpu::Lod& lod = primitive.lods[lodIndex];
+
+        output.visibleInstances[instanceIndex].transform = ComposeTransform(draw);
+        output.instanceLods[instanceIndex] = lodIndex;
+        output.instancePrimitiveLods[instanceIndex] = draw.primitiveIndex * gpu::maxLodCount + lodIndex;
+        output.visibleDraws[instanceIndex] = drawIndex;
+
+        if (commands == CpuCullingCommands::eTask)
+        {
+            const uint32_t taskCommandCount = GetTaskCommandCount(lod);
+
+            for (uint32_t j = 0; j < taskCommandCount && firstCommand + j < output.taskCommands.size(); ++j)
+            {
+                output.taskCommands[firstCommand + j] = { .instanceIndex = instanceIndex,
+                    .meshletOffset = lod.meshletOffset + j * gpu::taskWgSize,
+                    .meshletCount = std::min(lod.meshletCount - j * gpu::taskWgSize, gpu::taskWgSize), .padding = 0 };
+            }
+
+            firstCommand += taskCommandCount;
+
+            continue;
+        }
+
+        const size_t commandIndex = commands == CpuCullingCommands::eIndexed ? firstCommand++ : drawIndex;
+
+        output.indirectCommands[commandIndex] = { .indexCount = lod.indexCount, .instanceCount = 1,
+            .firstIndex = lod.indexOffset, .vertexOffset = primitive.vertexOffset, .firstInstance = instanceIndex };
+    }
+}
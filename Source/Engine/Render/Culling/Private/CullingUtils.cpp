@@ -0,0 +1,47 @@
+#include "Engine/Render/Culling/CullingUtils.hpp"
+
+#include "Utils/Math.hpp"
+
+Sphere CullingUtils::GetWorldSphere(const gpu::Draw& draw, const gpu::PrimitiveBounds& bounds)
+{
+    const glm::vec3 center = Math::UnpackQuatSmallestThree(draw.rotation) * bounds.center * draw.scale + draw.position;
+
+    return { .center = center, .radius = bounds.radius * draw.scale };
+}
+
+bool CullingUtils::FrustumCull(const gpu::CullData& cullData, const glm::vec3& center, const float radius)
+{
+    bool culled = cullData.frustumRightX * std::abs(center.x) + cullData.frustumRightZ * center.z < -radius;
+    culled = culled || cullData.frustumTopY * std::abs(center.y) + cullData.frustumTopZ * center.z < -radius;
+    culled = culled || center.z - radius > -cullData.near;
+
+    return culled;
+}
+
+std::optional<glm::vec4> CullingUtils::SphereNdcExtents(const glm::vec3& center, const float radius, const float p00,
+    const float p11, const float near)
+{
+    if (center.z + radius > -near)
+    {
+        return std::nullopt;
+    }
+
+    const float rad2 = radius * radius;
+    const float d = -center.z * radius;
+
+    const float hv = std::sqrt(center.x * center.x + center.z * center.z - rad2);
+    const float ha = center.x * hv;
+    const float hb = center.x * radius;
+    const float hc = -center.z * hv;
+
+    const float vv = std::sqrt(center.y * center.y + center.z * center.z - rad2);
+    const float va = center.y * vv;
+    const float vb = center.y * radius;
+    const float vc = -center.z * vv;
+
+    return glm::vec4(
+        (ha - d) * p00 / (hc + hb), // left
+        (va - d) * -p11 / (vc + vb), // bottom
+        (ha + d) * p00 / (hc - hb), // right
+        (va + d) * -p11 / (vc - vb)); // top
+}
@@ -0,0 +1,213 @@
+#include "Engine/Render/Culling/OcclusionRasterizer.hpp"
+
+#include "Engine/Render/Culling/SimdFloats.hpp"
+#include "Engine/Render/Culling/CullingUtils.hpp"
+
+namespace OcclusionRasterizerDetails
+{
+    using namespace Simd;
+
+    // Pixel centers of the lanes relative to the first pixel of a SIMD block
+    static constexpr std::array<float, maxWidth> laneCenters = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+
+    static constexpr float minTriangleArea = 1e-4f; // In pixels, also skips degenerate triangles
+
+    // Edge function e(p) = x * p.x + y * p.y + z, inside of the triangle with positive area it's positive for every edge
+    static glm::vec3 GetEdgeFunction(const glm::vec3& from, const glm::vec3& to)
+    {
+        const float x = from.y - to.y;
+        const float y = to.x - from.x;
+
+        return { x, y, -(x * from.x + y * from.y) };
+    }
+}
+
+OcclusionRasterizer::OcclusionRasterizer(const uint32_t aWidth, const uint32_t aHeight)
+    : width{ aWidth }
+    , height{ aHeight }
+{
+    Assert(width > 0 && height > 0 && width % tileSize == 0 && height % tileSize == 0);
+
+    depth.resize(static_cast<size_t>(width) * height, 0.0f);
+    tileDepth.resize(static_cast<size_t>(width / tileSize) * (height / tileSize), 0.0f);
+}
+
+void OcclusionRasterizer::Begin(const glm::mat4& aView, const glm::mat4& projection, const float aNear)
+{
+    view = aView;
+    p00 = projection[0][0];
+    p11 = projection[1][1];
+    near = aNear;
+
+    std::ranges::fill(depth, 0.0f);
+}
+
+void OcclusionRasterizer::RasterizeTriangles(const glm::mat4& transform, const std::span<const gpu::Vertex> vertices,
+    const std::span<const uint32_t> indices)
+{
+    const glm::mat4 modelView = view * transform;
+
+    const float halfWidth = 0.5f * static_cast<float>(width);
+    const float halfHeight = 0.5f * static_cast<float>(height);
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<glm::vec3, 3> screenVertices;
+        bool crossesNearPlane = false;
+
+        for (uint32_t j = 0; j < 3 && !crossesNearPlane; ++j)
+        {
+            const glm::vec4 viewPosition = modelView * glm::vec4(glm::vec3(vertices[indices[i + j]].posAndU), 1.0f);
+            const float w = -viewPosition.z;
+
+            crossesNearPlane = w < near;
+
+            // Same NDC as sphereNdcExtents() (Y up) mapped to pixels like ndcToUv() (rows go down)
+            const float inverseW = 1.0f / w;
+            screenVertices[j] = glm::vec3((1.0f + p00 * viewPosition.x * inverseW) * halfWidth,
+                (1.0f + p11 * viewPosition.y * inverseW) * halfHeight, inverseW);
+        }
+
+        if (!crossesNearPlane)
+        {
+            RasterizeTriangle(screenVertices[0], screenVertices[1], screenVertices[2]);
+        }
+    }
+}
+
+void OcclusionRasterizer::End()
+{
+    const uint32_t tileColumns = width / tileSize;
+    const uint32_t tileRows = height / tileSize;
+
+    for (uint32_t tileY = 0; tileY < tileRows; ++tileY)
+    {
+        for (uint32_t tileX = 0; tileX < tileColumns; ++tileX)
+        {
+            float farthestDepth = std::numeric_limits<float>::max();
+
+            for (uint32_t y = tileY * tileSize; y < (tileY + 1) * tileSize; ++y)
+            {
+                const auto rowBegin = depth.begin() + static_cast<ptrdiff_t>(y * width + tileX * tileSize);
+                farthestDepth = std::min(farthestDepth, *std::min_element(rowBegin, rowBegin + tileSize));
+            }
+
+            tileDepth[tileY * tileColumns + tileX] = farthestDepth;
+        }
+    }
+}
+
+bool OcclusionRasterizer::IsOccluded(const glm::vec3& center, const float radius) const
+{
+    const std::optional<glm::vec4> lbrt = CullingUtils::SphereNdcExtents(center, radius, p00, p11, near);
+
+    if (!lbrt || lbrt->z < -1.0f || lbrt->x > 1.0f || lbrt->w < -1.0f || lbrt->y > 1.0f)
+    {
+        return false; // Crosses near plane or is outside of the screen, frustum culling takes care of the latter
+    }
+
+    const auto tileColumns = static_cast<int32_t>(width / tileSize);
+    const auto tileRows = static_cast<int32_t>(height / tileSize);
+
+    const auto toTile = [](const float ndc, const int32_t tileCount) {
+        return std::clamp(static_cast<int32_t>((ndc * 0.5f + 0.5f) * static_cast<float>(tileCount)), 0, tileCount - 1);
+    };
+
+    const int32_t minTileX = toTile(lbrt->x, tileColumns);
+    const int32_t maxTileX = toTile(lbrt->z, tileColumns);
+    const int32_t minTileY = toTile(-lbrt->w, tileRows); // Rows go down
+    const int32_t maxTileY = toTile(-lbrt->y, tileRows);
+
+    const float closestDepth = 1.0f / (-center.z - radius);
+
+    for (int32_t tileY = minTileY; tileY <= maxTileY; ++tileY)
+    {
+        for (int32_t tileX = minTileX; tileX <= maxTileX; ++tileX)
+        {
+            if (tileDepth[tileY * tileColumns + tileX] <= closestDepth)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void OcclusionRasterizer::RasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+{
+    using namespace OcclusionRasterizerDetails;
+
+    glm::vec3 a = v0;
+    glm::vec3 b = v1;
+    glm::vec3 c = v2;
+
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+    if (std::abs(area) < minTriangleArea)
+    {
+        return;
+    }
+
+    if (area < 0.0f) // Back faces occlude too, so both windings are rasterized
+    {
+        std::swap(b, c);
+        area = -area;
+    }
+
+    const int32_t minX = std::max(static_cast<int32_t>(std::floor(std::min({ a.x, b.x, c.x }))), 0);
+    const int32_t minY = std::max(static_cast<int32_t>(std::floor(std::min({ a.y, b.y, c.y }))), 0);
+    const int32_t maxX = std::min(static_cast<int32_t>(std::ceil(std::max({ a.x, b.x, c.x }))), static_cast<int32_t>(width));
+    const int32_t maxY = std::min(static_cast<int32_t>(std::ceil(std::max({ a.y, b.y, c.y }))), static_cast<int32_t>(height));
+
+    if (minX >= maxX || minY >= maxY)
+    {
+        return;
+    }
+
+    // Edge functions are barycentrics of the opposite vertices scaled by area, so they interpolate 1 / w
+    const glm::vec3 edgeA = GetEdgeFunction(b, c);
+    const glm::vec3 edgeB = GetEdgeFunction(c, a);
+    const glm::vec3 edgeC = GetEdgeFunction(a, b);
+    const glm::vec3 depthPlane = (edgeA * a.z + edgeB * b.z + edgeC * c.z) / area;
+
+    const Floats zero = Floats::Splat(0.0f);
+    const Floats laneX = Floats::Load(laneCenters.data());
+
+    const Floats edgeAX = Floats::Splat(edgeA.x);
+    const Floats edgeBX = Floats::Splat(edgeB.x);
+    const Floats edgeCX = Floats::Splat(edgeC.x);
+    const Floats depthX = Floats::Splat(depthPlane.x);
+
+    // Blocks are aligned to SIMD width, which divides the buffer width, so they never cross rows
+    const int32_t firstBlockX = minX / static_cast<int32_t>(Floats::width) * static_cast<int32_t>(Floats::width);
+
+    for (int32_t y = minY; y < maxY; ++y)
+    {
+        const float pixelY = static_cast<float>(y) + 0.5f;
+        float* row = depth.data() + static_cast<size_t>(y) * width;
+
+        const Floats rowEdgeA = Floats::Splat(edgeA.y * pixelY + edgeA.z);
+        const Floats rowEdgeB = Floats::Splat(edgeB.y * pixelY + edgeB.z);
+        const Floats rowEdgeC = Floats::Splat(edgeC.y * pixelY + edgeC.z);
+        const Floats rowDepth = Floats::Splat(depthPlane.y * pixelY + depthPlane.z);
+
+        for (int32_t blockX = firstBlockX; blockX < maxX; blockX += static_cast<int32_t>(Floats::width))
+        {
+            const Floats pixelX = Floats::Splat(static_cast<float>(blockX)) + laneX;
+
+            const Mask inside = (edgeAX * pixelX + rowEdgeA >= zero) & (edgeBX * pixelX + rowEdgeB >= zero)
+                & (edgeCX * pixelX + rowEdgeC >= zero);
+
+            if (ToBits(inside) == 0)
+            {
+                continue;
+            }
+
+            const Floats currentDepth = Floats::Load(row + blockX);
+            const Floats triangleDepth = depthX * pixelX + rowDepth;
+
+            Select(inside, Max(currentDepth, triangleDepth), currentDepth).Store(row + blockX);
+        }
+    }
+}
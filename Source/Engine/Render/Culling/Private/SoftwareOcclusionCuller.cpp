@@ -0,0 +1,147 @@
+#include "Engine/Render/Culling/SoftwareOcclusionCuller.hpp"
+
+#include "Utils/Math.hpp"
+#include "Engine/EngineConfig.hpp"
+#include "Engine/Render/Culling/CullingUtils.hpp"
+
+namespace SoftwareOcclusionCullerDetails
+{
+    static constexpr size_t chunkSize = 16384; // Draws or clusters per thread pool job
+
+    static glm::mat4 ComposeTransform(const gpu::Draw& draw)
+    {
+        glm::mat4 transform = glm::mat4_cast(Math::UnpackQuatSmallestThree(draw.rotation)) * draw.scale;
+        transform[3] = glm::vec4(draw.position, 1.0f);
+
+        return transform;
+    }
+
+    static glm::vec3 GetViewCenter(const gpu::CullData& cullData, const glm::vec3& worldCenter)
+    {
+        return glm::vec3(cullData.view * glm::vec4(worldCenter, 1.0f));
+    }
+}
+
+SoftwareOcclusionCuller::SoftwareOcclusionCuller(ThreadPool& aThreadPool, const RawScene& aRawScene,
+    const std::span<const gpu::Draw> aDraws, const std::span<const gpu::DrawCluster> aDrawClusters)
+    : threadPool{ &aThreadPool }
+    , rawScene{ &aRawScene }
+    , draws{ aDraws }
+    , drawClusters{ aDrawClusters }
+    , rasterizer{ EngineConfig::softwareOcclusionWidth, EngineConfig::softwareOcclusionHeight }
+{}
+
+void SoftwareOcclusionCuller::Cull(const gpu::PushConstants& globals, const std::span<uint32_t> drawsVisibility,
+    const std::span<uint32_t> clusterVisibility)
+{
+    using namespace SoftwareOcclusionCullerDetails;
+
+    const gpu::CullData& cullData = globals.cullData;
+
+    const size_t drawCount = std::min(static_cast<size_t>(globals.drawCount), draws.size());
+    const size_t clusterCount = std::min(static_cast<size_t>(globals.clusterCount), drawClusters.size());
+    Assert(drawsVisibility.size() >= drawCount && clusterVisibility.size() >= clusterCount);
+
+    chunkOccluders.resize((drawCount + chunkSize - 1) / chunkSize);
+
+    // Frustum culling, draws in the frustum big enough on screen are occluder candidates
+    threadPool->ParallelFor(drawCount, chunkSize, [&](const size_t begin, const size_t end) {
+        std::vector<Occluder>& candidates = chunkOccluders[begin / chunkSize];
+        candidates.clear();
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const gpu::Draw& draw = draws[i];
+            const Sphere sphere = CullingUtils::GetWorldSphere(draw, rawScene->primitiveBounds[draw.primitiveIndex]);
+            const glm::vec3 center = GetViewCenter(cullData, sphere.center);
+
+            const bool culled = CullingUtils::FrustumCull(cullData, center, sphere.radius);
+            drawsVisibility[i] = culled ? 0 : 1;
+
+            // Occluders crossing the near plane are mostly skipped by the rasterizer anyway
+            if (!culled && -center.z - sphere.radius > cullData.near)
+            {
+                const float screenSize = sphere.radius / -center.z;
+
+                if (screenSize >= EngineConfig::minSoftwareOccluderSize)
+                {
+                    candidates.push_back({ .screenSize = screenSize, .drawIndex = static_cast<uint32_t>(i) });
+                }
+            }
+        }
+    });
+
+    RasterizeOccluders(globals);
+
+    threadPool->ParallelFor(drawCount, chunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (drawsVisibility[i] == 0)
+            {
+                continue;
+            }
+
+            const gpu::Draw& draw = draws[i];
+            const Sphere sphere = CullingUtils::GetWorldSphere(draw, rawScene->primitiveBounds[draw.primitiveIndex]);
+
+            if (rasterizer.IsOccluded(GetViewCenter(cullData, sphere.center), sphere.radius))
+            {
+                drawsVisibility[i] = 0;
+            }
+        }
+    });
+
+    threadPool->ParallelFor(clusterCount, chunkSize, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const gpu::DrawCluster& cluster = drawClusters[i];
+            const glm::vec3 center = GetViewCenter(cullData, cluster.center);
+
+            const bool culled = CullingUtils::FrustumCull(cullData, center, cluster.radius)
+                || rasterizer.IsOccluded(center, cluster.radius);
+
+            clusterVisibility[i] = culled ? 0 : 1;
+        }
+    });
+}
+
+void SoftwareOcclusionCuller::RasterizeOccluders(const gpu::PushConstants& globals)
+{
+    using namespace SoftwareOcclusionCullerDetails;
+
+    occluders.clear();
+
+    for (const std::vector<Occluder>& candidates : chunkOccluders)
+    {
+        occluders.insert(occluders.end(), candidates.begin(), candidates.end());
+    }
+
+    const auto isBigger = [](const Occluder& a, const Occluder& b) { return a.screenSize > b.screenSize; };
+
+    if (occluders.size() > EngineConfig::maxSoftwareOccluderCount)
+    {
+        const auto last = occluders.begin() + static_cast<ptrdiff_t>(EngineConfig::maxSoftwareOccluderCount);
+        std::ranges::nth_element(occluders, last, isBigger);
+        occluders.erase(last, occluders.end());
+    }
+
+    const std::span<const gpu::Vertex> vertices = rawScene->vertices;
+    const std::span<const uint32_t> indices = rawScene->indices;
+
+    rasterizer.Begin(globals.cullData.view, globals.projection, globals.cullData.near);
+
+    for (const Occluder& occluder : occluders)
+    {
+        const gpu::Draw& draw = draws[occluder.drawIndex];
+        const gpu::Primitive& primitive = rawScene->primitives[draw.primitiveIndex];
+
+        // Coarsest LOD stays close to the silhouette of the mesh, but isn't conservative, so occlusion is approximate
+        // until the second GPU pass tests everything against the real depth
+        const gpu::Lod& lod = primitive.lods[primitive.lodCount - 1];
+
+        rasterizer.RasterizeTriangles(ComposeTransform(draw), vertices.subspan(primitive.vertexOffset),
+            indices.subspan(lod.indexOffset, lod.indexCount));
+    }
+
+    rasterizer.End();
+}
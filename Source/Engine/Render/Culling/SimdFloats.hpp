@@ -0,0 +1,167 @@
+#pragma once
+
+#if defined(__AVX__) // Also enabled by AVX2 builds, kernels need only 8-wide float math
+    #include <immintrin.h>
+    #define SIMD_FLOATS_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define SIMD_FLOATS_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define SIMD_FLOATS_NEON 1
+#endif
+
+// Minimal wrappers over SIMD registers, so CPU culling kernels are written once for every instruction set
+namespace Simd
+{
+    constexpr uint32_t maxWidth = 8; // Data processed by the kernels is padded to it
+
+#if SIMD_FLOATS_AVX
+    struct Mask
+    {
+        __m256 value;
+    };
+
+    struct Floats
+    {
+        static constexpr uint32_t width = 8;
+
+        static Floats Load(const float* data) { return { _mm256_loadu_ps(data) }; }
+        static Floats Splat(const float value) { return { _mm256_set1_ps(value) }; }
+
+        void Store(float* data) const { _mm256_storeu_ps(data, value); }
+
+        __m256 value;
+    };
+
+    inline Floats operator+(const Floats a, const Floats b) { return { _mm256_add_ps(a.value, b.value) }; }
+    inline Floats operator-(const Floats a, const Floats b) { return { _mm256_sub_ps(a.value, b.value) }; }
+    inline Floats operator*(const Floats a, const Floats b) { return { _mm256_mul_ps(a.value, b.value) }; }
+    inline Floats operator/(const Floats a, const Floats b) { return { _mm256_div_ps(a.value, b.value) }; }
+    inline Floats Abs(const Floats a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.value) }; }
+    inline Floats Max(const Floats a, const Floats b) { return { _mm256_max_ps(a.value, b.value) }; }
+    inline Floats Sqrt(const Floats a) { return { _mm256_sqrt_ps(a.value) }; }
+    inline Floats Select(const Mask mask, const Floats a, const Floats b) { return { _mm256_blendv_ps(b.value, a.value, mask.value) }; }
+
+    inline Mask operator<(const Floats a, const Floats b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ) }; }
+    inline Mask operator>(const Floats a, const Floats b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ) }; }
+    inline Mask operator>=(const Floats a, const Floats b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_GE_OQ) }; }
+    inline Mask operator|(const Mask a, const Mask b) { return { _mm256_or_ps(a.value, b.value) }; }
+    inline Mask operator&(const Mask a, const Mask b) { return { _mm256_and_ps(a.value, b.value) }; }
+    inline Mask AndNot(const Mask a, const Mask b) { return { _mm256_andnot_ps(b.value, a.value) }; }
+    inline uint32_t ToBits(const Mask a) { return static_cast<uint32_t>(_mm256_movemask_ps(a.value)); }
+#elif SIMD_FLOATS_SSE
+    struct Mask
+    {
+        __m128 value;
+    };
+
+    struct Floats
+    {
+        static constexpr uint32_t width = 4;
+
+        static Floats Load(const float* data) { return { _mm_loadu_ps(data) }; }
+        static Floats Splat(const float value) { return { _mm_set1_ps(value) }; }
+
+        void Store(float* data) const { _mm_storeu_ps(data, value); }
+
+        __m128 value;
+    };
+
+    inline Floats operator+(const Floats a, const Floats b) { return { _mm_add_ps(a.value, b.value) }; }
+    inline Floats operator-(const Floats a, const Floats b) { return { _mm_sub_ps(a.value, b.value) }; }
+    inline Floats operator*(const Floats a, const Floats b) { return { _mm_mul_ps(a.value, b.value) }; }
+    inline Floats operator/(const Floats a, const Floats b) { return { _mm_div_ps(a.value, b.value) }; }
+    inline Floats Abs(const Floats a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.value) }; }
+    inline Floats Max(const Floats a, const Floats b) { return { _mm_max_ps(a.value, b.value) }; }
+    inline Floats Sqrt(const Floats a) { return { _mm_sqrt_ps(a.value) }; }
+
+    inline Floats Select(const Mask mask, const Floats a, const Floats b) // No blendv before SSE4.1
+    {
+        return { _mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value)) };
+    }
+
+    inline Mask operator<(const Floats a, const Floats b) { return { _mm_cmplt_ps(a.value, b.value) }; }
+    inline Mask operator>(const Floats a, const Floats b) { return { _mm_cmpgt_ps(a.value, b.value) }; }
+    inline Mask operator>=(const Floats a, const Floats b) { return { _mm_cmpge_ps(a.value, b.value) }; }
+    inline Mask operator|(const Mask a, const Mask b) { return { _mm_or_ps(a.value, b.value) }; }
+    inline Mask operator&(const Mask a, const Mask b) { return { _mm_and_ps(a.value, b.value) }; }
+    inline Mask AndNot(const Mask a, const Mask b) { return { _mm_andnot_ps(b.value, a.value) }; }
+    inline uint32_t ToBits(const Mask a) { return static_cast<uint32_t>(_mm_movemask_ps(a.value)); }
+#elif SIMD_FLOATS_NEON
+    struct Mask
+    {
+        uint32x4_t value;
+    };
+
+    struct Floats
+    {
+        static constexpr uint32_t width = 4;
+
+        static Floats Load(const float* data) { return { vld1q_f32(data) }; }
+        static Floats Splat(const float value) { return { vdupq_n_f32(value) }; }
+
+        void Store(float* data) const { vst1q_f32(data, value); }
+
+        float32x4_t value;
+    };
+
+    inline Floats operator+(const Floats a, const Floats b) { return { vaddq_f32(a.value, b.value) }; }
+    inline Floats operator-(const Floats a, const Floats b) { return { vsubq_f32(a.value, b.value) }; }
+    inline Floats operator*(const Floats a, const Floats b) { return { vmulq_f32(a.value, b.value) }; }
+    inline Floats operator/(const Floats a, const Floats b) { return { vdivq_f32(a.value, b.value) }; }
+    inline Floats Abs(const Floats a) { return { vabsq_f32(a.value) }; }
+    inline Floats Max(const Floats a, const Floats b) { return { vmaxq_f32(a.value, b.value) }; }
+    inline Floats Sqrt(const Floats a) { return { vsqrtq_f32(a.value) }; }
+    inline Floats Select(const Mask mask, const Floats a, const Floats b) { return { vbslq_f32(mask.value, a.value, b.value) }; }
+
+    inline Mask operator<(const Floats a, const Floats b) { return { vcltq_f32(a.value, b.value) }; }
+    inline Mask operator>(const Floats a, const Floats b) { return { vcgtq_f32(a.value, b.value) }; }
+    inline Mask operator>=(const Floats a, const Floats b) { return { vcgeq_f32(a.value, b.value) }; }
+    inline Mask operator|(const Mask a, const Mask b) { return { vorrq_u32(a.value, b.value) }; }
+    inline Mask operator&(const Mask a, const Mask b) { return { vandq_u32(a.value, b.value) }; }
+    inline Mask AndNot(const Mask a, const Mask b) { return { vbicq_u32(a.value, b.value) }; }
+
+    inline uint32_t ToBits(const Mask a)
+    {
+        const uint32x4_t laneBits = { 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(a.value, laneBits));
+    }
+#else
+    struct Mask
+    {
+        bool value;
+    };
+
+    struct Floats
+    {
+        static constexpr uint32_t width = 1;
+
+        static Floats Load(const float* data) { return { *data }; }
+        static Floats Splat(const float value) { return { value }; }
+
+        void Store(float* data) const { *data = value; }
+
+        float value;
+    };
+
+    inline Floats operator+(const Floats a, const Floats b) { return { a.value + b.value }; }
+    inline Floats operator-(const Floats a, const Floats b) { return { a.value - b.value }; }
+    inline Floats operator*(const Floats a, const Floats b) { return { a.value * b.value }; }
+    inline Floats operator/(const Floats a, const Floats b) { return { a.value / b.value }; }
+    inline Floats Abs(const Floats a) { return { std::abs(a.value) }; }
+    inline Floats Max(const Floats a, const Floats b) { return { std::max(a.value, b.value) }; }
+    inline Floats Sqrt(const Floats a) { return { std::sqrt(a.value) }; }
+    inline Floats Select(const Mask mask, const Floats a, const Floats b) { return mask.value ? a : b; }
+
+    inline Mask operator<(const Floats a, const Floats b) { return { a.value < b.value }; }
+    inline Mask operator>(const Floats a, const Floats b) { return { a.value > b.value }; }
+    inline Mask operator>=(const Floats a, const Floats b) { return { a.value >= b.value }; }
+    inline Mask operator|(const Mask a, const Mask b) { return { a.value || b.value }; }
+    inline Mask operator&(const Mask a, const Mask b) { return { a.value && b.value }; }
+    inline Mask AndNot(const Mask a, const Mask b) { return { a.value && !b.value }; }
+    inline uint32_t ToBits(const Mask a) { return a.value ? 1 : 0; }
+#endif
+
+    static_assert(maxWidth % Floats::width == 0);
+}
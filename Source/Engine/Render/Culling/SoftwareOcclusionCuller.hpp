@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Engine/Render/Culling/OcclusionRasterizer.hpp"
+#include "Engine/Scene/SceneDataStructures.hpp"
+#include "Utils/ThreadPool.hpp"
+
+// Occlusion culling on CPU for frames without usable visibility of the previous frame (camera cuts)
+// Largest draws on screen in the frustum are chosen as occluders and rasterized with their coarsest LOD into
+// a low resolution depth buffer, then all draws and draw clusters are tested against its tiles
+// Results are in the format of draws and cluster visibility buffers (1 is visible), so they can seed the first GPU pass
+// Scene and draws are referenced, not copied, so they must outlive the culler
+class SoftwareOcclusionCuller
+{
+public:
+    SoftwareOcclusionCuller(ThreadPool& threadPool, const RawScene& rawScene, std::span<const gpu::Draw> draws,
+        std::span<const gpu::DrawCluster> drawClusters);
+
+    // Writes visibility of first globals.drawCount draws and all draw clusters with globals.cullData
+    void Cull(const gpu::PushConstants& globals, std::span<uint32_t> drawsVisibility, std::span<uint32_t> clusterVisibility);
+
+private:
+    struct Occluder
+    {
+        float screenSize = 0.0f;
+        uint32_t drawIndex = 0;
+    };
+
+    void RasterizeOccluders(const gpu::PushConstants& globals);
+
+    ThreadPool* threadPool = nullptr;
+    const RawScene* rawScene = nullptr;
+
+    std::span<const gpu::Draw> draws;
+    std::span<const gpu::DrawCluster> drawClusters;
+
+    OcclusionRasterizer rasterizer;
+
+    std::vector<std::vector<Occluder>> chunkOccluders; // Candidates found by each chunk, reused between passes
+    std::vector<Occluder> occluders;
+};
@@ -6,6 +6,9 @@
 class VulkanContext;
 class EventSystem;
 class PrimitiveCullStage;
+class LightCullStage;
+class SoftwareRasterStage;
+class ImpostorStage;
 class RenderStage;
 class Scene;
 
@@ -29,9 +32,13 @@ public:
     void Process(const Frame& frame, float deltaSeconds) override;
 
     void Render(const Frame& frame) override;
+    
+    void GatherFrameStats(const Frame& frame, FrameRenderStats& renderStats) override;
 
 private:
     void RenderWithOcclusionCulling(const Frame& frame);
+    void ResolveVisibility(const Frame& frame); // Shades the visibility buffer and draws debug objects over it
+    void Upscale(const Frame& frame) const; // Dynamic resolution: blits rendered part of scene color into swapchain
     
     void InitRuntimeDefineGetters();
     
@@ -59,10 +66,20 @@ private:
     RenderContext renderContext;
 
     std::unique_ptr<PrimitiveCullStage> primitiveCullStage;
+    std::unique_ptr<LightCullStage> lightCullStage;
     std::unique_ptr<RenderStage> forwardStage;
+    std::unique_ptr<SoftwareRasterStage> softwareRasterStage;
+    std::unique_ptr<ImpostorStage> impostorStage;
     std::unique_ptr<RenderStage> debugStage;
+    std::unique_ptr<RenderStage> visibilityResolveStage;
     
     std::vector<RenderStage*> renderStages;
 
     Scene* scene = nullptr;
+    
+    bool requiredPipelinesBuilt = true; // Scene isn't rendered until they are, see OnTryReloadShaders
+    
+    gpu::SceneCopyParams sceneCopyParams = {}; // Test lights orbit the scene copies
+    std::vector<glm::vec4> sceneCopyTranslations;
+    float lightTimeSeconds = 0.0f; // Animates test lights
 };
@@ -1,8 +1,11 @@
 #include "Engine/Render/ForwardRenderer.hpp"
 
 #include "Utils/Math.hpp"
+#include "Utils/Helpers.hpp"
 #include "Engine/EventSystem.hpp"
+#include "Engine/EngineConfig.hpp"
 #include "Engine/Scene/SceneHelpers.hpp"
+#include "Shaders/Scene/SceneCopy.h"
 #include "Engine/Render/RenderOptions.hpp"
 #include "Engine/Render/Utils/MeshUtils.hpp"
 #include "Engine/Render/Utils/ForwardUtils.hpp"
@@ -11,52 +14,339 @@
 #include "Engine/Render/RenderStages/DebugStage.hpp"
 #include "Engine/Render/Vulkan/Image/ImageUtils.hpp"
 #include "Engine/Render/Vulkan/Buffer/BufferUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/ComputePipelineBuilder.hpp"
 #include "Engine/Render/RenderStages/ForwardStage.hpp"
+#include "Engine/Render/RenderStages/ImpostorStage.hpp"
+#include "Engine/Render/RenderStages/LightCullStage.hpp"
 #include "Engine/Render/RenderStages/PrimitiveCullStage.hpp"
+#include "Engine/Render/RenderStages/SoftwareRasterStage.hpp"
+#include "Engine/Render/RenderStages/VisibilityResolveStage.hpp"
 
 namespace ForwardRendererDetails
 {
-    static void SetSceneStats(const RawScene& rawScene, const std::vector<gpu::Draw>& draws)
+    static constexpr std::string_view randomlyCopySceneShaderPath = "~/Shaders/Scene/RandomlyCopyScene.comp";
+    
+    static void SetSceneStats(const RawScene& rawScene, const std::vector<gpu::Draw>& sceneDraws, const uint32_t copyCount)
     {
         uint64_t totalTriangles = 0;
 
-        for (const gpu::Draw& draw : draws)
+        for (const gpu::Draw& draw : sceneDraws)
         {
             totalTriangles += rawScene.primitives[draw.primitiveIndex].lods[0].indexCount / 3;
         }
 
-        Scene::SetTotalTriangles(totalTriangles);
+        Scene::SetTotalTriangles(totalTriangles * copyCount);
+    }
+
+    // Upper bound of task commands culling can emit: every draw at its LOD with the most meshlets
+    static size_t CalculateMaxTaskCommandCount(const RawScene& rawScene, const std::vector<gpu::Draw>& sceneDraws,
+        const uint32_t copyCount)
+    {
+        std::vector<size_t> primitiveTaskCommandCounts(rawScene.primitives.size(), 0);
+
+        for (size_t i = 0; i < rawScene.primitives.size(); ++i)
+        {
+            const gpu::Primitive& primitive = rawScene.primitives[i];
+
+            for (uint32_t lodIndex = 0; lodIndex < primitive.lodCount; ++lodIndex)
+            {
+                const size_t taskCommandCount = PipelineUtils::GroupCount(primitive.lods[lodIndex].meshletCount, gpu::taskWgSize);
+                primitiveTaskCommandCounts[i] = std::max(primitiveTaskCommandCounts[i], taskCommandCount);
+            }
+        }
+
+        size_t maxTaskCommandCount = 0;
+
+        for (const gpu::Draw& draw : sceneDraws)
+        {
+            maxTaskCommandCount += primitiveTaskCommandCounts[draw.primitiveIndex];
+        }
+
+        return maxTaskCommandCount * copyCount;
     }
 
-    static void CreateIndirectBuffers(RenderContext& renderContext, const VulkanContext& vulkanContext)
+    // Upper bound of triangle indices meshlet culling can emit: every draw at its most detailed LOD
+    static size_t CalculateMaxMeshletIndexCount(const RawScene& rawScene, const std::vector<gpu::Draw>& sceneDraws,
+        const uint32_t copyCount)
     {
-        const bool meshShadersSupported = vulkanContext.GetDevice().GetProperties().meshShadersSupported;
+        size_t maxIndexCount = 0;
 
-        const size_t largeEnoughCommandBuffer = gpu::primitiveCullMaxCommands * (meshShadersSupported
-            ? std::max(sizeof(gpu::VkDrawIndexedIndirectCommand), sizeof(gpu::TaskCommand))
-            : sizeof(gpu::VkDrawIndexedIndirectCommand));
+        for (const gpu::Draw& draw : sceneDraws)
+        {
+            maxIndexCount += rawScene.primitives[draw.primitiveIndex].lods[0].indexCount;
+        }
 
-        constexpr std::array<uint32_t, 3> commandCountValues = { 0, 1, 1 };
-        const std::span commandCountSpan(commandCountValues);
+        return maxIndexCount * copyCount;
+    }
+
+    static void CreateIndirectBuffers(const RawScene& rawScene, const std::vector<gpu::Draw>& sceneDraws,
+        const uint32_t copyCount, RenderContext& renderContext, const VulkanContext& vulkanContext)
+    {
+        // Vertex pipeline emits at most 1 command per draw or 1 per (primitive, LOD) bucket with instanced draws
+        const size_t maxIndirectCommandCount = std::max(sceneDraws.size() * copyCount,
+            rawScene.primitives.size() * gpu::maxLodCount);
+        
+        size_t commandBufferSize = maxIndirectCommandCount * sizeof(gpu::VkDrawIndexedIndirectCommand);
+        size_t maxDrawChunkCount = PipelineUtils::GroupCount(static_cast<uint32_t>(maxIndirectCommandCount),
+            ForwardUtils::GetDrawChunkSize(vulkanContext));
+        
+        const DeviceProperties& deviceProperties = vulkanContext.GetDevice().GetProperties();
+        
+        // Task commands are emitted by the mesh pipeline and by meshlet culling of the vertex pipeline
+        const size_t maxTaskCommandCount = rawScene.meshlets.empty() ? 0 : std::min(
+            CalculateMaxTaskCommandCount(rawScene, sceneDraws, copyCount),
+            EngineConfig::maxTaskCommandBufferSize / sizeof(gpu::TaskCommand));
+        
+        if (!rawScene.meshlets.empty())
+        {
+            commandBufferSize = std::max(commandBufferSize, maxTaskCommandCount * sizeof(gpu::TaskCommand));
+            
+            if (deviceProperties.meshShadersSupported)
+            {
+                maxDrawChunkCount = std::max(maxDrawChunkCount, static_cast<size_t>(PipelineUtils::GroupCount(
+                    static_cast<uint32_t>(maxTaskCommandCount), ForwardUtils::GetTaskChunkSize(vulkanContext))));
+            }
+        }
+        
+        // Meshlets are generated without mesh shaders only for meshlet culling, see ForwardRenderer::OnSceneOpen
+        if (!rawScene.meshlets.empty() && deviceProperties.drawIndirectCountSupported)
+        {
+            // MeshletCull.comp emits at most 1 command per stored task command
+            const size_t meshletCommandCapacity = std::min(maxTaskCommandCount,
+                EngineConfig::maxMeshletCommandBufferSize / sizeof(gpu::VkDrawIndexedIndirectCommand));
+            const size_t meshletIndexCapacity = std::min(CalculateMaxMeshletIndexCount(rawScene, sceneDraws, copyCount),
+                EngineConfig::maxMeshletIndexBufferSize / sizeof(uint32_t));
+            
+            maxDrawChunkCount = std::max(maxDrawChunkCount, static_cast<size_t>(PipelineUtils::GroupCount(
+                static_cast<uint32_t>(meshletCommandCapacity), ForwardUtils::GetDrawChunkSize(vulkanContext))));
+            
+            // Header is reset by every culling pass, see PrimitiveCullStage
+            const BufferDescription meshletDrawBufferDescription = {
+                .size = sizeof(gpu::MeshletDraws) + meshletCommandCapacity * sizeof(gpu::VkDrawIndexedIndirectCommand),
+                .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+            
+            renderContext.meshletDrawBuffer = Buffer(meshletDrawBufferDescription, false, vulkanContext);
+            
+            const BufferDescription meshletIndexBufferDescription = {
+                .size = std::max(meshletIndexCapacity, size_t{ 1 }) * sizeof(uint32_t),
+                .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+            
+            renderContext.meshletIndexBuffer = Buffer(meshletIndexBufferDescription, false, vulkanContext);
+        }
+
+        constexpr uint32_t zeroCommandCount = 0;
+        const std::span commandCountSpan(&zeroCommandCount, 1);
 
-        // We use it as buffer for vkCmdDrawMeshTasksIndirectEXT, so let's just always allocate 2 more uint32_t values
-        // and set to them to 1 once on initialization bc we have 1-dimensional dispatch for tasks anyway
         const BufferDescription commandCountBufferDescription = {
             .size = commandCountSpan.size_bytes(),
-            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
 
         renderContext.commandCountBuffer = Buffer(commandCountBufferDescription, true, commandCountSpan, vulkanContext);
 
         const BufferDescription commandBufferDescription = {
-            .size = largeEnoughCommandBuffer,
-            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .size = commandBufferSize,
+            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
 
         renderContext.commandBuffer = Buffer(commandBufferDescription, false, vulkanContext);
+        
+        // Chunk count, then either mesh tasks command or command count per chunk, see DrawChunks.comp
+        const BufferDescription drawChunkBufferDescription = {
+            .size = sizeof(uint32_t) + maxDrawChunkCount * sizeof(gpu::VkDrawMeshTasksIndirectCommandEXT),
+            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.drawChunkBuffer = Buffer(drawChunkBufferDescription, false, vulkanContext);
+    }
+
+    // Test views for multi-view culling: culling camera turned around its view space Y axis by equal angles
+    static void GenerateTestExtraViews(const uint32_t viewCount, RenderContext& renderContext)
+    {
+        const gpu::PushConstants& globals = renderContext.globals;
+        const glm::vec3 position(glm::inverse(globals.cullData.view)[3]);
+        
+        renderContext.extraViews.resize(viewCount);
+        
+        for (uint32_t i = 0; i < viewCount; ++i)
+        {
+            const float angle = 2.0f * std::numbers::pi_v<float> * static_cast<float>(i + 1) / static_cast<float>(viewCount + 1);
+            const glm::mat4 view = glm::mat4_cast(glm::angleAxis(angle, Vector3::unitY)) * globals.cullData.view;
+            
+            gpu::ExtraView& extraView = renderContext.extraViews[i];
+            std::ranges::copy(Math::FrustumPlanes(globals.projection * view), std::begin(extraView.frustumPlanes));
+            extraView.position = position;
+            extraView.lodTarget = globals.lodTarget;
+        }
+    }
+    
+    // Test lights for clustered shading: point and spot lights orbiting the scene copies (see SceneCopy.h), so the first
+    // ones are next to the scene, intensity is scaled by squared range to be visible at any scene size
+    static void GenerateTestLights(const uint32_t lightCount, const gpu::SceneCopyParams& sceneCopyParams,
+        const std::vector<glm::vec4>& sceneCopyTranslations, const float timeSeconds, RenderContext& renderContext)
+    {
+        constexpr uint32_t randomStride = 8; // Random values per light
+        constexpr float cosSpotOuterAngle = 0.7071068f; // 45 degrees
+        constexpr float cosSpotInnerAngle = 0.8660254f; // 30 degrees
+        
+        const uint32_t seed = gpu::pcgHash(sceneCopyParams.seed);
+        const float copySize = sceneCopyParams.sceneRadius * 2.0f;
+        
+        renderContext.lights.resize(lightCount);
+        
+        for (uint32_t i = 0; i < lightCount; ++i)
+        {
+            const auto random = [&](const uint32_t offset) { return gpu::randomFloat(seed, i * randomStride + offset); };
+            
+            const glm::vec3 copyCenter(sceneCopyTranslations[i % sceneCopyTranslations.size()]);
+            
+            const float orbitRadius = (0.1f + 0.4f * random(0)) * copySize;
+            const float angle = random(1) * 2.0f * std::numbers::pi_v<float> + timeSeconds * (0.2f + random(2));
+            const glm::vec3 orbitDirection(glm::cos(angle), 0.0f, glm::sin(angle));
+            
+            gpu::Light& light = renderContext.lights[i];
+            light.position = copyCenter + orbitDirection * orbitRadius + Vector3::unitY * ((random(3) - 0.5f) * copySize);
+            light.range = (0.2f + 0.3f * random(4)) * copySize;
+            light.color = glm::vec3(random(5), random(6), random(7)) * light.range * light.range;
+            
+            if (i % 2 == 1) // Looking down and out of the orbit
+            {
+                light.direction = glm::normalize(orbitDirection * 0.5f - Vector3::unitY);
+                light.cosOuterAngle = cosSpotOuterAngle;
+                light.cosInnerAngle = cosSpotInnerAngle;
+            }
+            else
+            {
+                light.direction = Vector3::zero;
+                light.cosOuterAngle = -1.0f;
+                light.cosInnerAngle = -1.0f;
+            }
+        }
+    }
+    
+    // Writes all copies of the scene draws and clusters (see SceneCopy.h) directly in device memory,
+    // only the scene itself is uploaded
+    static void RandomlyCopySceneOnGpu(const std::vector<gpu::Draw>& sceneDraws,
+        const std::vector<gpu::DrawCluster>& sceneDrawClusters, const gpu::SceneCopyParams& sceneCopyParams,
+        const std::vector<glm::vec4>& sceneCopyTranslations, const RenderContext& renderContext,
+        const VulkanContext& vulkanContext)
+    {
+        using namespace PipelineUtils;
+        
+        ScopeTimer timer("Randomly copy scene on GPU");
+        
+        const std::span sceneDrawSpan(sceneDraws);
+        
+        const BufferDescription sceneDrawBufferDescription = {
+            .size = sceneDrawSpan.size_bytes(),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        Buffer sceneDrawBuffer(sceneDrawBufferDescription, true, sceneDrawSpan, vulkanContext);
+        
+        const std::span sceneDrawClusterSpan(sceneDrawClusters);
+        
+        const BufferDescription sceneDrawClusterBufferDescription = {
+            .size = sceneDrawClusterSpan.size_bytes(),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        Buffer sceneDrawClusterBuffer(sceneDrawClusterBufferDescription, true, sceneDrawClusterSpan, vulkanContext);
+        
+        const std::span translationSpan(sceneCopyTranslations);
+        
+        const BufferDescription translationBufferDescription = {
+            .size = translationSpan.size_bytes(),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        Buffer translationBuffer(translationBufferDescription, true, translationSpan, vulkanContext);
+        
+        BufferUtils::UploadFromStagingBuffers(vulkanContext, Barriers::transferWriteToComputeRead,
+            /* destroyStagingBuffers */ true, sceneDrawBuffer, sceneDrawClusterBuffer, translationBuffer);
+        
+        const ShaderModule shader = vulkanContext.GetShaderManager().CreateShaderModule(
+            FilePath(randomlyCopySceneShaderPath), VK_SHADER_STAGE_COMPUTE_BIT, {});
+        
+        // 1 thread per draw can exceed maxComputeWorkGroupCount, see PipelineUtils::DispatchChunked
+        const Pipeline pipeline = ComputePipelineBuilder(vulkanContext)
+            .SetShaderModule(shader)
+            .SetCreateFlags(VK_PIPELINE_CREATE_DISPATCH_BASE_BIT)
+            .Build();
+        
+        Assert(pipeline.IsValid());
+        
+        const std::vector<VkDescriptorSet> descriptors = vulkanContext.GetDescriptorSetsManager()
+            .GetReflectiveDescriptorSetBuilder(pipeline, DescriptorScope::eSceneRenderer)
+            .Bind("SceneDraws", sceneDrawBuffer)
+            .Bind("SceneDrawClusters", sceneDrawClusterBuffer)
+            .Bind("Draws", renderContext.drawBuffer)
+            .Bind("DrawClusters", renderContext.drawClusterBuffer)
+            .Bind("CopyTranslations", translationBuffer)
+            .Build();
+        
+        const uint32_t threadCount = sceneCopyParams.copyCount * sceneCopyParams.sceneDrawCount;
+        const uint32_t maxGroupCount = vulkanContext.GetDevice().GetProperties().physicalProperties.limits.maxComputeWorkGroupCount[0];
+        
+        vulkanContext.GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+            
+            PushConstants(cmd, pipeline, "params", sceneCopyParams);
+            
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetLayout(), 0,
+                static_cast<uint32_t>(descriptors.size()), descriptors.data(), 0, nullptr);
+            
+            DispatchChunked(cmd, GroupCount(threadCount, gpu::sceneCopyWgSize), maxGroupCount);
+            
+            SynchronizationUtils::SetMemoryBarrier(cmd, Barriers::computeWriteToComputeRead);
+        });
+    }
+    
+    static void CreateDrawBuffers(std::vector<gpu::Draw>& draws, std::vector<gpu::DrawCluster>& drawClusters,
+        const gpu::SceneCopyParams& sceneCopyParams, const std::vector<glm::vec4>& sceneCopyTranslations,
+        RenderContext& renderContext, const VulkanContext& vulkanContext)
+    {
+        const bool copyOnGpu = EngineConfig::randomlyCopySceneOnGpu && sceneCopyParams.copyCount > 1;
+        
+        const BufferDescription drawBufferDescription = {
+            .size = draws.size() * sceneCopyParams.copyCount * sizeof(gpu::Draw),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        const BufferDescription drawClusterBufferDescription = {
+            .size = drawClusters.size() * sceneCopyParams.copyCount * sizeof(gpu::DrawCluster),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        if (copyOnGpu)
+        {
+            renderContext.drawBuffer = Buffer(drawBufferDescription, false, vulkanContext);
+            renderContext.drawClusterBuffer = Buffer(drawClusterBufferDescription, false, vulkanContext);
+            
+            RandomlyCopySceneOnGpu(draws, drawClusters, sceneCopyParams, sceneCopyTranslations, renderContext, vulkanContext);
+            
+            return;
+        }
+        
+        if (sceneCopyParams.copyCount > 1)
+        {
+            SceneHelpers::RandomlyCopyScene(sceneCopyParams, sceneCopyTranslations, draws, drawClusters);
+        }
+        
+        renderContext.drawBuffer = Buffer(drawBufferDescription, true, std::span(std::as_const(draws)), vulkanContext);
+        renderContext.drawClusterBuffer = Buffer(drawClusterBufferDescription, true, std::span(std::as_const(drawClusters)),
+            vulkanContext);
+        
+        BufferUtils::UploadFromStagingBuffers(vulkanContext, Barriers::transferWriteToComputeRead,
+            /* destroyStagingBuffers */ true, renderContext.drawBuffer, renderContext.drawClusterBuffer);
     }
 
-    static void CreateSceneBuffers(const RawScene& rawScene, RenderContext& renderContext, const VulkanContext& vulkanContext)
+    // Returns parameters of the scene copies and fills their translations, test lights are placed around them
+    static gpu::SceneCopyParams CreateSceneBuffers(const RawScene& rawScene, std::vector<glm::vec4>& sceneCopyTranslations,
+        RenderContext& renderContext, const VulkanContext& vulkanContext)
     {
         const std::span verticesSpan(rawScene.vertices);
 
@@ -71,7 +361,7 @@ namespace ForwardRendererDetails
 
         const BufferDescription indexBufferDescription = {
             .size = indicesSpan.size_bytes(),
-            .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
             .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
 
         renderContext.indexBuffer = Buffer(indexBufferDescription, true, indicesSpan, vulkanContext);
@@ -95,6 +385,15 @@ namespace ForwardRendererDetails
                 .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
 
             renderContext.meshletBuffer = Buffer(meshletBufferDescription, true, meshletSpan, vulkanContext);
+
+            const std::span meshletBoundsSpan(rawScene.meshletBounds);
+
+            const BufferDescription meshletBoundsBufferDescription = {
+                .size = meshletBoundsSpan.size_bytes(),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+
+            renderContext.meshletBoundsBuffer = Buffer(meshletBoundsBufferDescription, true, meshletBoundsSpan, vulkanContext);
         }
 
         const std::span primitiveSpan(rawScene.primitives);
@@ -106,28 +405,39 @@ namespace ForwardRendererDetails
 
         renderContext.primitiveBuffer = Buffer(primitiveBufferDescription, true, primitiveSpan, vulkanContext);
         
-        const std::vector<gpu::Draw> draws = SceneHelpers::GenerateDraws(rawScene);
+        const std::span primitiveBoundsSpan(rawScene.primitiveBounds);
+
+        const BufferDescription primitiveBoundsBufferDescription = {
+            .size = primitiveBoundsSpan.size_bytes(),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+
+        renderContext.primitiveBoundsBuffer = Buffer(primitiveBoundsBufferDescription, true, primitiveBoundsSpan, vulkanContext);
+        
+        std::vector<gpu::Draw> draws = SceneHelpers::GenerateDraws(rawScene);
+        std::vector<gpu::DrawCluster> drawClusters = SceneHelpers::GenerateDrawClusters(rawScene, draws);
+        
+        // Copies keep the order and clusters of the scene draws, so only the scene itself is processed on CPU
+        const gpu::SceneCopyParams sceneCopyParams = SceneHelpers::GetSceneCopyParams(rawScene, draws.size(), drawClusters.size());
+        sceneCopyTranslations = SceneHelpers::GetSceneCopyTranslations(sceneCopyParams);
+        const size_t drawCount = draws.size() * sceneCopyParams.copyCount;
+        const size_t drawClusterCount = drawClusters.size() * sceneCopyParams.copyCount;
     
         RenderOptions& renderOptions = RenderOptions::Get();
-        renderOptions.SetCurrentDrawCount(std::min(10'000u, static_cast<uint32_t>(draws.size())));
-        renderOptions.SetMaxDrawCount(static_cast<uint32_t>(draws.size()));
+        renderOptions.SetCurrentDrawCount(std::min(10'000u, static_cast<uint32_t>(drawCount)));
+        renderOptions.SetMaxDrawCount(static_cast<uint32_t>(drawCount));
 
         renderContext.globals.drawCount = renderOptions.GetCurrentDrawCount();
 
-        SetSceneStats(rawScene, draws);
-
-        const std::span drawSpan(draws);
-
-        const BufferDescription drawBufferDescription = {
-            .size = drawSpan.size_bytes(),
-            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
-
-        renderContext.drawBuffer = Buffer(drawBufferDescription, true, drawSpan, vulkanContext);
+        SetSceneStats(rawScene, draws, sceneCopyParams.copyCount);
+        
+        CreateIndirectBuffers(rawScene, draws, sceneCopyParams.copyCount, renderContext, vulkanContext);
+        
+        CreateDrawBuffers(draws, drawClusters, sceneCopyParams, sceneCopyTranslations, renderContext, vulkanContext);
         
         // TODO: Create only when required
         const BufferDescription drawsVisibilityBufferDescription = {
-            .size = draws.size() * sizeof(uint32_t),
+            .size = drawCount * sizeof(uint32_t),
             .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
 
@@ -136,11 +446,194 @@ namespace ForwardRendererDetails
         // TODO: We always create this one, but can skip if we implement compile time switch for debug features
         // And/or we can create it lazily
         const BufferDescription drawDebugDataBufferDescription = {
-            .size = draws.size() * sizeof(uint32_t),
-            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .size = drawCount * sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
             .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
 
         renderContext.drawsDebugDataBuffer = Buffer(drawDebugDataBufferDescription, false, vulkanContext);
+        
+        // Each draw is emitted at most once per frame, culling passes share it (CPU culling uploads into it)
+        const BufferDescription visibleInstanceBufferDescription = {
+            .size = drawCount * sizeof(gpu::VisibleInstance),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.visibleInstanceBuffer = Buffer(visibleInstanceBufferDescription, false, vulkanContext);
+        
+        // TODO: Create only when required
+        const BufferDescription instanceLodBufferDescription = {
+            .size = drawCount * sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.instanceLodBuffer = Buffer(instanceLodBufferDescription, false, vulkanContext);
+        
+        renderContext.globals.clusterCount = static_cast<uint32_t>(drawClusterCount);
+        
+        const BufferDescription clusterVisibilityBufferDescription = {
+            .size = drawClusterCount * sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.clusterVisibilityBuffer = Buffer(clusterVisibilityBufferDescription, false, vulkanContext);
+        
+        const BufferDescription visibleClustersBufferDescription = {
+            .size = drawClusterCount * sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.visibleClustersBuffer = Buffer(visibleClustersBufferDescription, false, vulkanContext);
+        
+        constexpr gpu::ClusterDispatch clusterDispatch = { .command = { 0, 0, 1 }, .visibleClusterCount = 0 };
+        const std::span clusterDispatchSpan(&clusterDispatch, 1);
+        
+        const BufferDescription clusterDispatchBufferDescription = {
+            .size = clusterDispatchSpan.size_bytes(),
+            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.clusterDispatchBuffer = Buffer(clusterDispatchBufferDescription, true, clusterDispatchSpan, vulkanContext);
+        
+        // Header and views are updated by culling every frame, see PrimitiveCullStage
+        const BufferDescription extraViewsBufferDescription = {
+            .size = sizeof(gpu::ExtraViews),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.extraViewsBuffer = Buffer(extraViewsBufferDescription, false, vulkanContext);
+        
+        // Command streams of the extra views one after another, capacity is deduced from the size
+        const size_t extraViewCommandCount = gpu::maxExtraViewCount
+            * std::min(drawCount, EngineConfig::extraViewCommandCapacity);
+        
+        const BufferDescription extraViewInstanceBufferDescription = {
+            .size = extraViewCommandCount * sizeof(gpu::VisibleInstance),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.extraViewInstanceBuffer = Buffer(extraViewInstanceBufferDescription, false, vulkanContext);
+        
+        const BufferDescription extraViewCommandBufferDescription = {
+            .size = extraViewCommandCount * sizeof(gpu::VkDrawIndexedIndirectCommand),
+            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.extraViewCommandBuffer = Buffer(extraViewCommandBufferDescription, false, vulkanContext);
+        
+        // TODO: Create only when required
+        const BufferDescription drawBucketBufferDescription = {
+            .size = rawScene.primitives.size() * gpu::maxLodCount * sizeof(gpu::DrawBucket),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.drawBucketBuffer = Buffer(drawBucketBufferDescription, false, vulkanContext);
+        
+        // Header with visible draw count and allocated instance count, then visible draws
+        const BufferDescription instancedDrawBufferDescription = {
+            .size = 2 * sizeof(uint32_t) + drawCount * sizeof(gpu::InstancedDraw),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.instancedDrawBuffer = Buffer(instancedDrawBufferDescription, false, vulkanContext);
+        
+        const BufferDescription instanceBufferDescription = {
+            .size = drawCount * sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.instanceBuffer = Buffer(instanceBufferDescription, false, vulkanContext);
+        
+        // Header and lights are uploaded every frame, see LightCullStage
+        const BufferDescription lightBufferDescription = {
+            .size = sizeof(gpu::Lights),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.lightBuffer = Buffer(lightBufferDescription, false, vulkanContext);
+        
+        const BufferDescription lightClusterBufferDescription = {
+            .size = sizeof(gpu::LightClusters),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.lightClusterBuffer = Buffer(lightClusterBufferDescription, false, vulkanContext);
+        
+        // Header is reset by culling, second pass start is copied into it, see PrimitiveCullStage
+        const BufferDescription impostorDrawBufferDescription = {
+            .size = sizeof(gpu::ImpostorCommands) + drawCount * sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.impostorDrawBuffer = Buffer(impostorDrawBufferDescription, false, vulkanContext);
+        
+        // Header index counts are written by DebugStage, instance counts are reset by culling, see PrimitiveCullStage
+        const BufferDescription debugBoundsBufferDescription = {
+            .size = sizeof(gpu::DebugBoundsCommands) + drawCount * sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+        
+        renderContext.debugBoundsBuffer = Buffer(debugBoundsBufferDescription, false, vulkanContext);
+        
+        const DeviceProperties& deviceProperties = vulkanContext.GetDevice().GetProperties();
+        
+        if (!rawScene.meshlets.empty() && deviceProperties.meshShadersSupported && deviceProperties.bufferInt64AtomicsSupported)
+        {
+            // Header is reset before every frame, see SoftwareRasterStage
+            const BufferDescription softwareRasterBufferDescription = {
+                .size = sizeof(gpu::SoftwareRaster),
+                .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+            
+            renderContext.softwareRasterBuffer = Buffer(softwareRasterBufferDescription, false, vulkanContext);
+            
+            const BufferDescription softwareMeshletBufferDescription = {
+                .size = gpu::maxSoftwareMeshlets * sizeof(glm::uvec2),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+            
+            renderContext.softwareMeshletBuffer = Buffer(softwareMeshletBufferDescription, false, vulkanContext);
+        }
+        
+        return sceneCopyParams;
+    }
+    
+    // Dynamic state persists through the command buffer, RenderSystem sets the full swapchain one before rendering
+    static void SetViewportAndScissor(const VkCommandBuffer commandBuffer, const VkRect2D renderArea)
+    {
+        const VkViewport viewport = VulkanUtils::GetViewport(static_cast<float>(renderArea.extent.width),
+            static_cast<float>(renderArea.extent.height));
+        
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &renderArea);
+    }
+    
+    // Switching graphics pipeline type changes runtime defines of most pipelines, toggles which only change required
+    // pipelines (e.g. occlusion culling) are covered by precompilation of unrequired ones
+    static std::vector<RenderStage::DefineOverrides> GetLikelyPipelineVariants()
+    {
+        using namespace gpu::defines;
+        
+        const RenderOptions& renderOptions = RenderOptions::Get();
+        
+        std::vector<RenderStage::DefineOverrides> variants;
+        
+        for (const GraphicsPipelineType type : OptionValues::graphicsPipelineTypes)
+        {
+            if (type == renderOptions.GetGraphicsPipelineType() || !renderOptions.IsGraphicsPipelineTypeSupported(type))
+            {
+                continue;
+            }
+            
+            variants.push_back({
+                { meshPipeline, type == GraphicsPipelineType::eMesh },
+                { softwareRasterization, ForwardUtils::UseSoftwareRasterization(type) },
+                { meshletCulling, ForwardUtils::UseMeshletCulling(type) },
+                { instancedDraws, ForwardUtils::UseInstancedDraws(type) } });
+        }
+        
+        return variants;
     }
 }
 
@@ -153,12 +646,23 @@ ForwardRenderer::ForwardRenderer(EventSystem& aEventSystem, const VulkanContext&
     CreateRenderPasses();
 
     primitiveCullStage = std::make_unique<PrimitiveCullStage>(*vulkanContext, renderContext);
+    lightCullStage = std::make_unique<LightCullStage>(*vulkanContext, renderContext);
     forwardStage = std::make_unique<ForwardStage>(*vulkanContext, renderContext);
+    softwareRasterStage = std::make_unique<SoftwareRasterStage>(*vulkanContext, renderContext);
+    impostorStage = std::make_unique<ImpostorStage>(*vulkanContext, renderContext);
     debugStage = std::make_unique<DebugStage>(*vulkanContext, renderContext);
+    visibilityResolveStage = std::make_unique<VisibilityResolveStage>(*vulkanContext, renderContext);
     
     renderStages.push_back(primitiveCullStage.get());
+    renderStages.push_back(lightCullStage.get());
     renderStages.push_back(forwardStage.get());
+    renderStages.push_back(softwareRasterStage.get());
+    renderStages.push_back(impostorStage.get());
     renderStages.push_back(debugStage.get());
+    renderStages.push_back(visibilityResolveStage.get());
+    
+    RenderStage::BuildPipelines(renderStages);
+    RenderStage::PrecompilePipelines(renderStages, ForwardRendererDetails::GetLikelyPipelineVariants());
     
     CreateRenderTargets();
     CreateFramebuffers();
@@ -172,14 +676,26 @@ ForwardRenderer::ForwardRenderer(EventSystem& aEventSystem, const VulkanContext&
     // Runtime defines
     eventSystem->Subscribe<RenderOptions::GraphicsPipelineTypeChanged>(this, &ForwardRenderer::OnTryReloadShaders);
     eventSystem->Subscribe<RenderOptions::VisualizeLodsChanged>(this, &ForwardRenderer::OnTryReloadShaders);
+    eventSystem->Subscribe<RenderOptions::ClusterCullingChanged>(this, &ForwardRenderer::OnTryReloadShaders);
+    eventSystem->Subscribe<RenderOptions::InstancedDrawsChanged>(this, &ForwardRenderer::OnTryReloadShaders);
+    eventSystem->Subscribe<RenderOptions::MeshletCullingChanged>(this, &ForwardRenderer::OnTryReloadShaders);
+    eventSystem->Subscribe<RenderOptions::ImpostorsChanged>(this, &ForwardRenderer::OnTryReloadShaders);
+    eventSystem->Subscribe<RenderOptions::VisualizeBoundingSpheresChanged>(this, &ForwardRenderer::OnTryReloadShaders);
+    eventSystem->Subscribe<RenderOptions::VisualizeBoundingRectanglesChanged>(this, &ForwardRenderer::OnTryReloadShaders);
+    eventSystem->Subscribe<RenderOptions::CpuCullingValidationChanged>(this, &ForwardRenderer::OnTryReloadShaders);
     eventSystem->Subscribe<RenderOptions::MsaaSampleCountChanged>(this, &ForwardRenderer::Reinitialize);
     eventSystem->Subscribe<RenderOptions::OcclusionCullingChanged>(this, &ForwardRenderer::Reinitialize);
+    eventSystem->Subscribe<RenderOptions::VisibilityBufferChanged>(this, &ForwardRenderer::Reinitialize);
+    eventSystem->Subscribe<RenderOptions::SoftwareRasterizationChanged>(this, &ForwardRenderer::Reinitialize);
+    eventSystem->Subscribe<RenderOptions::DynamicResolutionChanged>(this, &ForwardRenderer::Reinitialize);
 }
 
 ForwardRenderer::~ForwardRenderer()
 {
     eventSystem->UnsubscribeAll(this);
     
+    RenderStage::CancelPrecompilation(renderStages);
+    
     DestroyFramebuffers();
     DestroyRenderTargets();
 }
@@ -203,8 +719,19 @@ void ForwardRenderer::Process(const Frame& frame, const float deltaSeconds)
     renderContext.globals.projection = projection;
     renderContext.globals.drawCount = renderOptions.GetCurrentDrawCount();
     renderContext.globals.bUseLods = renderOptions.GetUseLods();
+    
+    // Scaled by GatherFrameStats with dynamic resolution, so LODs are selected for the pixels actually rendered
+    renderContext.renderExtent = {
+        std::max(1u, static_cast<uint32_t>(static_cast<float>(swapchainExtent.width) * renderContext.renderScale)),
+        std::max(1u, static_cast<uint32_t>(static_cast<float>(swapchainExtent.height) * renderContext.renderScale)) };
+    
     renderContext.globals.lodTarget = glm::tan(camera.GetVerticalFov() / 2.0f) 
-        * 2.0f / static_cast<float>(swapchainExtent.height); // 1px in primitive space
+        * 2.0f / static_cast<float>(renderContext.renderExtent.height); // 1px in primitive space
+    
+    // Scaled by GatherFrameStats with quality governor, outside of camera freezing so it keeps reacting
+    renderContext.globals.lodTarget *= renderContext.detailScale;
+    renderContext.globals.cullData.contributionThreshold =
+        static_cast<float>(CONTRIBUTION_CULL_THRESHOLD) * renderContext.detailScale;
 
     if (!renderOptions.GetFreezeCamera())
     {
@@ -224,6 +751,11 @@ void ForwardRenderer::Process(const Frame& frame, const float deltaSeconds)
         
         renderContext.debugData.frustumCornersWorld = MeshUtils::GenerateFrustumCorners(camera);
     }
+    
+    GenerateTestExtraViews(renderOptions.GetExtraViewCount(), renderContext);
+    
+    lightTimeSeconds += deltaSeconds;
+    GenerateTestLights(renderOptions.GetLightCount(), sceneCopyParams, sceneCopyTranslations, lightTimeSeconds, renderContext);
 }
 
 void ForwardRenderer::Render(const Frame& frame)
@@ -231,7 +763,7 @@ void ForwardRenderer::Render(const Frame& frame)
     using namespace VulkanUtils;
     using namespace ForwardRendererDetails;
     
-    if (!scene)
+    if (!scene || !requiredPipelinesBuilt)
     {
         return;
     }
@@ -242,28 +774,146 @@ void ForwardRenderer::Render(const Frame& frame)
         return;
     }
     
+    const bool visibilityBuffer = ForwardUtils::UseVisibilityBuffer();
+    const bool softwareRasterization = ForwardUtils::UseSoftwareRasterization();
+    const bool impostors = ForwardUtils::UseImpostors();
+    const bool dynamicResolution = ForwardUtils::UseDynamicResolution();
+    
+    const VkRect2D renderArea = { { 0, 0 }, renderContext.renderExtent };
+    
     primitiveCullStage->Execute(frame);
+    lightCullStage->Execute(frame);
+    
+    if (softwareRasterization)
+    {
+        softwareRasterStage->Prepare(frame);
+    }
 
-    renderContext.renderPass.Begin(frame, renderContext.framebuffers[frame.swapchainImageIndex], GpuTimestamp::eFirstRenderPassBegin);
+    const VkFramebuffer framebuffer = renderContext.framebuffers[visibilityBuffer || dynamicResolution
+        ? 0 : frame.swapchainImageIndex];
+    
+    if (dynamicResolution)
+    {
+        SetViewportAndScissor(frame.commandBuffer, renderArea);
+    }
+    
+    renderContext.renderPass.Begin(frame, framebuffer, renderArea, GpuTimestamp::eFirstRenderPassBegin);
     forwardStage->Execute(frame);
-    debugStage->Execute(frame);
+    
+    if (impostors)
+    {
+        impostorStage->Execute(frame);
+    }
+    
+    if (!visibilityBuffer)
+    {
+        debugStage->Execute(frame);
+    }
+    
     renderContext.renderPass.End(frame, GpuTimestamp::eFirstRenderPassEnd);
+    
+    if (dynamicResolution)
+    {
+        Upscale(frame);
+    }
+    
+    if (softwareRasterization)
+    {
+        softwareRasterStage->Execute(frame);
+    }
+    
+    if (visibilityBuffer)
+    {
+        ResolveVisibility(frame);
+    }
+    
+    primitiveCullStage->CopyDrawCounters(frame);
+}
+
+void ForwardRenderer::GatherFrameStats(const Frame& frame, FrameRenderStats& renderStats)
+{
+    if (!scene)
+    {
+        return;
+    }
+    
+    primitiveCullStage->GatherFrameStats(frame, renderStats);
+    
+    if (ForwardUtils::UseDynamicResolution())
+    {
+        const float frameMs = StatsUtils::GetTimingMs(vulkanContext->GetDevice(), renderStats, GpuTiming::eFrame);
+        const auto targetFrameMs = static_cast<float>(RenderOptions::Get().GetTargetGpuFrameMs());
+        
+        renderContext.renderScale = ForwardUtils::UpdateRenderScale(renderContext.renderScale, frameMs, targetFrameMs);
+    }
+    else
+    {
+        renderContext.renderScale = 1.0f;
+    }
+    
+    if (RenderOptions::Get().GetQualityGovernor())
+    {
+        const float frameMs = StatsUtils::GetTimingMs(vulkanContext->GetDevice(), renderStats, GpuTiming::eFrame);
+        const uint64_t triangleBudget = RenderOptions::Get().GetTriangleBudget() * 1000ull;
+        
+        // With dynamic resolution GPU time is left to render scale, both controllers on it would fight each other
+        const float targetFrameMs = ForwardUtils::UseDynamicResolution()
+            ? 0.0f : static_cast<float>(RenderOptions::Get().GetTargetGpuFrameMs());
+        
+        renderContext.detailScale = ForwardUtils::UpdateDetailScale(renderContext.detailScale,
+            frameMs, targetFrameMs, renderStats.triangleCount, triangleBudget);
+    }
+    else
+    {
+        renderContext.detailScale = 1.0f;
+    }
 }
 
 void ForwardRenderer::RenderWithOcclusionCulling(const Frame& frame)
 {
     const bool msaaEnabled = VK_SAMPLE_COUNT_1_BIT != RenderOptions::Get().GetMsaaSampleCount();
     const bool freezeCamera = RenderOptions::Get().GetFreezeCamera();
+    const bool visibilityBuffer = ForwardUtils::UseVisibilityBuffer();
+    const bool softwareRasterization = ForwardUtils::UseSoftwareRasterization();
+    const bool impostors = ForwardUtils::UseImpostors();
+    const bool dynamicResolution = ForwardUtils::UseDynamicResolution();
     
-    const VkFramebuffer firstPassFramebuffer = renderContext.firstPassFramebuffers[msaaEnabled ? 0 : frame.swapchainImageIndex];
-    const VkFramebuffer secondPassFramebuffer = renderContext.secondPassFramebuffers[frame.swapchainImageIndex];
+    // Visibility buffer and dynamic resolution passes don't write swapchain, so they have a single framebuffer
+    const VkFramebuffer firstPassFramebuffer = renderContext.firstPassFramebuffers[msaaEnabled || visibilityBuffer ||
+        dynamicResolution ? 0 : frame.swapchainImageIndex];
+    const VkFramebuffer secondPassFramebuffer = renderContext.secondPassFramebuffers[visibilityBuffer || dynamicResolution
+        ? 0 : frame.swapchainImageIndex];
+    
+    const VkRect2D renderArea = { { 0, 0 }, renderContext.renderExtent };
     
     primitiveCullStage->ExecuteFirstPass(frame);
+    lightCullStage->Execute(frame);
+    
+    if (softwareRasterization) // Both passes append meshlets, they are rasterized once after the second one
+    {
+        softwareRasterStage->Prepare(frame);
+    }
         
-    renderContext.firstRenderPass.Begin(frame, firstPassFramebuffer, GpuTimestamp::eFirstRenderPassBegin);
+    if (dynamicResolution)
+    {
+        ForwardRendererDetails::SetViewportAndScissor(frame.commandBuffer, renderArea);
+    }
+    
+    renderContext.firstRenderPass.Begin(frame, firstPassFramebuffer, renderArea, GpuTimestamp::eFirstRenderPassBegin);
     forwardStage->Execute(frame);
+    
+    if (impostors)
+    {
+        impostorStage->Execute(frame);
+    }
+    
     renderContext.firstRenderPass.End(frame, GpuTimestamp::eFirstRenderPassEnd);
     
+    if (softwareRasterization)
+    {
+        softwareRasterStage->SynchronizePasses(frame);
+    }
+    
     if (!freezeCamera)
     {
         primitiveCullStage->BuildDepthPyramid(frame);
@@ -274,22 +924,90 @@ void ForwardRenderer::RenderWithOcclusionCulling(const Frame& frame)
         primitiveCullStage->ExecuteSecondPass(frame);
     }
     
-    renderContext.secondRenderPass.Begin(frame, secondPassFramebuffer, GpuTimestamp::eSecondRenderPassBegin);
+    renderContext.secondRenderPass.Begin(frame, secondPassFramebuffer, renderArea, GpuTimestamp::eSecondRenderPassBegin);
     
     if (!freezeCamera)
     {
         forwardStage->Execute(frame);
+        
+        if (impostors)
+        {
+            impostorStage->ExecuteSecondPass(frame);
+        }
+    }
+    
+    if (!visibilityBuffer)
+    {
+        debugStage->Execute(frame); // TODO: Not a separate stage, just debug objects in the scene
     }
     
-    debugStage->Execute(frame); // TODO: Not a separate stage, just debug objects in the scene
     renderContext.secondRenderPass.End(frame, GpuTimestamp::eSecondRenderPassEnd);
     
+    if (dynamicResolution)
+    {
+        Upscale(frame);
+    }
+    
+    if (softwareRasterization)
+    {
+        softwareRasterStage->Execute(frame);
+    }
+    
+    if (visibilityBuffer)
+    {
+        ResolveVisibility(frame);
+    }
+    
+    primitiveCullStage->CopyDrawCounters(frame);
+    
     if (RenderOptions::Get().GetVisualizeDepth())
     {
         primitiveCullStage->VisualizeDepth(frame);
     }
 }
 
+void ForwardRenderer::ResolveVisibility(const Frame& frame)
+{
+    const VkFramebuffer framebuffer = renderContext.visibilityResolveFramebuffers[frame.swapchainImageIndex];
+    
+    renderContext.visibilityResolveRenderPass.Begin(frame, framebuffer, GpuTimestamp::eVisibilityResolveBegin);
+    visibilityResolveStage->Execute(frame);
+    debugStage->Execute(frame);
+    renderContext.visibilityResolveRenderPass.End(frame, GpuTimestamp::eVisibilityResolveEnd);
+}
+
+void ForwardRenderer::Upscale(const Frame& frame) const
+{
+    using namespace ImageUtils;
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    const Swapchain& swapchain = vulkanContext->GetSwapchain();
+    const RenderTarget& swapchainTarget = swapchain.GetRenderTargets()[frame.swapchainImageIndex];
+    
+    const VkExtent2D renderExtent = renderContext.renderExtent;
+    const VkExtent2D swapchainExtent = swapchain.GetExtent();
+    
+    TransitionLayout(cmd, renderContext.sceneColorTarget, LayoutTransitions::colorAttachmentOptimalToSrcOptimal,
+        Barriers::colorWriteToTransferRead);
+    
+    // Swapchain image isn't written before this frame, its acquire semaphore is waited on color attachment output
+    TransitionLayout(cmd, swapchainTarget, LayoutTransitions::undefinedToDstOptimal, Barriers::colorReadWriteToTransferWrite);
+    
+    const VkOffset3D sourceOffset = { static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 };
+    const VkOffset3D destinationOffset = { static_cast<int32_t>(swapchainExtent.width),
+        static_cast<int32_t>(swapchainExtent.height), 1 };
+    
+    BlitImageToImage(cmd, renderContext.sceneColorTarget, swapchainTarget, sourceOffset, destinationOffset, 0, 0, VK_FILTER_LINEAR);
+    
+    TransitionLayout(cmd, renderContext.sceneColorTarget, LayoutTransitions::srcOptimalToColorAttachmentOptimal,
+        Barriers::transferReadToColorWrite);
+    TransitionLayout(cmd, swapchainTarget, LayoutTransitions::dstOptimalToColorAttachmentOptimal,
+        Barriers::transferWriteToColorReadWrite);
+    
+    // UI and depth visualization cover the whole swapchain
+    VulkanUtils::SetDefaultViewportAndScissor(cmd, swapchain);
+}
+
 void ForwardRenderer::InitRuntimeDefineGetters()
 {
     using namespace gpu::defines;
@@ -300,13 +1018,37 @@ void ForwardRenderer::InitRuntimeDefineGetters()
     runtimeDefineGetters.emplace(meshPipeline, []() { return RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh; });
     runtimeDefineGetters.emplace(drawIndirectCount, [=]() { return deviceProperties.drawIndirectCountSupported; });
     runtimeDefineGetters.emplace(visualizeLods, []() { return RenderOptions::Get().GetVisualizeLods(); });
+    runtimeDefineGetters.emplace(clusterCulling, []() { return RenderOptions::Get().GetClusterCulling(); });
+    runtimeDefineGetters.emplace(visibilityBuffer, []() { return ForwardUtils::UseVisibilityBuffer(); });
+    runtimeDefineGetters.emplace(softwareRasterization, []() { return ForwardUtils::UseSoftwareRasterization(); });
+    runtimeDefineGetters.emplace(impostors, []() { return ForwardUtils::UseImpostors(); });
+    runtimeDefineGetters.emplace(debugBounds, []() { return ForwardUtils::UseDebugBounds(); });
+    runtimeDefineGetters.emplace(instancedDraws, []() { return ForwardUtils::UseInstancedDraws(); });
+    runtimeDefineGetters.emplace(meshletCulling, []() { return ForwardUtils::UseMeshletCulling(); });
+    
+    const uint32_t deviceTaskChunkSize = ForwardUtils::GetTaskChunkSize(*vulkanContext);
+    runtimeDefineGetters.emplace(taskChunkSize, [=]() {
+        return static_cast<int>(std::min(deviceTaskChunkSize, static_cast<uint32_t>(std::numeric_limits<int>::max())));
+    });
 }
 
 void ForwardRenderer::CreateRenderPasses()
 {
     const VkSampleCountFlagBits sampleCount = RenderOptions::Get().GetMsaaSampleCount();
     
-    if (RenderOptions::Get().GetOcclusionCulling())
+    if (ForwardUtils::UseVisibilityBuffer())
+    {
+        if (RenderOptions::Get().GetOcclusionCulling())
+        {
+            renderContext.firstRenderPass = ForwardUtils::CreateFirstOcclusionCullingVisibilityRenderPass(*vulkanContext);
+            renderContext.secondRenderPass = ForwardUtils::CreateSecondOcclusionCullingVisibilityRenderPass(*vulkanContext);
+        }
+        else
+        {
+            renderContext.renderPass = ForwardUtils::CreateVisibilityRenderPass(*vulkanContext);
+        }
+    }
+    else if (RenderOptions::Get().GetOcclusionCulling())
     {
         renderContext.firstRenderPass = ForwardUtils::CreateFirstOcclusionCullingRenderPass(sampleCount, *vulkanContext);
         renderContext.secondRenderPass = ForwardUtils::CreateSecondOcclusionCullingRenderPass(sampleCount, *vulkanContext);
@@ -315,6 +1057,9 @@ void ForwardRenderer::CreateRenderPasses()
     {
         renderContext.renderPass = ForwardUtils::CreateRenderPass(sampleCount, *vulkanContext);
     }
+    
+    // Created even when unused, so the resolve pipeline always has a render pass to be built against
+    renderContext.visibilityResolveRenderPass = ForwardUtils::CreateVisibilityResolveRenderPass(*vulkanContext);
 }
 
 void ForwardRenderer::DestroyRenderPasses()
@@ -322,6 +1067,7 @@ void ForwardRenderer::DestroyRenderPasses()
     renderContext.renderPass = {};
     renderContext.firstRenderPass = {};
     renderContext.secondRenderPass = {};
+    renderContext.visibilityResolveRenderPass = {};
 }
 
 void ForwardRenderer::CreateRenderTargets()
@@ -343,6 +1089,23 @@ void ForwardRenderer::CreateRenderTargets()
         renderContext.depthResolveTarget = ForwardUtils::CreateDepthResolveTarget(*vulkanContext);
     }
     
+    if (ForwardUtils::UseVisibilityBuffer())
+    {
+        renderContext.visibilityTarget = ForwardUtils::CreateVisibilityTarget(*vulkanContext);
+    }
+    
+    // Takes swapchain place in framebuffers, see ForwardRenderer::Upscale
+    if (ForwardUtils::UseDynamicResolution())
+    {
+        renderContext.sceneColorTarget = ForwardUtils::CreateSceneColorTarget(*vulkanContext);
+    }
+    
+    // Regardless of the pipeline type, so switching to mesh pipeline only rebuilds shaders
+    if (ForwardUtils::UseVisibilityBuffer() && renderOptions.GetSoftwareRasterization())
+    {
+        renderContext.softwareVisibilityBuffer = ForwardUtils::CreateSoftwareVisibilityBuffer(*vulkanContext);
+    }
+    
     std::ranges::for_each(renderStages, &RenderStage::CreateRenderTargetDependentResources);
 }
 
@@ -356,6 +1119,9 @@ void ForwardRenderer::DestroyRenderTargets()
     renderContext.colorTarget = {};
     renderContext.depthTarget = {};
     renderContext.depthResolveTarget = {};
+    renderContext.visibilityTarget = {};
+    renderContext.sceneColorTarget = {};
+    renderContext.softwareVisibilityBuffer = {};
 }
 
 void ForwardRenderer::CreateFramebuffers()
@@ -367,6 +1133,39 @@ void ForwardRenderer::CreateFramebuffers()
     
     RenderContext& rc = renderContext;
     
+    if (ForwardUtils::UseVisibilityBuffer()) // Geometry passes write visibility target, only resolve writes swapchain
+    {
+        std::vector<VkImageView> attachments = { rc.visibilityTarget.views[0], rc.depthTarget.views[0] };
+        
+        if (RenderOptions::Get().GetOcclusionCulling())
+        {
+            rc.firstPassFramebuffers.push_back(CreateFrameBuffer(rc.firstRenderPass, swapchain.GetExtent(), attachments, *vulkanContext));
+            rc.secondPassFramebuffers.push_back(CreateFrameBuffer(rc.secondRenderPass, swapchain.GetExtent(), attachments, *vulkanContext));
+        }
+        else
+        {
+            rc.framebuffers.push_back(CreateFrameBuffer(rc.renderPass, swapchain.GetExtent(), attachments, *vulkanContext));
+        }
+        
+        std::vector<VkImageView> resolveAttachments = { VK_NULL_HANDLE /* for swapchain RT */, rc.depthTarget.views[0] };
+        rc.visibilityResolveFramebuffers = VulkanUtils::CreateFramebuffers(rc.visibilityResolveRenderPass, swapchain,
+            resolveAttachments, *vulkanContext);
+        
+        return;
+    }
+    
+    // Dynamic resolution renders into scene color target instead of swapchain images, so it has a single framebuffer
+    const auto createFramebuffers = [&](const RenderPass& renderPass, std::vector<VkImageView> attachments) {
+        if (!ForwardUtils::UseDynamicResolution())
+        {
+            return VulkanUtils::CreateFramebuffers(renderPass, swapchain, attachments, *vulkanContext);
+        }
+        
+        std::ranges::replace(attachments, VkImageView{ VK_NULL_HANDLE }, static_cast<VkImageView>(rc.sceneColorTarget.views[0]));
+        
+        return std::vector{ CreateFrameBuffer(renderPass, swapchain.GetExtent(), attachments, *vulkanContext) };
+    };
+    
     if (const bool occlusionCulling = RenderOptions::Get().GetOcclusionCulling(); occlusionCulling)
     {
         if (msaaEnabled)
@@ -375,14 +1174,14 @@ void ForwardRenderer::CreateFramebuffers()
             rc.firstPassFramebuffers.push_back(CreateFrameBuffer(rc.firstRenderPass, swapchain.GetExtent(), firstPassAttachments, *vulkanContext));
             
             std::vector<VkImageView> secondPassAttachments = { rc.colorTarget.views[0], VK_NULL_HANDLE /* for swapchain RT */, rc.depthTarget.views[0] };
-            rc.secondPassFramebuffers = VulkanUtils::CreateFramebuffers(rc.secondRenderPass, swapchain, secondPassAttachments, *vulkanContext);
+            rc.secondPassFramebuffers = createFramebuffers(rc.secondRenderPass, secondPassAttachments);
         }
         else
         {
             std::vector<VkImageView> attachments = { VK_NULL_HANDLE /* for swapchain RT */, rc.depthTarget.views[0] };
             
-            rc.firstPassFramebuffers = VulkanUtils::CreateFramebuffers(rc.firstRenderPass, swapchain, attachments, *vulkanContext);
-            rc.secondPassFramebuffers = VulkanUtils::CreateFramebuffers(rc.secondRenderPass, swapchain, attachments, *vulkanContext);
+            rc.firstPassFramebuffers = createFramebuffers(rc.firstRenderPass, attachments);
+            rc.secondPassFramebuffers = createFramebuffers(rc.secondRenderPass, attachments);
         }
     }
     else
@@ -390,12 +1189,12 @@ void ForwardRenderer::CreateFramebuffers()
         if (msaaEnabled)
         {
             std::vector<VkImageView> attachments = { rc.colorTarget.views[0], VK_NULL_HANDLE /* for swapchain RT */, rc.depthTarget.views[0] };
-            rc.framebuffers = VulkanUtils::CreateFramebuffers(rc.renderPass, swapchain, attachments, *vulkanContext);
+            rc.framebuffers = createFramebuffers(rc.renderPass, attachments);
         }
         else
         {
             std::vector<VkImageView> attachments = { VK_NULL_HANDLE /* for swapchain RT */, rc.depthTarget.views[0] };
-            rc.framebuffers = VulkanUtils::CreateFramebuffers(rc.renderPass, swapchain, attachments, *vulkanContext);
+            rc.framebuffers = createFramebuffers(rc.renderPass, attachments);
         }
     }
 }
@@ -405,10 +1204,13 @@ void ForwardRenderer::DestroyFramebuffers()
     VulkanUtils::DestroyFramebuffers(renderContext.framebuffers, *vulkanContext);
     VulkanUtils::DestroyFramebuffers(renderContext.firstPassFramebuffers, *vulkanContext);
     VulkanUtils::DestroyFramebuffers(renderContext.secondPassFramebuffers, *vulkanContext);
+    VulkanUtils::DestroyFramebuffers(renderContext.visibilityResolveFramebuffers, *vulkanContext);
 }
 
 void ForwardRenderer::Reinitialize()
 {
+    RenderStage::CancelPrecompilation(renderStages); // Variants of the jobs refer to the render passes
+    
     vulkanContext->GetDevice().WaitIdle();
     
     DestroyFramebuffers();
@@ -419,6 +1221,9 @@ void ForwardRenderer::Reinitialize()
     CreateRenderTargets();
     CreateFramebuffers();
     
+    // Pipelines built with the previous render passes can't be used with the new ones
+    requiredPipelinesBuilt = false;
+    
     OnTryReloadShaders();
 }
 
@@ -436,12 +1241,30 @@ void ForwardRenderer::OnSwapchainRecreated()
 
 void ForwardRenderer::OnTryReloadShaders()
 {
-    if (std::ranges::all_of(renderStages, &RenderStage::TryRebuildPipelines))
+    using namespace ForwardRendererDetails;
+    
+    // Rebuild would wait for pending jobs on the thread pool, the finished ones have already filled the caches
+    RenderStage::CancelPrecompilation(renderStages);
+    
+    if (RenderStage::TryRebuildPipelines(renderStages))
     {
         vulkanContext->GetDevice().WaitIdle();
         vulkanContext->GetDescriptorSetsManager().ResetDescriptors(DescriptorScope::eSceneRenderer);
         
         std::ranges::for_each(renderStages, &RenderStage::ApplyRebuiltPipelines);
+        
+        RenderStage::PrecompilePipelines(renderStages, GetLikelyPipelineVariants());
+        
+        requiredPipelinesBuilt = true;
+        return;
+    }
+    
+    // Previous pipelines are kept, but the ones newly required by an option change have no shaders to be built from
+    requiredPipelinesBuilt = requiredPipelinesBuilt && RenderStage::HasRequiredPipelines(renderStages);
+    
+    if (!requiredPipelinesBuilt)
+    {
+        LogW << "Scene isn't rendered until all required pipelines are built\n";
     }
 }
 
@@ -451,30 +1274,36 @@ void ForwardRenderer::OnSceneOpen(const ES::SceneOpened& event)
 
     scene = &event.scene;
 
-    if (vulkanContext->GetDevice().GetProperties().meshShadersSupported)
+    const DeviceProperties& deviceProperties = vulkanContext->GetDevice().GetProperties();
+    
+    // Vertex pipeline culls meshlets too when it can draw them with indirect counts, see MeshletCull.comp
+    if (deviceProperties.meshShadersSupported || deviceProperties.drawIndirectCountSupported)
     {
         SceneHelpers::GenerateMeshlets(scene->GetRaw());
     }
 
-    ForwardRendererDetails::CreateSceneBuffers(scene->GetRaw(), renderContext, *vulkanContext);
-    ForwardRendererDetails::CreateIndirectBuffers(renderContext, *vulkanContext);
+    sceneCopyParams = ForwardRendererDetails::CreateSceneBuffers(scene->GetRaw(), sceneCopyTranslations, renderContext,
+        *vulkanContext);
     
     UploadFromStagingBuffers(*vulkanContext, Barriers::transferWriteToComputeRead, /* destroyStagingBuffers */ true,
         renderContext.vertexBuffer,
         renderContext.indexBuffer,
         renderContext.primitiveBuffer,
-        renderContext.drawBuffer,
+        renderContext.primitiveBoundsBuffer,
+        renderContext.clusterDispatchBuffer,
         renderContext.commandCountBuffer);
     
     if (renderContext.meshletDataBuffer.IsValid())
     {
         UploadFromStagingBuffers(*vulkanContext, Barriers::transferWriteToComputeRead, /* destroyStagingBuffers */ true,
             renderContext.meshletDataBuffer,
-            renderContext.meshletBuffer);
+            renderContext.meshletBuffer,
+            renderContext.meshletBoundsBuffer);
     }
     
     vulkanContext->GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
         vkCmdFillBuffer(cmd, renderContext.drawsVisibilityBuffer, 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(cmd, renderContext.clusterVisibilityBuffer, 0, VK_WHOLE_SIZE, 0);
         SynchronizationUtils::SetMemoryBarrier(cmd, Barriers::transferWriteToComputeRead);
     });
     
@@ -493,12 +1322,35 @@ void ForwardRenderer::OnSceneClose()
     {
         renderContext.meshletDataBuffer = {};
         renderContext.meshletBuffer = {};
+        renderContext.meshletBoundsBuffer = {};
     }
 
     renderContext.primitiveBuffer = {};
+    renderContext.primitiveBoundsBuffer = {};
     renderContext.drawBuffer = {};
+    renderContext.visibleInstanceBuffer = {};
+    renderContext.instanceLodBuffer = {};
+    renderContext.drawClusterBuffer = {};
+    renderContext.clusterVisibilityBuffer = {};
+    renderContext.visibleClustersBuffer = {};
+    renderContext.clusterDispatchBuffer = {};
+    renderContext.drawBucketBuffer = {};
+    renderContext.instancedDrawBuffer = {};
+    renderContext.instanceBuffer = {};
+    renderContext.meshletDrawBuffer = {};
+    renderContext.meshletIndexBuffer = {};
     renderContext.commandCountBuffer = {};
     renderContext.commandBuffer = {};
+    renderContext.drawChunkBuffer = {};
+    renderContext.extraViewsBuffer = {};
+    renderContext.extraViewInstanceBuffer = {};
+    renderContext.extraViewCommandBuffer = {};
+    renderContext.lightBuffer = {};
+    renderContext.lightClusterBuffer = {};
+    renderContext.softwareRasterBuffer = {};
+    renderContext.softwareMeshletBuffer = {};
+    renderContext.impostorDrawBuffer = {};
+    renderContext.debugBoundsBuffer = {};
     
     std::ranges::for_each(renderStages, &RenderStage::OnSceneClose);
     
@@ -54,6 +54,23 @@ bool RenderOptions::IsMsaaSampleCountSupported(const VkSampleCountFlagBits sampl
         sampleCount <= vulkanContext->GetDevice().GetProperties().maxSampleCount;
 }
 
+bool RenderOptions::IsVisibilityBufferSupported(const bool visibilityBuffer) const
+{
+    return !visibilityBuffer || vulkanContext->GetDevice().GetProperties().geometryShaderSupported;
+}
+
+bool RenderOptions::IsSoftwareRasterizationSupported(const bool softwareRasterization) const
+{
+    const DeviceProperties& deviceProperties = vulkanContext->GetDevice().GetProperties();
+    
+    return !softwareRasterization || (deviceProperties.meshShadersSupported && deviceProperties.bufferInt64AtomicsSupported);
+}
+
+bool RenderOptions::IsMeshletCullingSupported(const bool meshletCulling) const
+{
+    return !meshletCulling || vulkanContext->GetDevice().GetProperties().drawIndirectCountSupported;
+}
+
 void RenderOptions::OnKeyInput(const ES::KeyInput& event)
 {
     if (event.key == Key::eV && event.action == KeyAction::ePress)
@@ -111,6 +128,16 @@ void RenderOptions::OnKeyInput(const ES::KeyInput& event)
         SetOcclusionCulling(!_OcclusionCulling);
     }
     
+    if (event.key == Key::eC && event.action == KeyAction::ePress)
+    {
+        SetClusterCulling(!_ClusterCulling);
+    }
+    
+    if (event.key == Key::eI && event.action == KeyAction::ePress)
+    {
+        SetInstancedDraws(!_InstancedDraws);
+    }
+    
     if (event.key == Key::eT && event.action == KeyAction::ePress)
     {
         SetTestBool(!_TestBool);
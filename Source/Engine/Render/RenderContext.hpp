@@ -18,14 +18,25 @@ struct RenderContext
     RenderPass renderPass;
     RenderPass firstRenderPass;
     RenderPass secondRenderPass;
+    RenderPass visibilityResolveRenderPass; // Passes above write visibility buffer instead, see ForwardUtils::UseVisibilityBuffer
     
     RenderTarget colorTarget;
     RenderTarget depthTarget;
     RenderTarget depthResolveTarget;
+    RenderTarget visibilityTarget;
+    RenderTarget sceneColorTarget; // Replaces swapchain in geometry passes with dynamic resolution, upscaled into it
+    
+    // Geometry passes render into the top left renderExtent part of the targets, see ForwardUtils::UpdateRenderScale
+    float renderScale = 1.0f;
+    VkExtent2D renderExtent = {};
+    
+    // Multiplies LOD target and contribution threshold, see ForwardUtils::UpdateDetailScale
+    float detailScale = 1.0f;
     
     std::vector<VkFramebuffer> framebuffers;
     std::vector<VkFramebuffer> firstPassFramebuffers;
     std::vector<VkFramebuffer> secondPassFramebuffers;
+    std::vector<VkFramebuffer> visibilityResolveFramebuffers;
 
     std::unordered_map<std::string_view, std::function<int()>> runtimeDefineGetters;
     gpu::PushConstants globals = { .view = Matrix4::identity, .projection = Matrix4::identity };
@@ -37,15 +48,54 @@ struct RenderContext
     // Mesh pipeline
     Buffer meshletDataBuffer;
     Buffer meshletBuffer;
+    Buffer meshletBoundsBuffer;
 
-    Buffer primitiveBuffer;
+    Buffer primitiveBuffer; // LOD table and geometry offsets of the primitives
+    Buffer primitiveBoundsBuffer; // Bounding spheres of the primitives, the only primitive data culling reads for every draw
 
     Buffer drawBuffer;
     Buffer drawsVisibilityBuffer;
     Buffer drawsDebugDataBuffer;
+    Buffer visibleInstanceBuffer; // Written by culling passes, read by draws instead of drawBuffer
+    Buffer instanceLodBuffer; // Primitive and LOD of visible instances for visibility buffer resolve with vertex pipeline
+    
+    // Cluster culling, see ClusterCull.comp
+    Buffer drawClusterBuffer;
+    Buffer clusterVisibilityBuffer;
+    Buffer visibleClustersBuffer;
+    Buffer clusterDispatchBuffer;
+    
+    // Instanced draws of vertex pipeline, see InstancedCommands.comp
+    Buffer drawBucketBuffer;
+    Buffer instancedDrawBuffer;
+    Buffer instanceBuffer;
+
+    // Meshlet culling of vertex pipeline, see MeshletCull.comp
+    Buffer meshletDrawBuffer; // gpu::MeshletDraws header, then indexed commands of visible meshlets
+    Buffer meshletIndexBuffer; // Triangles of visible meshlets, rewritten by every culling pass
 
     Buffer commandCountBuffer;
     Buffer commandBuffer; // Either indirect commands or task commands, see PrimitiveCull.comp & PrimitiveCullStage
+    Buffer drawChunkBuffer; // Splits command buffer into draws within device limits, see DrawChunks.comp
+    
+    // Views culled along with the main one, set by the renderer every frame, see gpu::ExtraViews
+    std::vector<gpu::ExtraView> extraViews;
+    Buffer extraViewsBuffer;
+    Buffer extraViewInstanceBuffer;
+    Buffer extraViewCommandBuffer;
+    
+    // Point and spot lights, set by the renderer every frame and binned into clusters, see LightCullStage
+    std::vector<gpu::Light> lights;
+    Buffer lightBuffer;
+    Buffer lightClusterBuffer;
+    
+    // Meshlets with subpixel triangles rasterized in compute, see SoftwareRasterStage
+    Buffer softwareRasterBuffer;
+    Buffer softwareMeshletBuffer;
+    Buffer softwareVisibilityBuffer; // Sized for the swapchain, created along with render targets
+    
+    Buffer impostorDrawBuffer; // Draws culling has switched to impostors, see gpu::ImpostorCommands & ImpostorStage
+    Buffer debugBoundsBuffer; // Visible draws for bounds visualization, see gpu::DebugBoundsCommands & DebugStage
     
     DebugData debugData;
 };
@@ -26,6 +26,9 @@ public:
     constexpr bool AlwaysSupported(std::any) { return true; }
     bool IsGraphicsPipelineTypeSupported(GraphicsPipelineType graphicsPipelineType) const;
     bool IsMsaaSampleCountSupported(VkSampleCountFlagBits sampleCount) const;
+    bool IsVisibilityBufferSupported(bool visibilityBuffer) const;
+    bool IsSoftwareRasterizationSupported(bool softwareRasterization) const;
+    bool IsMeshletCullingSupported(bool meshletCulling) const;
     
     // Getters and setters
     RENDER_OPTION(VSync, bool, true, AlwaysSupported)
@@ -34,13 +37,29 @@ public:
     RENDER_OPTION(UseLods, bool, true, AlwaysSupported)
     RENDER_OPTION(VisualizeLods, bool, false, AlwaysSupported)
     RENDER_OPTION(FreezeCamera, bool, false, AlwaysSupported)
-    RENDER_OPTION(CurrentDrawCount, uint32_t, gpu::primitiveCullMaxCommands, AlwaysSupported)
-    RENDER_OPTION(MaxDrawCount, uint32_t, gpu::primitiveCullMaxCommands, AlwaysSupported)
+    RENDER_OPTION(CurrentDrawCount, uint32_t, 0, AlwaysSupported) // Set from the scene on its opening
+    RENDER_OPTION(MaxDrawCount, uint32_t, 0, AlwaysSupported)
     RENDER_OPTION(MsaaSampleCount, VkSampleCountFlagBits, VK_SAMPLE_COUNT_1_BIT, IsMsaaSampleCountSupported)
     RENDER_OPTION(VisualizeBoundingSpheres, bool, false, AlwaysSupported)
     RENDER_OPTION(VisualizeBoundingRectangles, bool, false, AlwaysSupported)
     RENDER_OPTION(ShowExtraGpuTimings, bool, false, AlwaysSupported)
     RENDER_OPTION(OcclusionCulling, bool, true, AlwaysSupported)
+    RENDER_OPTION(ReprojectionOcclusion, bool, false, AlwaysSupported) // Previous depth pyramid in the first culling pass
+    RENDER_OPTION(SoftwareOcclusion, bool, true, AlwaysSupported) // Without reprojection: seed first pass on camera cuts
+    RENDER_OPTION(ClusterCulling, bool, true, AlwaysSupported) // Cull draw clusters first, then draws of visible ones
+    RENDER_OPTION(InstancedDraws, bool, false, AlwaysSupported) // Vertex pipeline: 1 instanced command per (primitive, LOD)
+    RENDER_OPTION(MeshletCulling, bool, false, IsMeshletCullingSupported) // Vertex pipeline: cull meshlets into index buffer
+    RENDER_OPTION(CpuCulling, bool, false, AlwaysSupported) // Without occlusion culling: cull draws on CPU, see CpuCuller
+    RENDER_OPTION(CpuCullingValidation, bool, false, AlwaysSupported) // GPU culling of CpuCuller features: log mismatches
+    RENDER_OPTION(ExtraViewCount, uint32_t, 0, AlwaysSupported) // Test views culled along with the main one
+    RENDER_OPTION(LightCount, uint32_t, 0, AlwaysSupported) // Test point and spot lights, see ForwardRenderer::Process
+    RENDER_OPTION(VisibilityBuffer, bool, false, IsVisibilityBufferSupported) // Without MSAA: shade once in a fullscreen resolve
+    RENDER_OPTION(SoftwareRasterization, bool, false, IsSoftwareRasterizationSupported) // Visibility buffer, mesh pipeline
+    RENDER_OPTION(Impostors, bool, false, AlwaysSupported) // Without visibility buffer: far draws as baked quads
+    RENDER_OPTION(DynamicResolution, bool, false, AlwaysSupported) // Without visibility buffer: scale to target GPU time
+    RENDER_OPTION(TargetGpuFrameMs, uint32_t, 16, AlwaysSupported) // For dynamic resolution and quality governor
+    RENDER_OPTION(QualityGovernor, bool, false, AlwaysSupported) // Coarser LODs and contribution culling to meet budgets
+    RENDER_OPTION(TriangleBudget, uint32_t, 0, AlwaysSupported) // For quality governor, thousands of triangles, 0 for none
     RENDER_OPTION(VisualizeDepth, bool, false, AlwaysSupported) // For HZB
     RENDER_OPTION(DepthMipToVisualize, uint32_t, 0, AlwaysSupported)
     RENDER_OPTION(MaxDepthMipToVisualize, uint32_t, 0, AlwaysSupported) // TODO: For UI, we need better max limit solution
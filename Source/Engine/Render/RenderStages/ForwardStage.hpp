@@ -9,6 +9,9 @@ public:
     ForwardStage(const VulkanContext& vulkanContext, RenderContext& renderContext);
     ~ForwardStage() override;
     
+    void CreateRenderTargetDependentResources() override;
+    void DestroyRenderTargetDependentResources() override;
+    
     void OnSceneOpen(const Scene& scene) override;
     void OnSceneClose() override;
     
@@ -20,10 +23,12 @@ private:
     Pipeline BuildMeshPipeline();
     Pipeline BuildVertexPipeline();
     void BuildDescriptors();
+    void BuildSoftwareVisibilityDescriptor();
     
     void ExecuteMesh(const Frame& frame) const;
     void ExecuteVertex(const Frame& frame) const;
     
     std::unordered_map<GraphicsPipelineType, Pipeline> graphicsPipelines;
     std::unordered_map<GraphicsPipelineType, std::vector<VkDescriptorSet>> descriptors;
+    VkDescriptorSet softwareVisibilityDescriptor = VK_NULL_HANDLE; // Mesh pipeline with software rasterization only
 };
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Engine/Render/RenderStages/RenderStage.hpp"
+#include "Engine/Render/Vulkan/Image/Sampler.hpp"
+#include "Engine/Render/Vulkan/Pipelines/Pipeline.hpp"
+
+// Draws far draws as single quads textured with baked views of their primitives, see Impostors/Impostor.h
+// Views are baked on scene opening into an atlas of normal and depth, culling passes append draws below
+// IMPOSTOR_THRESHOLD to RenderContext::impostorDrawBuffer instead of emitting their geometry
+class ImpostorStage : public RenderStage
+{
+public:
+    ImpostorStage(const VulkanContext& vulkanContext, RenderContext& renderContext);
+    ~ImpostorStage() override;
+    
+    void OnSceneOpen(const Scene& scene) override;
+    void OnSceneClose() override;
+    
+    void Execute(const Frame& frame) override; // First pass impostors, or all of them without occlusion culling
+    void ExecuteSecondPass(const Frame& frame);
+    
+    void RebuildDescriptors() override;
+    
+private:
+    Pipeline BuildPipeline() const;
+    void BuildDescriptors();
+    
+    void BakeAtlas(const RawScene& rawScene);
+    void Draw(const Frame& frame, VkDeviceSize commandOffset) const;
+    
+    Pipeline pipeline;
+    std::vector<VkDescriptorSet> descriptors;
+    
+    RenderTarget atlas;
+    Sampler atlasSampler;
+};
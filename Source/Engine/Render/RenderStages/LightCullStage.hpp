@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Engine/Render/RenderStages/RenderStage.hpp"
+#include "Engine/Render/Vulkan/Pipelines/Pipeline.hpp"
+
+// Bins RenderContext::lights into the view space froxel grid (see gpu::LightGrid), so shading iterates only over
+// the lights of its cluster, see LightCull.comp and Lighting.glsl
+// Executed outside of render passes before the forward stage, clusters are visible to fragment shaders after it
+class LightCullStage : public RenderStage
+{
+public:
+    LightCullStage(const VulkanContext& vulkanContext, RenderContext& renderContext);
+    ~LightCullStage() override;
+    
+    void OnSceneOpen(const Scene& scene) override;
+    void OnSceneClose() override;
+    
+    void Execute(const Frame& frame) override;
+    
+    void RebuildDescriptors() override;
+    
+private:
+    Pipeline BuildPipeline() const;
+    void BuildDescriptors();
+    
+    gpu::LightGrid CalculateLightGrid() const;
+    
+    Pipeline pipeline;
+    std::vector<VkDescriptorSet> descriptors;
+    
+    std::vector<Buffer> uploadBuffers; // Per frame in flight, sized for gpu::Lights
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Engine/Render/Culling/CpuCuller.hpp"
+#include "Engine/Render/Culling/SoftwareOcclusionCuller.hpp"
 #include "Engine/Render/RenderStages/RenderStage.hpp"
 #include "Engine/Render/Vulkan/Pipelines/Pipeline.hpp"
 
@@ -24,10 +26,57 @@ public:
     void ExecuteSecondPass(const Frame& frame);
     
     void VisualizeDepth(const Frame& frame);
+    
+    // Copies draw counters of this frame to its readback buffer, call after all culling passes
+    void CopyDrawCounters(const Frame& frame);
+    void GatherFrameStats(const Frame& frame, FrameRenderStats& renderStats);
 
 private:
-    Pipeline BuildPipeline(bool occlusionCulling = true, bool firstPass = true) const;
+    Pipeline BuildPipeline(bool occlusionCulling = true, bool firstPass = true, bool reprojection = false) const;
     std::vector<VkDescriptorSet> BuildDescriptors(const Pipeline& pipeline);
+    void BuildPassDescriptors();
+    
+    Pipeline BuildClusterCullPipeline(bool occlusionCulling = true, bool firstPass = true, bool reprojection = false) const;
+    std::vector<VkDescriptorSet> BuildClusterCullDescriptors(const Pipeline& pipeline);
+    
+    Pipeline BuildInstancedCommandsPipeline(bool commandPass) const;
+    void BuildInstancedCommandsDescriptors();
+    
+    Pipeline BuildDrawChunksPipeline() const;
+    void BuildDrawChunksDescriptors();
+    
+    Pipeline BuildMeshletCullPipeline(bool occlusionCulling) const;
+    std::vector<VkDescriptorSet> BuildMeshletCullDescriptors(const Pipeline& pipeline);
+    
+    // Resets counters and outputs before culling pass
+    void ClearCullingBuffers(VkCommandBuffer cmd, bool clearDrawCounters);
+    // Uploads views of RenderContext::extraViews, call before the pass which culls them (see EXTRA_VIEWS in Culling.glsl)
+    void UpdateExtraViews(VkCommandBuffer cmd) const;
+    // Dispatches cluster culling (if enabled), primitive culling for the draws of visible clusters, instanced commands
+    // generation (if enabled), meshlet culling (if enabled) and draw chunks generation, then makes the output visible to the draws
+    void DispatchCulling(VkCommandBuffer cmd, const Pipeline& clusterPipeline, std::span<const VkDescriptorSet> clusterDescriptors,
+        const Pipeline& cullPipeline, std::span<const VkDescriptorSet> cullDescriptors, bool secondPass = false) const;
+    // Culls meshlets of the task commands of the pass into indexed commands, see MeshletCull.comp
+    void DispatchMeshletCulling(VkCommandBuffer cmd, bool secondPass) const;
+    // Splits commands of the pass into draws within device limits, see DrawChunks.comp
+    void DispatchDrawChunks(VkCommandBuffer cmd) const;
+    
+    // Culls draws on CPU and uploads the results in the formats PrimitiveCull.comp writes, then generates draw chunks
+    void ExecuteCpuCulling(const Frame& frame);
+    void CreateCpuCuller();
+    
+    // Reads back visible draws of GPU culling and culls the same globals on CPU when the frame is gathered, mismatches
+    // are logged, see RenderOptions::CpuCullingValidation
+    void CopyValidationData(const Frame& frame);
+    void ValidateCpuCulling(const Frame& frame);
+    
+    // Overwrites visibility of the previous frame with software occlusion culling results, call after ClearCullingBuffers
+    void SeedVisibility(const Frame& frame);
+    
+    // Previous frame's upload buffer with this index has finished, so it can be replaced when it's too small
+    Buffer& GetUploadBuffer(uint32_t frameIndex, size_t size);
+    
+    void CreateDrawCountersBuffers();
     
     void CreateDepthPyramidRenderTargetAndSampler();
     Pipeline BuildDepthPyramidPipeline() const;
@@ -39,6 +88,11 @@ private:
     Pipeline firstPassPipeline;
     std::vector<VkDescriptorSet> firstPassDescriptors;
     
+    Pipeline reprojectionFirstPassPipeline;
+    std::vector<VkDescriptorSet> reprojectionFirstPassDescriptors;
+    Buffer reprojectionDataBuffer;
+    gpu::ReprojectionData reprojectionData = {}; // Data of the view current depth pyramid was built with
+    
     RenderTarget depthPyramidRenderTarget;
     Sampler depthPyramidSampler;
     Pipeline depthPyramidPipeline;
@@ -47,4 +101,51 @@ private:
     
     Pipeline secondPassPipeline;
     std::vector<VkDescriptorSet> secondPassDescriptors;
+    
+    Pipeline clusterCullPipeline;
+    std::vector<VkDescriptorSet> clusterCullDescriptors;
+    
+    Pipeline clusterFirstPassPipeline;
+    std::vector<VkDescriptorSet> clusterFirstPassDescriptors;
+    
+    Pipeline clusterReprojectionFirstPassPipeline;
+    std::vector<VkDescriptorSet> clusterReprojectionFirstPassDescriptors;
+    
+    Pipeline clusterSecondPassPipeline;
+    std::vector<VkDescriptorSet> clusterSecondPassDescriptors;
+    
+    Pipeline instancedCommandsPipeline;
+    std::vector<VkDescriptorSet> instancedCommandsDescriptors;
+    
+    Pipeline instancesPipeline;
+    std::vector<VkDescriptorSet> instancesDescriptors;
+    
+    Pipeline drawChunksPipeline;
+    std::vector<VkDescriptorSet> drawChunksDescriptors;
+    std::vector<VkDescriptorSet> meshletDrawChunksDescriptors; // Counts meshlet commands instead
+    
+    Pipeline meshletCullPipeline; // Without occlusion culling and in the first pass
+    std::vector<VkDescriptorSet> meshletCullDescriptors;
+    
+    Pipeline meshletCullSecondPassPipeline;
+    std::vector<VkDescriptorSet> meshletCullSecondPassDescriptors;
+    
+    Buffer drawCountersBuffer;
+    std::vector<Buffer> drawCountersReadbackBuffers; // Per frame in flight
+    
+    const Scene* scene = nullptr;
+    std::vector<gpu::Draw> sceneDraws; // Read back from the draw buffer on scene open
+    std::vector<gpu::DrawCluster> sceneDrawClusters;
+    std::vector<Buffer> uploadBuffers; // Per frame in flight, grown on demand
+    
+    std::unique_ptr<CpuCuller> cpuCuller; // Created on first use of CPU culling
+    CpuCullingOutput cpuCullingOutput;
+    
+    std::vector<Buffer> validationReadbackBuffers; // Per frame in flight, created on first use of validation
+    std::vector<std::optional<gpu::PushConstants>> validationGlobals; // Empty for frames which weren't validated
+    
+    std::unique_ptr<SoftwareOcclusionCuller> softwareOcclusionCuller; // Created on first camera cut
+    std::vector<uint32_t> seededDrawsVisibility;
+    std::vector<uint32_t> seededClusterVisibility;
+    std::optional<glm::mat4> previousCullView; // Empty when visibility of the previous frame is unusable
 };
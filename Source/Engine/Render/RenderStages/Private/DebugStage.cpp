@@ -2,10 +2,12 @@
 
 #include "Engine/Render/RenderOptions.hpp"
 #include "Engine/Render/Utils/MeshUtils.hpp"
+#include "Engine/Render/Utils/ForwardUtils.hpp"
 #include "Engine/Render/Vulkan/VulkanUtils.hpp"
 #include "Engine/Render/Vulkan/Buffer/BufferUtils.hpp"
 #include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
 #include "Engine/Render/Vulkan/Pipelines/GraphicsPipelineBuilder.hpp"
+#include "Engine/Render/Vulkan/Synchronization/SynchronizationUtils.hpp"
 
 namespace DebugStageDetails
 {
@@ -28,9 +30,13 @@ namespace DebugStageDetails
         4,5, 5,6, 6,7, 7,4,    // Far
         0,4, 1,5, 2,6, 3,7, }; // Connections
 
+    // Drawn once per visible draw, so it's kept low poly
+    static constexpr uint32_t unitSphereStacks = 8;
+    static constexpr uint32_t unitSphereSectors = 12;
+
     static std::tuple<Buffer, Buffer, uint32_t> CreateUnitSphereBuffers(const VulkanContext& vulkanContext)
     {
-        const auto [vertices, indices] = MeshUtils::GenerateSphereMesh(100, 100);
+        const auto [vertices, indices] = MeshUtils::GenerateSphereMesh(unitSphereStacks, unitSphereSectors);
         const auto sphereIndexCount = static_cast<uint32_t>(indices.size());
         
         const auto verticesSpan = std::span(vertices);
@@ -86,6 +92,17 @@ namespace DebugStageDetails
         
         return { std::move(frustumVertexBuffer), std::move(frustumIndexBuffer) };
     }
+    
+    // Debug objects are drawn over the shaded scene: after the last geometry pass or in the visibility resolve pass
+    static VkRenderPass GetRenderPass(const RenderStage::PipelineVariant& variant)
+    {
+        if (variant.GetDefine(gpu::defines::visibilityBuffer))
+        {
+            return variant.visibilityResolveRenderPass;
+        }
+        
+        return variant.occlusionCulling ? variant.secondRenderPass : variant.renderPass;
+    }
 }
 
 DebugStage::DebugStage(const VulkanContext& aVulkanContext, RenderContext& aRenderContext)
@@ -114,6 +131,16 @@ DebugStage::~DebugStage()
 
 void DebugStage::OnSceneOpen(const Scene& scene)
 {
+    // Culling passes only reset and append instance counts
+    const gpu::DebugBoundsCommands debugBoundsCommands = {
+        .spheres = { unitSphereIndexCount, 0, 0, 0, 0 },
+        .rectangles = { static_cast<uint32_t>(DebugStageDetails::quadIndices.size()), 0, 0, 0, 0 } };
+    
+    vulkanContext->GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
+        vkCmdUpdateBuffer(cmd, renderContext->debugBoundsBuffer, 0, sizeof(gpu::DebugBoundsCommands), &debugBoundsCommands);
+        SynchronizationUtils::SetMemoryBarrier(cmd, Barriers::transferWriteToComputeReadWrite);
+    });
+    
     BuildBoundingSphereDescriptors();
     BuildBoundingRectangleDescriptors();
 }
@@ -164,10 +191,9 @@ void DebugStage::ExecuteBoundingSpheres(const Frame& frame)
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
     vkCmdBindIndexBuffer(commandBuffer, unitSphereIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
     
-    for (uint32_t i = 0; i < renderContext->globals.drawCount; ++i)
-    {
-        vkCmdDrawIndexed(commandBuffer, unitSphereIndexCount, 1, 0, 0, i);
-    }
+    // 1 instance per draw culling found visible, see gpu::DebugBoundsCommands
+    vkCmdDrawIndexedIndirect(commandBuffer, renderContext->debugBoundsBuffer, offsetof(gpu::DebugBoundsCommands, spheres),
+        1, sizeof(gpu::VkDrawIndexedIndirectCommand));
 }
 
 void DebugStage::ExecuteBoundingRectangles(const Frame &frame)
@@ -190,10 +216,8 @@ void DebugStage::ExecuteBoundingRectangles(const Frame &frame)
 
     vkCmdBindIndexBuffer(commandBuffer, quadIndexBuffer, 0, VK_INDEX_TYPE_UINT16);
     
-    for (uint32_t i = 0; i < renderContext->globals.drawCount; ++i)
-    {
-        vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(DebugStageDetails::quadIndices.size()), 1, 0, 0, i);
-    }
+    vkCmdDrawIndexedIndirect(commandBuffer, renderContext->debugBoundsBuffer, offsetof(gpu::DebugBoundsCommands, rectangles),
+        1, sizeof(gpu::VkDrawIndexedIndirectCommand));
 }
 
 void DebugStage::ExecuteFrozenFrustum(const Frame& frame)
@@ -230,6 +254,8 @@ Pipeline DebugStage::BuildBoundingSpherePipeline()
 {
     using namespace DebugStageDetails;
     
+    const PipelineVariant& variant = GetPipelineVariant();
+    
     std::vector<ShaderModule> shaders;
     
     shaders.push_back(GetShader(boundingSphereVertexPath, VK_SHADER_STAGE_VERTEX_BIT, {}, {}));
@@ -241,9 +267,9 @@ Pipeline DebugStage::BuildBoundingSpherePipeline()
         .SetInputTopology(InputTopology::eTriangleList)
         .SetPolygonMode(PolygonMode::eFill)
         .SetCullMode(CullMode::eNone)
-        .SetMultisampling(RenderOptions::Get().GetMsaaSampleCount())
+        .SetMultisampling(variant.sampleCount)
         .SetDepthState(true, false, VK_COMPARE_OP_GREATER_OR_EQUAL)
-        .SetRenderPass(RenderOptions::Get().GetOcclusionCulling() ? renderContext->secondRenderPass : renderContext->renderPass)
+        .SetRenderPass(GetRenderPass(variant))
         .EnableBlending()
         .Build();
 }
@@ -255,7 +281,8 @@ void DebugStage::BuildBoundingSphereDescriptors()
     boundingSphereDescriptors = vulkanContext->GetDescriptorSetsManager()
         .GetReflectiveDescriptorSetBuilder(boundingSpherePipeline, DescriptorScope::eSceneRenderer)
         .Bind("Draws", renderContext->drawBuffer)
-        .Bind("Primitives", renderContext->primitiveBuffer)
+        .Bind("PrimitiveBoundsBuffer", renderContext->primitiveBoundsBuffer)
+        .Bind("DebugBoundsBuffer", renderContext->debugBoundsBuffer)
         .Build();
 }
 
@@ -263,6 +290,8 @@ Pipeline DebugStage::BuildBoundingRectanglePipeline()
 {
     using namespace DebugStageDetails;
     
+    const PipelineVariant& variant = GetPipelineVariant();
+    
     std::vector<ShaderModule> shaders;
     
     shaders.push_back(GetShader(boundingRectangleVertexPath, VK_SHADER_STAGE_VERTEX_BIT, {}, {}));
@@ -273,8 +302,8 @@ Pipeline DebugStage::BuildBoundingRectanglePipeline()
         .SetInputTopology(InputTopology::eTriangleStrip)
         .SetPolygonMode(PolygonMode::eFill)
         .SetCullMode(CullMode::eNone)
-        .SetMultisampling(RenderOptions::Get().GetMsaaSampleCount())
-        .SetRenderPass(RenderOptions::Get().GetOcclusionCulling() ? renderContext->secondRenderPass : renderContext->renderPass)
+        .SetMultisampling(variant.sampleCount)
+        .SetRenderPass(GetRenderPass(variant))
         .EnableBlending()
         .Build();
 }
@@ -286,7 +315,8 @@ void DebugStage::BuildBoundingRectangleDescriptors()
     boundingRectangleDescriptors = vulkanContext->GetDescriptorSetsManager()
         .GetReflectiveDescriptorSetBuilder(boundingRectanglePipeline, DescriptorScope::eSceneRenderer)
         .Bind("Draws", renderContext->drawBuffer)
-        .Bind("Primitives", renderContext->primitiveBuffer)
+        .Bind("PrimitiveBoundsBuffer", renderContext->primitiveBoundsBuffer)
+        .Bind("DebugBoundsBuffer", renderContext->debugBoundsBuffer)
         .Build();
 }
 
@@ -294,6 +324,8 @@ Pipeline DebugStage::BuildLinePipeline()
 {
     using namespace DebugStageDetails;
     
+    const PipelineVariant& variant = GetPipelineVariant();
+    
     std::vector<ShaderModule> shaders;
     
     shaders.push_back(GetShader(lineVertexPath, VK_SHADER_STAGE_VERTEX_BIT, {}, {}));
@@ -303,8 +335,8 @@ Pipeline DebugStage::BuildLinePipeline()
         .SetShaderModules(shaders)
         .SetVertexData({ std::from_range, bindings }, { std::from_range, attributes })
         .SetInputTopology(InputTopology::eLineList)
-        .SetMultisampling(RenderOptions::Get().GetMsaaSampleCount())
+        .SetMultisampling(variant.sampleCount)
         .SetDepthState(true, false, VK_COMPARE_OP_GREATER_OR_EQUAL)
-        .SetRenderPass(RenderOptions::Get().GetOcclusionCulling() ? renderContext->secondRenderPass : renderContext->renderPass)
+        .SetRenderPass(GetRenderPass(variant))
         .Build();
 }
@@ -2,6 +2,7 @@
 
 #include "Engine/Scene/SceneHelpers.hpp"
 #include "Engine/Render/RenderOptions.hpp"
+#include "Engine/Render/Utils/ForwardUtils.hpp"
 #include "Engine/Render/Vulkan/VulkanUtils.hpp"
 #include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
 #include "Engine/Render/Vulkan/Pipelines/GraphicsPipelineBuilder.hpp"
@@ -12,22 +13,59 @@ namespace ForwardStageDetails
     static constexpr std::string_view taskShaderPath = "~/Shaders/Meshlet.task";
     static constexpr std::string_view meshShaderPath = "~/Shaders/Meshlet.mesh";
     static constexpr std::string_view fragmentShaderPath = "~/Shaders/Default.frag";
+    static constexpr std::string_view visibilityFragmentShaderPath = "~/Shaders/Visibility/Visibility.frag";
+    
+    // Pipeline requirement, only the pipeline of the current type is built, see RenderStage::AddPipeline
+    template <GraphicsPipelineType type>
+    static bool IsPipelineType()
+    {
+        return RenderOptions::Get().GetGraphicsPipelineType() == type;
+    }
+    
+    static std::string_view GetFragmentShaderPath(const RenderStage::PipelineVariant& variant)
+    {
+        return variant.GetDefine(gpu::defines::visibilityBuffer) ? visibilityFragmentShaderPath : fragmentShaderPath;
+    }
+    
+    // Clustered lights are shaded by Default.frag only, visibility buffer resolve shades them instead
+    static void BindLights(const Pipeline& pipeline, ReflectiveDescriptorSetBuilder& builder, const RenderContext& renderContext)
+    {
+        if (pipeline.HasBinding("LightsBuffer"))
+        {
+            builder.Bind("LightsBuffer", renderContext.lightBuffer);
+            builder.Bind("LightClustersBuffer", renderContext.lightClusterBuffer);
+        }
+    }
 }
 
 ForwardStage::ForwardStage(const VulkanContext& aVulkanContext, RenderContext& aRenderContext)
     : RenderStage{ aVulkanContext, aRenderContext }
 {
+    using namespace ForwardStageDetails;
+    
     if (vulkanContext->GetDevice().GetProperties().meshShadersSupported)
     {
-        AddPipeline(graphicsPipelines[GraphicsPipelineType::eMesh], [&]() { return BuildMeshPipeline(); });
+        AddPipeline(graphicsPipelines[GraphicsPipelineType::eMesh], [&]() { return BuildMeshPipeline(); },
+            IsPipelineType<GraphicsPipelineType::eMesh>);
     }
     
-    AddPipeline(graphicsPipelines[GraphicsPipelineType::eVertex], [&]() { return BuildVertexPipeline(); });
+    AddPipeline(graphicsPipelines[GraphicsPipelineType::eVertex], [&]() { return BuildVertexPipeline(); },
+        IsPipelineType<GraphicsPipelineType::eVertex>);
 }
 
 ForwardStage::~ForwardStage()
 {}
 
+void ForwardStage::CreateRenderTargetDependentResources()
+{
+    BuildSoftwareVisibilityDescriptor();
+}
+
+void ForwardStage::DestroyRenderTargetDependentResources()
+{
+    softwareVisibilityDescriptor = VK_NULL_HANDLE;
+}
+
 void ForwardStage::OnSceneOpen(const Scene& scene)
 {
     BuildDescriptors();
@@ -59,6 +97,12 @@ void ForwardStage::Execute(const Frame& frame)
 
     if (pipelineType == GraphicsPipelineType::eMesh)
     {
+        if (softwareVisibilityDescriptor != VK_NULL_HANDLE)
+        {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.GetLayout(), 1,
+                1, &softwareVisibilityDescriptor, 0, nullptr);
+        }
+        
         ExecuteMesh(frame);
     }
     else
@@ -70,28 +114,34 @@ void ForwardStage::Execute(const Frame& frame)
 void ForwardStage::RebuildDescriptors()
 {
     descriptors.clear();
+    softwareVisibilityDescriptor = VK_NULL_HANDLE;
     
     BuildDescriptors();
+    BuildSoftwareVisibilityDescriptor();
 }
 
 Pipeline ForwardStage::BuildMeshPipeline()
 {
     using namespace ForwardStageDetails;
     
+    const PipelineVariant& variant = GetPipelineVariant();
+    
     std::vector<ShaderModule> shaders;
     
-    std::vector runtimeDefines = { gpu::defines::visualizeLods };
+    std::vector runtimeDefines = { gpu::defines::visualizeLods, gpu::defines::softwareRasterization };
+    std::vector taskRuntimeDefines = { gpu::defines::taskChunkSize, gpu::defines::softwareRasterization };
+    std::vector meshRuntimeDefines = { gpu::defines::visibilityBuffer, gpu::defines::softwareRasterization };
     
-    shaders.push_back(GetShader(taskShaderPath, VK_SHADER_STAGE_TASK_BIT_EXT, {}, {}));
-    shaders.push_back(GetShader(meshShaderPath, VK_SHADER_STAGE_MESH_BIT_EXT, {}, {}));
-    shaders.push_back(GetShader(fragmentShaderPath, VK_SHADER_STAGE_FRAGMENT_BIT, runtimeDefines, {}));
+    shaders.push_back(GetShader(taskShaderPath, VK_SHADER_STAGE_TASK_BIT_EXT, taskRuntimeDefines, {}));
+    shaders.push_back(GetShader(meshShaderPath, VK_SHADER_STAGE_MESH_BIT_EXT, meshRuntimeDefines, {}));
+    shaders.push_back(GetShader(GetFragmentShaderPath(variant), VK_SHADER_STAGE_FRAGMENT_BIT, runtimeDefines, {}));
 
     return GraphicsPipelineBuilder(*vulkanContext)
         .SetShaderModules(shaders)
         .SetPolygonMode(PolygonMode::eFill)
-        .SetMultisampling(RenderOptions::Get().GetMsaaSampleCount())
+        .SetMultisampling(variant.sampleCount)
         .SetDepthState(true, true, VK_COMPARE_OP_GREATER_OR_EQUAL)
-        .SetRenderPass(RenderOptions::Get().GetOcclusionCulling() ? renderContext->firstRenderPass : renderContext->renderPass)
+        .SetRenderPass(variant.occlusionCulling ? variant.firstRenderPass : variant.renderPass)
         .Build();
 }
 
@@ -99,12 +149,16 @@ Pipeline ForwardStage::BuildVertexPipeline()
 {
     using namespace ForwardStageDetails;
     
+    const PipelineVariant& variant = GetPipelineVariant();
+    
     std::vector runtimeDefines = { gpu::defines::visualizeLods };
+    std::vector vertexRuntimeDefines = { gpu::defines::visualizeLods, gpu::defines::instancedDraws,
+        gpu::defines::visibilityBuffer };
     
     std::vector<ShaderModule> shaders;
     
-    shaders.push_back(GetShader(vertexShaderPath, VK_SHADER_STAGE_VERTEX_BIT, runtimeDefines, {}));
-    shaders.push_back(GetShader(fragmentShaderPath, VK_SHADER_STAGE_FRAGMENT_BIT, runtimeDefines, {}));
+    shaders.push_back(GetShader(vertexShaderPath, VK_SHADER_STAGE_VERTEX_BIT, vertexRuntimeDefines, {}));
+    shaders.push_back(GetShader(GetFragmentShaderPath(variant), VK_SHADER_STAGE_FRAGMENT_BIT, runtimeDefines, {}));
     
     return GraphicsPipelineBuilder(*vulkanContext)
         .SetShaderModules(shaders)
@@ -112,63 +166,158 @@ Pipeline ForwardStage::BuildVertexPipeline()
         .SetInputTopology(InputTopology::eTriangleList)
         .SetPolygonMode(PolygonMode::eFill)
         .SetCullMode(CullMode::eBack, false)
-        .SetMultisampling(RenderOptions::Get().GetMsaaSampleCount())
+        .SetMultisampling(variant.sampleCount)
         .SetDepthState(true, true, VK_COMPARE_OP_GREATER_OR_EQUAL)
-        .SetRenderPass(RenderOptions::Get().GetOcclusionCulling() ? renderContext->firstRenderPass : renderContext->renderPass)
+        .SetRenderPass(variant.occlusionCulling ? variant.firstRenderPass : variant.renderPass)
         .Build();
 }
 
 void ForwardStage::BuildDescriptors()
 {
+    using namespace ForwardStageDetails;
+    
     Assert(descriptors.empty());
     
-    if (graphicsPipelines.contains(GraphicsPipelineType::eMesh))
+    if (graphicsPipelines.contains(GraphicsPipelineType::eMesh) && graphicsPipelines[GraphicsPipelineType::eMesh].IsValid())
     {
-        descriptors[GraphicsPipelineType::eMesh] = vulkanContext->GetDescriptorSetsManager()
+        ReflectiveDescriptorSetBuilder meshBuilder = vulkanContext->GetDescriptorSetsManager()
             .GetReflectiveDescriptorSetBuilder(graphicsPipelines[GraphicsPipelineType::eMesh], DescriptorScope::eSceneRenderer)
             .Bind("Vertices", renderContext->vertexBuffer)
             .Bind("MeshletData32", renderContext->meshletDataBuffer)
             .Bind("Meshlets", renderContext->meshletBuffer)
-            .Bind("Draws", renderContext->drawBuffer)
-            .Bind("TaskCommands", renderContext->commandBuffer)
-            .Build();
+            .Bind("VisibleInstances", renderContext->visibleInstanceBuffer)
+            .Bind("TaskCommands", renderContext->commandBuffer);
+        
+        BindLights(graphicsPipelines[GraphicsPipelineType::eMesh], meshBuilder, *renderContext);
+        
+        // Meshlets with subpixel triangles are appended for SoftwareRasterStage by task shaders
+        if (graphicsPipelines[GraphicsPipelineType::eMesh].HasBinding("SoftwareMeshlets"))
+        {
+            meshBuilder.Bind("MeshletBoundsBuffer", renderContext->meshletBoundsBuffer);
+            meshBuilder.Bind("SoftwareRasterBuffer", renderContext->softwareRasterBuffer);
+            meshBuilder.Bind("SoftwareMeshlets", renderContext->softwareMeshletBuffer);
+        }
+        
+        descriptors[GraphicsPipelineType::eMesh] = meshBuilder.Build();
+    }
+    
+    if (!graphicsPipelines[GraphicsPipelineType::eVertex].IsValid())
+    {
+        return;
     }
     
     ReflectiveDescriptorSetBuilder builder = vulkanContext->GetDescriptorSetsManager()
         .GetReflectiveDescriptorSetBuilder(graphicsPipelines[GraphicsPipelineType::eVertex], DescriptorScope::eSceneRenderer)
-        .Bind("Draws", renderContext->drawBuffer);
+        .Bind("VisibleInstances", renderContext->visibleInstanceBuffer);
     
-    if (RenderOptions::Get().GetVisualizeLods())
+    BindLights(graphicsPipelines[GraphicsPipelineType::eVertex], builder, *renderContext);
+    
+    // Visibility buffer resolve colors LODs instead
+    if (graphicsPipelines[GraphicsPipelineType::eVertex].HasBinding("DrawsDebugData"))
     {
         builder.Bind("DrawsDebugData", renderContext->drawsDebugDataBuffer);
     }
     
+    if (graphicsPipelines[GraphicsPipelineType::eVertex].HasBinding("Instances"))
+    {
+        builder.Bind("Instances", renderContext->instanceBuffer);
+    }
+    
     descriptors[GraphicsPipelineType::eVertex] = builder.Build();
 }
 
+void ForwardStage::BuildSoftwareVisibilityDescriptor()
+{
+    Assert(softwareVisibilityDescriptor == VK_NULL_HANDLE);
+    
+    const auto it = graphicsPipelines.find(GraphicsPipelineType::eMesh);
+    
+    // Hardware rasterized depth is merged into the software visibility buffer, see Visibility.frag
+    if (it != graphicsPipelines.end() && it->second.IsValid() && it->second.HasBinding("SoftwareVisibility") &&
+        renderContext->softwareVisibilityBuffer.IsValid())
+    {
+        softwareVisibilityDescriptor = vulkanContext->GetDescriptorSetsManager()
+            .GetReflectiveDescriptorSetBuilder(it->second, DescriptorScope::eGlobal)
+            .Bind("SoftwareVisibility", renderContext->softwareVisibilityBuffer)
+            .Build()[0];
+    }
+}
+
 void ForwardStage::ExecuteMesh(const Frame& frame) const
 {
-    vkCmdDrawMeshTasksIndirectEXT(frame.commandBuffer, renderContext->commandCountBuffer, 0, 1, 0);
+    // 1 draw per chunk of task commands, chunk count is written by DrawChunks.comp after culling
+    constexpr VkDeviceSize chunksOffset = sizeof(uint32_t);
+    constexpr auto chunkStride = static_cast<uint32_t>(sizeof(gpu::VkDrawMeshTasksIndirectCommandEXT));
+    
+    const Buffer& drawChunkBuffer = renderContext->drawChunkBuffer;
+    const auto maxChunkCount = static_cast<uint32_t>((drawChunkBuffer.GetDescription().size - chunksOffset) / chunkStride);
+    
+    if (vulkanContext->GetDevice().GetProperties().drawIndirectCountSupported)
+    {
+        vkCmdDrawMeshTasksIndirectCountEXT(frame.commandBuffer, drawChunkBuffer, chunksOffset, drawChunkBuffer, 0,
+            maxChunkCount, chunkStride);
+    }
+    else // Chunks past the count are empty
+    {
+        vkCmdDrawMeshTasksIndirectEXT(frame.commandBuffer, drawChunkBuffer, chunksOffset, maxChunkCount, chunkStride);
+    }
 }
 
 void ForwardStage::ExecuteVertex(const Frame& frame) const
 {
     const VkCommandBuffer commandBuffer = frame.commandBuffer;
     
+    // Meshlet culling draws triangles of visible meshlets, written into their own index buffer by MeshletCull.comp
+    const bool meshletCulling = ForwardUtils::UseMeshletCulling();
+    
     const VkBuffer vertexBuffers[] = { renderContext->vertexBuffer };
     const VkDeviceSize offsets[] = { 0 };
     
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(commandBuffer, renderContext->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindIndexBuffer(commandBuffer, meshletCulling ? renderContext->meshletIndexBuffer : renderContext->indexBuffer,
+        0, VK_INDEX_TYPE_UINT32);
     
-    if (vulkanContext->GetDevice().GetProperties().drawIndirectCountSupported)
+    // Instanced draws have 1 command per (primitive, LOD) bucket instead of 1 per draw
+    const bool instancedDraws = ForwardUtils::UseInstancedDraws();
+    const uint32_t bucketCount = static_cast<uint32_t>(renderContext->drawBucketBuffer.GetDescription().size / sizeof(gpu::DrawBucket));
+    
+    constexpr auto commandStride = static_cast<uint32_t>(sizeof(gpu::VkDrawIndexedIndirectCommand));
+    
+    const bool drawIndirectCount = vulkanContext->GetDevice().GetProperties().drawIndirectCountSupported;
+    const uint32_t chunkSize = ForwardUtils::GetDrawChunkSize(*vulkanContext);
+    
+    const Buffer& drawCommandBuffer = meshletCulling ? renderContext->meshletDrawBuffer : renderContext->commandBuffer;
+    const VkDeviceSize firstCommandOffset = meshletCulling ? sizeof(gpu::MeshletDraws) : 0;
+    
+    uint32_t maxDrawCount = instancedDraws ? bucketCount : renderContext->globals.drawCount;
+    
+    if (drawIndirectCount && instancedDraws)
     {
-        vkCmdDrawIndexedIndirectCount(commandBuffer, renderContext->commandBuffer, 0, renderContext->commandCountBuffer, 
-            0, renderContext->globals.drawCount, sizeof(gpu::VkDrawIndexedIndirectCommand));
+        maxDrawCount = std::min(bucketCount, renderContext->globals.drawCount);
     }
-    else
+    
+    if (meshletCulling) // Requires draw indirect count, so only chunks with visible meshlets are drawn
+    {
+        maxDrawCount = static_cast<uint32_t>((drawCommandBuffer.GetDescription().size - firstCommandOffset) / commandStride);
+    }
+    
+    // Commands are drawn in chunks of maxDrawIndirectCount, with draw indirect count DrawChunks.comp writes count of each one
+    for (uint32_t chunkIndex = 0; chunkIndex < PipelineUtils::GroupCount(maxDrawCount, chunkSize); ++chunkIndex)
     {
-        vkCmdDrawIndexedIndirect(commandBuffer, renderContext->commandBuffer, 0, renderContext->globals.drawCount, 
-            sizeof(gpu::VkDrawIndexedIndirectCommand));
+        const uint32_t firstCommand = chunkIndex * chunkSize;
+        const uint32_t chunkDrawCount = std::min(maxDrawCount - firstCommand, chunkSize);
+        const VkDeviceSize commandOffset = firstCommandOffset + static_cast<VkDeviceSize>(firstCommand) * commandStride;
+        
+        if (drawIndirectCount)
+        {
+            const VkDeviceSize countOffset = (1 + chunkIndex) * sizeof(uint32_t);
+            
+            vkCmdDrawIndexedIndirectCount(commandBuffer, drawCommandBuffer, commandOffset,
+                renderContext->drawChunkBuffer, countOffset, chunkDrawCount, commandStride);
+        }
+        else
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, commandOffset, chunkDrawCount, commandStride);
+        }
     }
 }
@@ -0,0 +1,326 @@
+#include "Engine/Render/RenderStages/ImpostorStage.hpp"
+
+#include "Shaders/Common.h"
+#include "Shaders/Impostors/Impostor.h"
+#include "Utils/Helpers.hpp"
+#include "Engine/Scene/SceneHelpers.hpp"
+#include "Engine/Render/Vulkan/VulkanConfig.hpp"
+#include "Engine/Render/Vulkan/VulkanUtils.hpp"
+#include "Engine/Render/Vulkan/Buffer/BufferUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/GraphicsPipelineBuilder.hpp"
+#include "Engine/Render/Vulkan/Synchronization/SynchronizationUtils.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace ImpostorStageDetails
+{
+    static constexpr std::string_view vertexShaderPath = "~/Shaders/Impostors/Impostor.vert";
+    static constexpr std::string_view fragmentShaderPath = "~/Shaders/Impostors/Impostor.frag";
+    static constexpr std::string_view bakeVertexShaderPath = "~/Shaders/Default.vert";
+    static constexpr std::string_view bakeFragmentShaderPath = "~/Shaders/Impostors/ImpostorBake.frag";
+    
+    static constexpr VkFormat atlasFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    
+    // Atlas is cleared to 0 alpha, which Impostor.frag discards as empty
+    static RenderPass CreateBakeRenderPass(const VulkanContext& vulkanContext)
+    {
+        const AttachmentDescription colorAttachmentDescription = {
+            .format = atlasFormat,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .actualLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .defaultClearValue = { .color = { { 0.0f, 0.0f, 0.0f, 0.0f } } } };
+        
+        const AttachmentDescription depthStencilAttachmentDescription = {
+            .format = VulkanConfig::depthImageFormat,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .actualLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .defaultClearValue = { .depthStencil = { 0.0f, 0 } } }; // Reverse Z
+        
+        return RenderPassBuilder(vulkanContext)
+            .SetBindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS)
+            .SetMultisampling(VK_SAMPLE_COUNT_1_BIT)
+            .AddColorAttachment(colorAttachmentDescription)
+            .AddDepthStencilAttachment(depthStencilAttachmentDescription)
+            .Build();
+    }
+    
+    // Orthographic view of the bounding sphere from its surface, depth goes from 1 at the front to 0 at the back
+    // so ImpostorBake.frag can store it as is, Y is flipped the same way as the camera projection
+    static glm::mat4 GetFrameProjection(const float radius)
+    {
+        glm::mat4 projection = glm::orthoRH_ZO(-radius, radius, -radius, radius, 2.0f * radius, 0.0f);
+        projection[1][1] *= -1.0f;
+        
+        return projection;
+    }
+}
+
+ImpostorStage::ImpostorStage(const VulkanContext& aVulkanContext, RenderContext& aRenderContext)
+    : RenderStage{ aVulkanContext, aRenderContext }
+{
+    AddPipeline(pipeline, [&]() { return BuildPipeline(); });
+}
+
+ImpostorStage::~ImpostorStage()
+{}
+
+void ImpostorStage::OnSceneOpen(const Scene& scene)
+{
+    BakeAtlas(scene.GetRaw());
+    BuildDescriptors();
+}
+
+void ImpostorStage::OnSceneClose()
+{
+    descriptors.clear();
+    
+    atlas = RenderTarget();
+    atlasSampler = Sampler();
+}
+
+void ImpostorStage::Execute(const Frame& frame)
+{
+    Draw(frame, offsetof(gpu::ImpostorCommands, firstPass));
+}
+
+void ImpostorStage::ExecuteSecondPass(const Frame& frame)
+{
+    Draw(frame, offsetof(gpu::ImpostorCommands, secondPass));
+}
+
+void ImpostorStage::RebuildDescriptors()
+{
+    descriptors.clear();
+    
+    if (atlas.IsValid())
+    {
+        BuildDescriptors();
+    }
+}
+
+Pipeline ImpostorStage::BuildPipeline() const
+{
+    using namespace ImpostorStageDetails;
+    
+    const PipelineVariant& variant = GetPipelineVariant();
+    
+    std::vector runtimeDefines = { gpu::defines::visualizeLods };
+    
+    std::vector<ShaderModule> shaders;
+    
+    shaders.push_back(GetShader(vertexShaderPath, VK_SHADER_STAGE_VERTEX_BIT, {}, {}));
+    shaders.push_back(GetShader(fragmentShaderPath, VK_SHADER_STAGE_FRAGMENT_BIT, runtimeDefines, {}));
+    
+    // Quad corners come from gl_VertexIndex, facing the camera, so no vertex data and no culling
+    return GraphicsPipelineBuilder(*vulkanContext)
+        .SetShaderModules(shaders)
+        .SetInputTopology(InputTopology::eTriangleStrip)
+        .SetPolygonMode(PolygonMode::eFill)
+        .SetCullMode(CullMode::eNone, false)
+        .SetMultisampling(variant.sampleCount)
+        .SetDepthState(true, true, VK_COMPARE_OP_GREATER_OR_EQUAL)
+        .SetRenderPass(variant.occlusionCulling ? variant.firstRenderPass : variant.renderPass)
+        .Build();
+}
+
+void ImpostorStage::BuildDescriptors()
+{
+    Assert(descriptors.empty());
+    
+    ReflectiveDescriptorSetBuilder builder = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(pipeline, DescriptorScope::eSceneRenderer)
+        .Bind("Draws", renderContext->drawBuffer)
+        .Bind("PrimitiveBoundsBuffer", renderContext->primitiveBoundsBuffer)
+        .Bind("ImpostorDrawsBuffer", renderContext->impostorDrawBuffer)
+        .Bind("impostorAtlas", atlas.views[0], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, atlasSampler);
+    
+    if (pipeline.HasBinding("LightsBuffer"))
+    {
+        builder.Bind("LightsBuffer", renderContext->lightBuffer);
+        builder.Bind("LightClustersBuffer", renderContext->lightClusterBuffer);
+    }
+    
+    descriptors = builder.Build();
+}
+
+// Every frame of every primitive is drawn by Default.vert with an identity instance into its atlas viewport, finest LOD
+// only, ImpostorBake.frag writes the normal and the depth within the bounds, so Impostor.frag can light and depth test it
+void ImpostorStage::BakeAtlas(const RawScene& rawScene)
+{
+    using namespace ImpostorStageDetails;
+    
+    ScopeTimer timer("Bake impostors");
+    
+    // Primitives past the atlas keep their geometry, see PrimitiveCull.comp
+    const auto primitiveCount = static_cast<uint32_t>(std::min(rawScene.primitives.size(),
+        static_cast<size_t>(gpu::maxImpostorPrimitives)));
+    
+    if (primitiveCount == 0)
+    {
+        return;
+    }
+    
+    const VkExtent2D extent = {
+        gpu::impostorAtlasTiles * gpu::impostorTileSize,
+        PipelineUtils::GroupCount(primitiveCount, gpu::impostorAtlasTiles) * gpu::impostorTileSize };
+    
+    ImageDescription atlasDescription = {
+        .extent = { extent.width, extent.height, 1 },
+        .mipLevelsCount = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .format = atlasFormat,
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    ImageDescription depthDescription = {
+        .extent = { extent.width, extent.height, 1 },
+        .mipLevelsCount = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .format = VulkanConfig::depthImageFormat,
+        .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    atlas = RenderTarget(std::move(atlasDescription), VK_IMAGE_ASPECT_COLOR_BIT, *vulkanContext);
+    const auto depthTarget = RenderTarget(std::move(depthDescription), VK_IMAGE_ASPECT_DEPTH_BIT, *vulkanContext);
+    
+    // Frames are texel fetched, the sampler only completes the combined image sampler binding
+    SamplerDescription atlasSamplerDescription = {
+        .filter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE };
+    
+    atlasSampler = Sampler(std::move(atlasSamplerDescription), *vulkanContext);
+    
+    const RenderPass renderPass = CreateBakeRenderPass(*vulkanContext);
+    
+    const std::vector<VkImageView> attachments = { atlas.views[0], depthTarget.views[0] };
+    const VkFramebuffer framebuffer = VulkanUtils::CreateFrameBuffer(renderPass, extent, attachments, *vulkanContext);
+    
+    std::vector<ShaderModule> shaders;
+    
+    shaders.push_back(GetShader(bakeVertexShaderPath, VK_SHADER_STAGE_VERTEX_BIT, {}, {}));
+    shaders.push_back(GetShader(bakeFragmentShaderPath, VK_SHADER_STAGE_FRAGMENT_BIT, {}, {}));
+    
+    const Pipeline bakePipeline = GraphicsPipelineBuilder(*vulkanContext)
+        .SetShaderModules(shaders)
+        .SetVertexData(SceneHelpers::GetVertexBindings(), SceneHelpers::GetVertexAttributes())
+        .SetInputTopology(InputTopology::eTriangleList)
+        .SetPolygonMode(PolygonMode::eFill)
+        .SetCullMode(CullMode::eNone, false)
+        .SetMultisampling(VK_SAMPLE_COUNT_1_BIT)
+        .SetDepthState(true, true, VK_COMPARE_OP_GREATER_OR_EQUAL)
+        .SetRenderPass(renderPass)
+        .Build();
+    
+    const gpu::VisibleInstance identityInstance = { .transform = glm::mat3x4(1.0f) };
+    const std::span<const gpu::VisibleInstance> identityInstanceSpan(&identityInstance, 1);
+    
+    const BufferDescription instanceBufferDescription = {
+        .size = sizeof(gpu::VisibleInstance),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    Buffer instanceBuffer(instanceBufferDescription, true, identityInstanceSpan, *vulkanContext);
+    
+    BufferUtils::UploadFromStagingBuffers(*vulkanContext, Barriers::transferWriteToVertexRead, true, instanceBuffer);
+    
+    const std::vector<VkDescriptorSet> bakeDescriptors = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(bakePipeline, DescriptorScope::eSceneRenderer)
+        .Bind("VisibleInstances", instanceBuffer)
+        .Build();
+    
+    vulkanContext->GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
+        const VkRect2D renderArea = { { 0, 0 }, extent };
+        const VkRenderPassBeginInfo beginInfo = VulkanUtils::GetRenderPassBeginInfo(renderPass, framebuffer, renderArea,
+            renderPass.GetDefaultClearValues());
+        
+        vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, bakePipeline);
+        
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, bakePipeline.GetLayout(), 0,
+            static_cast<uint32_t>(bakeDescriptors.size()), bakeDescriptors.data(), 0, nullptr);
+        
+        const VkBuffer vertexBuffers[] = { renderContext->vertexBuffer };
+        const VkDeviceSize offsets[] = { 0 };
+        
+        vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(cmd, renderContext->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        
+        for (uint32_t primitiveIndex = 0; primitiveIndex < primitiveCount; ++primitiveIndex)
+        {
+            const gpu::Primitive& primitive = rawScene.primitives[primitiveIndex];
+            const gpu::PrimitiveBounds& bounds = rawScene.primitiveBounds[primitiveIndex];
+            const gpu::Lod& lod = primitive.lods[0];
+            
+            gpu::PushConstants globals = {};
+            globals.projection = GetFrameProjection(bounds.radius);
+            
+            for (uint32_t y = 0; y < gpu::impostorFrameCount; ++y)
+            {
+                for (uint32_t x = 0; x < gpu::impostorFrameCount; ++x)
+                {
+                    const glm::uvec2 frame(x, y);
+                    
+                    const glm::vec3 direction = gpu::getImpostorFrameDirection(frame);
+                    const glm::vec3 right = gpu::getImpostorFrameRight(direction);
+                    
+                    globals.view = glm::lookAt(bounds.center + direction * bounds.radius, bounds.center,
+                        glm::cross(direction, right));
+                    
+                    PipelineUtils::PushConstants(cmd, bakePipeline, "globals", globals);
+                    
+                    const glm::uvec2 origin = gpu::getImpostorFrameOrigin(primitiveIndex, frame);
+                    
+                    VkViewport viewport = VulkanUtils::GetViewport(static_cast<float>(gpu::impostorFrameSize),
+                        static_cast<float>(gpu::impostorFrameSize));
+                    viewport.x = static_cast<float>(origin.x);
+                    viewport.y = static_cast<float>(origin.y);
+                    
+                    const VkRect2D scissor = {
+                        { static_cast<int32_t>(origin.x), static_cast<int32_t>(origin.y) },
+                        { gpu::impostorFrameSize, gpu::impostorFrameSize } };
+                    
+                    vkCmdSetViewport(cmd, 0, 1, &viewport);
+                    vkCmdSetScissor(cmd, 0, 1, &scissor);
+                    
+                    vkCmdDrawIndexed(cmd, lod.indexCount, 1, lod.indexOffset, static_cast<int32_t>(primitive.vertexOffset), 0);
+                }
+            }
+        }
+        
+        vkCmdEndRenderPass(cmd);
+    });
+    
+    vkDestroyFramebuffer(vulkanContext->GetDevice(), framebuffer, nullptr);
+}
+
+void ImpostorStage::Draw(const Frame& frame, const VkDeviceSize commandOffset) const
+{
+    // Scenes without primitives have nothing to bake
+    if (descriptors.empty())
+    {
+        return;
+    }
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    
+    PipelineUtils::PushConstants(cmd, pipeline, "globals", renderContext->globals);
+    
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetLayout(), 0,
+        static_cast<uint32_t>(descriptors.size()), descriptors.data(), 0, nullptr);
+    
+    // 4 vertices and 1 instance per appended draw, instance count and first instance are written by culling passes
+    vkCmdDrawIndirect(cmd, renderContext->impostorDrawBuffer, commandOffset, 1, sizeof(gpu::VkDrawIndirectCommand));
+}
@@ -0,0 +1,149 @@
+#include "Engine/Render/RenderStages/LightCullStage.hpp"
+
+#include "Shaders/Common.h"
+#include "Engine/Render/Vulkan/VulkanConfig.hpp"
+#include "Engine/Render/Vulkan/Buffer/BufferUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/ComputePipelineBuilder.hpp"
+#include "Engine/Render/Vulkan/Synchronization/SynchronizationUtils.hpp"
+
+namespace LightCullStageDetails
+{
+    static constexpr std::string_view shaderPath = "~/Shaders/Lighting/LightCull.comp";
+    
+    static constexpr size_t lightsOffset = offsetof(gpu::Lights, lights);
+}
+
+LightCullStage::LightCullStage(const VulkanContext& aVulkanContext, RenderContext& aRenderContext)
+    : RenderStage{ aVulkanContext, aRenderContext }
+{
+    AddPipeline(pipeline, [&]() { return BuildPipeline(); });
+}
+
+LightCullStage::~LightCullStage()
+{}
+
+void LightCullStage::OnSceneOpen(const Scene& scene)
+{
+    const BufferDescription uploadBufferDescription = {
+        .size = sizeof(gpu::Lights),
+        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    
+    for (uint32_t i = 0; i < VulkanConfig::maxFramesInFlight; ++i)
+    {
+        uploadBuffers.emplace_back(uploadBufferDescription, false, *vulkanContext);
+    }
+    
+    BuildDescriptors();
+}
+
+void LightCullStage::OnSceneClose()
+{
+    descriptors.clear();
+    uploadBuffers.clear();
+}
+
+void LightCullStage::Execute(const Frame& frame)
+{
+    using namespace SynchronizationUtils;
+    using namespace PipelineUtils;
+    using namespace LightCullStageDetails;
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    
+    const std::vector<gpu::Light>& lights = renderContext->lights;
+    Assert(lights.size() <= gpu::maxLightCount);
+    
+    const gpu::LightGrid lightGrid = CalculateLightGrid();
+    
+    // Header and the lights in use only, the header is uploaded even without lights, as shading reads it
+    const std::span<const std::byte> lightData = std::as_bytes(std::span(lights));
+    const size_t uploadSize = lightsOffset + lightData.size();
+    
+    Buffer& uploadBuffer = uploadBuffers[frame.index];
+    
+    const std::span<std::byte> uploadMemory = uploadBuffer.MapMemory();
+    std::ranges::copy(std::as_bytes(std::span(&lightGrid, 1)), uploadMemory.begin());
+    std::ranges::copy(lightData, uploadMemory.begin() + static_cast<ptrdiff_t>(lightsOffset));
+    
+    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eLightCullBegin);
+    
+    // Lights and clusters are read by shading of the previous frame
+    SetMemoryBarrier(cmd, Barriers::fragmentReadToTransferWrite);
+    BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->lightBuffer, uploadSize, 0, 0);
+    SetMemoryBarrier(cmd, Barriers::transferWriteToComputeRead | Barriers::transferWriteToFragmentRead);
+    
+    // Clusters aren't read without lights, see calculateClusteredLights() in Lighting.glsl
+    if (!lights.empty())
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        
+        PushConstants(cmd, pipeline, "globals", renderContext->globals);
+        
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetLayout(), 0,
+            static_cast<uint32_t>(descriptors.size()), descriptors.data(), 0, nullptr);
+        
+        vkCmdDispatch(cmd, gpu::lightClusterX, gpu::lightClusterY, gpu::lightClusterZ); // 1 workgroup per cluster
+        
+        SetMemoryBarrier(cmd, Barriers::computeWriteToFragmentRead);
+    }
+    
+    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eLightCullEnd);
+}
+
+void LightCullStage::RebuildDescriptors()
+{
+    descriptors.clear();
+    
+    BuildDescriptors();
+}
+
+Pipeline LightCullStage::BuildPipeline() const
+{
+    ShaderModule shader = GetShader(LightCullStageDetails::shaderPath, VK_SHADER_STAGE_COMPUTE_BIT, {}, {});
+    
+    return ComputePipelineBuilder(*vulkanContext)
+        .SetShaderModule(shader)
+        .Build();
+}
+
+void LightCullStage::BuildDescriptors()
+{
+    Assert(descriptors.empty());
+    
+    descriptors = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(pipeline, DescriptorScope::eSceneRenderer)
+        .Bind("LightsBuffer", renderContext->lightBuffer)
+        .Bind("LightClustersBuffer", renderContext->lightClusterBuffer)
+        .Build();
+}
+
+gpu::LightGrid LightCullStage::CalculateLightGrid() const
+{
+    const gpu::PushConstants& globals = renderContext->globals;
+    const VkExtent2D extent = renderContext->renderExtent; // Clusters cover the part geometry passes render into
+    const float near = globals.cullData.near;
+    
+    // Grid ends at the farthest depth the lights reach, so none of them is lost and no slices are wasted
+    float far = 2.0f * near;
+    
+    for (const gpu::Light& light : renderContext->lights)
+    {
+        const float viewDepth = -(globals.view * glm::vec4(light.position, 1.0f)).z;
+        far = std::max(far, viewDepth + light.range);
+    }
+    
+    const float sliceScale = static_cast<float>(gpu::lightClusterZ) / std::log(far / near);
+    
+    gpu::LightGrid lightGrid = {};
+    lightGrid.screenSize = glm::vec2(static_cast<float>(extent.width), static_cast<float>(extent.height));
+    lightGrid.tileSize = glm::ceil(lightGrid.screenSize
+        / glm::vec2(static_cast<float>(gpu::lightClusterX), static_cast<float>(gpu::lightClusterY)));
+    lightGrid.sliceScale = sliceScale;
+    lightGrid.sliceBias = -std::log(near) * sliceScale;
+    lightGrid.far = far;
+    lightGrid.lightCount = static_cast<uint32_t>(renderContext->lights.size());
+    
+    return lightGrid;
+}
@@ -1,8 +1,12 @@
 #include "Engine/Render/RenderStages/PrimitiveCullStage.hpp"
 
 #include "Shaders/Common.h"
+#include "Engine/EngineConfig.hpp"
 #include "Engine/Render/RenderOptions.hpp"
+#include "Engine/Render/Utils/ForwardUtils.hpp"
+#include "Engine/Render/Vulkan/VulkanConfig.hpp"
 #include "Engine/Render/Vulkan/Image/ImageUtils.hpp"
+#include "Engine/Render/Vulkan/Buffer/BufferUtils.hpp"
 #include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
 #include "Engine/Render/Vulkan/Pipelines/ComputePipelineBuilder.hpp"
 #include "Engine/Render/Vulkan/Synchronization/SynchronizationUtils.hpp"
@@ -12,17 +16,204 @@
 namespace PrimitiveCullStageDetails
 {
     static constexpr std::string_view cullShaderPath = "~/Shaders/Culling/PrimitiveCull.comp";
+    static constexpr std::string_view clusterCullShaderPath = "~/Shaders/Culling/ClusterCull.comp";
+    static constexpr std::string_view instancedCommandsShaderPath = "~/Shaders/Culling/InstancedCommands.comp";
+    static constexpr std::string_view drawChunksShaderPath = "~/Shaders/Culling/DrawChunks.comp";
+    static constexpr std::string_view meshletCullShaderPath = "~/Shaders/Culling/MeshletCull.comp";
     static constexpr std::string_view depthPyramidShaderPath = "~/Shaders/Culling/DepthPyramid.comp";
+    
+    // 1 triangle strip quad per impostor, instance counts are appended by culling passes
+    static constexpr gpu::ImpostorCommands emptyImpostorCommands = { .firstPass = { 4, 0, 0, 0 }, .secondPass = { 4, 0, 0, 0 } };
+    
+    // Layout of the per frame readback buffers, impostors are appended to their own commands instead of draw counters
+    struct DrawCountersReadback
+    {
+        gpu::DrawCounters drawCounters;
+        gpu::ImpostorCommands impostorCommands;
+    };
+    
+    // Dispatch is grown by culling passes, 1 MeshletCull.comp workgroup per task command
+    static constexpr gpu::MeshletDraws emptyMeshletDraws = { .commandCount = 0, .indexCount = 0, .dispatch = { 0, 0, 1 } };
+    
+    // Rest of the debug bounds commands is set once by DebugStage
+    static constexpr size_t debugSpheresInstanceCountOffset = offsetof(gpu::DebugBoundsCommands, spheres)
+        + offsetof(gpu::VkDrawIndexedIndirectCommand, instanceCount);
+    static constexpr size_t debugRectanglesInstanceCountOffset = offsetof(gpu::DebugBoundsCommands, rectangles)
+        + offsetof(gpu::VkDrawIndexedIndirectCommand, instanceCount);
+    
+    static void SetDebugBoundsInstanceCount(const VkCommandBuffer cmd, const Buffer& debugBoundsBuffer, const uint32_t count)
+    {
+        vkCmdFillBuffer(cmd, debugBoundsBuffer, debugSpheresInstanceCountOffset, sizeof(uint32_t), count);
+        vkCmdFillBuffer(cmd, debugBoundsBuffer, debugRectanglesInstanceCountOffset, sizeof(uint32_t), count);
+    }
+    
+    // Copies whole device local buffer to host, only for scene open
+    template <typename T>
+    static std::vector<T> ReadBackBuffer(const Buffer& buffer, const VulkanContext& vulkanContext)
+    {
+        const size_t size = buffer.GetDescription().size;
+        
+        const BufferDescription readbackBufferDescription = {
+            .size = size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+        
+        Buffer readbackBuffer(readbackBufferDescription, false, vulkanContext);
+        
+        vulkanContext.GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
+            BufferUtils::CopyBufferToBuffer(cmd, buffer, readbackBuffer, size);
+            SynchronizationUtils::SetMemoryBarrier(cmd, Barriers::transferWriteToHostRead);
+        });
+        
+        std::vector<T> data(size / sizeof(T));
+        std::memcpy(data.data(), readbackBuffer.MapMemory().data(), data.size() * sizeof(T));
+        
+        return data;
+    }
+    
+    static bool UseReprojection()
+    {
+        const RenderOptions& renderOptions = RenderOptions::Get();
+        return renderOptions.GetReprojectionOcclusion() && !renderOptions.GetFreezeCamera();
+    }
+    
+    // Instance lists of instanced draws and meshlet commands are built only on GPU, so they fall back to GPU culling
+    static bool UseCpuCulling()
+    {
+        return RenderOptions::Get().GetCpuCulling() && !ForwardUtils::UseInstancedDraws() && !ForwardUtils::UseMeshletCulling();
+    }
+    
+    // GPU culling with only the features CpuCuller implements, so both have to find the same visible draws
+    static bool UseCpuCullingValidation()
+    {
+        const RenderOptions& renderOptions = RenderOptions::Get();
+        
+        return renderOptions.GetCpuCullingValidation() && !renderOptions.GetClusterCulling()
+            && renderOptions.GetExtraViewCount() == 0 && !ForwardUtils::UseInstancedDraws()
+            && !ForwardUtils::UseMeshletCulling() && !ForwardUtils::UseImpostors();
+    }
+    
+    static CpuCullingCommands GetCpuCullingCommands(const VulkanContext& vulkanContext)
+    {
+        if (RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh)
+        {
+            return CpuCullingCommands::eTask;
+        }
+        
+        return vulkanContext.GetDevice().GetProperties().drawIndirectCountSupported
+            ? CpuCullingCommands::eIndexed : CpuCullingCommands::eIndexedPerDraw;
+    }
+    
+    // Without draw indirect count vertex pipeline draws the whole command buffer in chunks, no counts are needed
+    static bool UseDrawChunks(const VulkanContext& vulkanContext)
+    {
+        return RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh
+            || vulkanContext.GetDevice().GetProperties().drawIndirectCountSupported;
+    }
+    
+    // Pipeline requirements, only the variants of the current culling setup are built, see RenderStage::AddPipeline
+    static bool IsSinglePass()
+    {
+        return !RenderOptions::Get().GetOcclusionCulling();
+    }
+    
+    static bool IsTwoPass()
+    {
+        return RenderOptions::Get().GetOcclusionCulling();
+    }
+    
+    static bool IsSinglePassClusterCulling()
+    {
+        return IsSinglePass() && RenderOptions::Get().GetClusterCulling();
+    }
+    
+    static bool IsTwoPassClusterCulling()
+    {
+        return IsTwoPass() && RenderOptions::Get().GetClusterCulling();
+    }
+    
+    static bool IsInstancedDraws()
+    {
+        return ForwardUtils::UseInstancedDraws();
+    }
+    
+    static bool IsMeshletCulling()
+    {
+        return ForwardUtils::UseMeshletCulling();
+    }
+    
+    static bool IsTwoPassMeshletCulling()
+    {
+        return IsTwoPass() && IsMeshletCulling();
+    }
+    
+    // Passes which test occlusion have the depth pyramid set after their own ones, see BuildDepthPyramidDescriptors
+    static void BindDescriptors(const VkCommandBuffer cmd, const Pipeline& pipeline,
+        const std::span<const VkDescriptorSet> descriptors, const VkDescriptorSet depthPyramidDescriptor)
+    {
+        const auto setCount = static_cast<uint32_t>(descriptors.size());
+        
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetLayout(), 0, setCount,
+            descriptors.data(), 0, nullptr);
+        
+        if (pipeline.GetSetLayouts().size() > setCount)
+        {
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetLayout(), setCount, 1,
+                &depthPyramidDescriptor, 0, nullptr);
+        }
+    }
+    
+    static bool IsCameraCut(const glm::mat4& previousView, const glm::mat4& view)
+    {
+        const glm::mat4 previousCamera = glm::inverse(previousView);
+        const glm::mat4 camera = glm::inverse(view);
+        
+        const float distance = glm::distance(glm::vec3(previousCamera[3]), glm::vec3(camera[3]));
+        const float cosAngle = glm::dot(glm::vec3(previousCamera[2]), glm::vec3(camera[2]));
+        
+        return distance > EngineConfig::cameraCutDistance || cosAngle < EngineConfig::cameraCutMinCosAngle;
+    }
+    
+    // Direct dispatches of culling passes are split by maxComputeWorkGroupCount, see PipelineUtils::DispatchChunked
+    static Pipeline BuildChunkedDispatchPipeline(const ShaderModule& shader, const VulkanContext& vulkanContext)
+    {
+        return ComputePipelineBuilder(vulkanContext)
+            .SetShaderModule(shader)
+            .SetCreateFlags(VK_PIPELINE_CREATE_DISPATCH_BASE_BIT)
+            .Build();
+    }
 }
 
 PrimitiveCullStage::PrimitiveCullStage(const VulkanContext& aVulkanContext, RenderContext& aRenderContext)
     : RenderStage{ aVulkanContext, aRenderContext }
 {
-    // TODO: Keep only required ones
-    AddPipeline(pipeline, [&]() { return BuildPipeline(false); });
-    AddPipeline(firstPassPipeline, [&]() { return BuildPipeline(true, true); });
-    AddPipeline(depthPyramidPipeline, [&]() { return BuildDepthPyramidPipeline(); });
-    AddPipeline(secondPassPipeline, [&]() { return BuildPipeline(true, false); });
+    using namespace PrimitiveCullStageDetails;
+    
+    // Reprojection isn't a requirement, it can be toggled without rebuilding pipelines
+    AddPipeline(pipeline, [&]() { return BuildPipeline(false); }, IsSinglePass);
+    AddPipeline(firstPassPipeline, [&]() { return BuildPipeline(true, true); }, IsTwoPass);
+    AddPipeline(reprojectionFirstPassPipeline, [&]() { return BuildPipeline(true, true, true); }, IsTwoPass);
+    AddPipeline(depthPyramidPipeline, [&]() { return BuildDepthPyramidPipeline(); }, IsTwoPass);
+    AddPipeline(secondPassPipeline, [&]() { return BuildPipeline(true, false); }, IsTwoPass);
+    AddPipeline(clusterCullPipeline, [&]() { return BuildClusterCullPipeline(false); }, IsSinglePassClusterCulling);
+    AddPipeline(clusterFirstPassPipeline, [&]() { return BuildClusterCullPipeline(true, true); }, IsTwoPassClusterCulling);
+    AddPipeline(clusterReprojectionFirstPassPipeline, [&]() { return BuildClusterCullPipeline(true, true, true); },
+        IsTwoPassClusterCulling);
+    AddPipeline(clusterSecondPassPipeline, [&]() { return BuildClusterCullPipeline(true, false); }, IsTwoPassClusterCulling);
+    AddPipeline(instancedCommandsPipeline, [&]() { return BuildInstancedCommandsPipeline(true); }, IsInstancedDraws);
+    AddPipeline(instancesPipeline, [&]() { return BuildInstancedCommandsPipeline(false); }, IsInstancedDraws);
+    AddPipeline(drawChunksPipeline, [&]() { return BuildDrawChunksPipeline(); }, [&]() {
+        return UseDrawChunks(*vulkanContext) || IsMeshletCulling(); // Meshlet commands are always chunked
+    });
+    AddPipeline(meshletCullPipeline, [&]() { return BuildMeshletCullPipeline(false); }, IsMeshletCulling);
+    AddPipeline(meshletCullSecondPassPipeline, [&]() { return BuildMeshletCullPipeline(true); }, IsTwoPassMeshletCulling);
+    
+    const BufferDescription reprojectionDataBufferDescription = {
+        .size = sizeof(gpu::ReprojectionData),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    reprojectionDataBuffer = Buffer(reprojectionDataBufferDescription, false, *vulkanContext);
 }
 
 PrimitiveCullStage::~PrimitiveCullStage() = default;
@@ -32,7 +223,12 @@ void PrimitiveCullStage::CreateRenderTargetDependentResources()
     if (RenderOptions::Get().GetOcclusionCulling())
     {
         CreateDepthPyramidRenderTargetAndSampler();
-        BuildDepthPyramidDescriptors();
+        
+        // When occlusion culling gets enabled its pipelines are built after render targets, see RebuildDescriptors
+        if (depthPyramidPipeline.IsValid())
+        {
+            BuildDepthPyramidDescriptors();
+        }
     }
 }
 
@@ -44,30 +240,71 @@ void PrimitiveCullStage::DestroyRenderTargetDependentResources()
     depthPyramidRenderTarget = {};
 }
 
-void PrimitiveCullStage::OnSceneOpen(const Scene& scene)
+void PrimitiveCullStage::OnSceneOpen(const Scene& aScene)
 {
-    if (RenderOptions::Get().GetOcclusionCulling())
-    {
-        firstPassDescriptors = BuildDescriptors(firstPassPipeline);
-        secondPassDescriptors = BuildDescriptors(secondPassPipeline);
-    }
-    else
-    {
-        descriptors = BuildDescriptors(pipeline);
-    }
+    scene = &aScene;
+    reprojectionData.bValid = 0; // Depth pyramid is the one of the previous scene
+    
+    // Draws can be copied on GPU only (see RandomlyCopyScene.comp), so CPU cullers get them from there once
+    sceneDraws = PrimitiveCullStageDetails::ReadBackBuffer<gpu::Draw>(renderContext->drawBuffer, *vulkanContext);
+    sceneDrawClusters = PrimitiveCullStageDetails::ReadBackBuffer<gpu::DrawCluster>(renderContext->drawClusterBuffer,
+        *vulkanContext);
+    
+    CreateDrawCountersBuffers();
+    uploadBuffers.resize(VulkanConfig::maxFramesInFlight);
+    
+    BuildPassDescriptors();
 }
 
 void PrimitiveCullStage::OnSceneClose()
 {
     descriptors.clear();
     firstPassDescriptors.clear();
+    reprojectionFirstPassDescriptors.clear();
     secondPassDescriptors.clear();
+    clusterCullDescriptors.clear();
+    clusterFirstPassDescriptors.clear();
+    clusterReprojectionFirstPassDescriptors.clear();
+    clusterSecondPassDescriptors.clear();
+    instancedCommandsDescriptors.clear();
+    instancesDescriptors.clear();
+    drawChunksDescriptors.clear();
+    meshletDrawChunksDescriptors.clear();
+    meshletCullDescriptors.clear();
+    meshletCullSecondPassDescriptors.clear();
+    
+    drawCountersBuffer = {};
+    drawCountersReadbackBuffers.clear();
+    
+    scene = nullptr;
+    sceneDraws = {};
+    sceneDrawClusters = {};
+    uploadBuffers.clear();
+    
+    cpuCuller.reset();
+    cpuCullingOutput = {};
+    validationReadbackBuffers.clear();
+    validationGlobals.clear();
+    
+    softwareOcclusionCuller.reset();
+    seededDrawsVisibility = {};
+    seededClusterVisibility = {};
+    previousCullView.reset();
+    reprojectionData.bValid = 0;
 }
 
 void PrimitiveCullStage::Execute(const Frame& frame)
 {
     Assert(!RenderOptions::Get().GetOcclusionCulling()); // Use dedicated Execute methods (ExecuteFirstPass, BuildDepthPyramid, ExecuteSecondPass);
     
+    previousCullView.reset(); // Visibility buffers aren't written without occlusion culling
+    
+    if (PrimitiveCullStageDetails::UseCpuCulling())
+    {
+        ExecuteCpuCulling(frame);
+        return;
+    }
+    
     using namespace SynchronizationUtils;
     using namespace PipelineUtils;
 
@@ -75,41 +312,50 @@ void PrimitiveCullStage::Execute(const Frame& frame)
 
     StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eFirstCullingPassBegin);
     
-    SetMemoryBarrier(cmd, Barriers::indirectCommandReadToTransferWrite);
-    vkCmdFillBuffer(cmd, renderContext->commandCountBuffer, 0, sizeof(uint32_t), 0);
+    ClearCullingBuffers(cmd, true);
+    UpdateExtraViews(cmd);
     SetMemoryBarrier(cmd, Barriers::transferWriteToComputeReadWrite);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
-
-    PushConstants(cmd, pipeline, "globals", renderContext->globals);
-
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetLayout(), 0, static_cast<uint32_t>(descriptors.size()), descriptors.data(), 0, nullptr);
-    
-    vkCmdDispatch(cmd, GroupCount(renderContext->globals.drawCount, gpu::primitiveCullWgSize), 1, 1);
-
-    SetMemoryBarrier(cmd, RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh
-        ? Barriers::computeWriteToIndirectCommandRead | Barriers::computeWriteToTaskRead : Barriers::computeWriteToIndirectCommandRead);
+    DispatchCulling(cmd, clusterCullPipeline, clusterCullDescriptors, pipeline, descriptors);
     
     StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eFirstCullingPassEnd);
+    
+    if (PrimitiveCullStageDetails::UseCpuCullingValidation())
+    {
+        CopyValidationData(frame);
+    }
+    else if (!validationGlobals.empty())
+    {
+        validationGlobals[frame.index].reset();
+    }
 }
 
 void PrimitiveCullStage::RebuildDescriptors()
 {
     firstPassDescriptors.clear();
+    reprojectionFirstPassDescriptors.clear();
     depthPyramidReductionDescriptors.clear();
     depthPyramidDescriptor = VK_NULL_HANDLE;
     secondPassDescriptors.clear();
     
+    // Descriptors of pipelines which aren't required anymore aren't rebuilt
+    clusterCullDescriptors.clear();
+    clusterFirstPassDescriptors.clear();
+    clusterReprojectionFirstPassDescriptors.clear();
+    clusterSecondPassDescriptors.clear();
+    instancedCommandsDescriptors.clear();
+    instancesDescriptors.clear();
+    drawChunksDescriptors.clear();
+    meshletDrawChunksDescriptors.clear();
+    meshletCullDescriptors.clear();
+    meshletCullSecondPassDescriptors.clear();
+    
     if (RenderOptions::Get().GetOcclusionCulling())
     {
-        firstPassDescriptors = BuildDescriptors(firstPassPipeline);
         BuildDepthPyramidDescriptors();
-        secondPassDescriptors = BuildDescriptors(secondPassPipeline);
-    }
-    else
-    {
-        descriptors = BuildDescriptors(pipeline);
     }
+    
+    BuildPassDescriptors();
 }
 
 void PrimitiveCullStage::ExecuteFirstPass(const Frame& frame)
@@ -118,24 +364,44 @@ void PrimitiveCullStage::ExecuteFirstPass(const Frame& frame)
     using namespace PipelineUtils;
 
     const VkCommandBuffer cmd = frame.commandBuffer;
+    const bool reprojection = PrimitiveCullStageDetails::UseReprojection();
+    
+    const Pipeline& passPipeline = reprojection ? reprojectionFirstPassPipeline : firstPassPipeline;
+    const Pipeline& clusterPassPipeline = reprojection ? clusterReprojectionFirstPassPipeline : clusterFirstPassPipeline;
+    
+    const std::vector<VkDescriptorSet>& passDescriptors = reprojection ? reprojectionFirstPassDescriptors : firstPassDescriptors;
+    const std::vector<VkDescriptorSet>& clusterPassDescriptors = reprojection
+        ? clusterReprojectionFirstPassDescriptors : clusterFirstPassDescriptors;
     
     StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eFirstCullingPassBegin);
 
-    SetMemoryBarrier(cmd, Barriers::indirectCommandReadToTransferWrite);
-    vkCmdFillBuffer(cmd, renderContext->commandCountBuffer, 0, sizeof(uint32_t), 0);
-    SetMemoryBarrier(cmd, Barriers::transferWriteToComputeReadWrite);
-
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, firstPassPipeline);
-
-    PushConstants(cmd, firstPassPipeline, "globals", renderContext->globals);
-
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, firstPassPipeline.GetLayout(), 0,
-        static_cast<uint32_t>(firstPassDescriptors.size()), firstPassDescriptors.data(), 0, nullptr);
+    ClearCullingBuffers(cmd, true);
+    UpdateExtraViews(cmd);
+    
+    // Reprojection tests all draws against the previous depth pyramid, so it doesn't use visibility of the previous frame
+    const glm::mat4& cullView = renderContext->globals.cullData.view;
+    const bool cameraCut = !previousCullView || PrimitiveCullStageDetails::IsCameraCut(*previousCullView, cullView);
+    previousCullView = cullView;
+    
+    if (cameraCut && !reprojection && RenderOptions::Get().GetSoftwareOcclusion())
+    {
+        SeedVisibility(frame);
+    }
+    
+    if (reprojection)
+    {
+        // Depth pyramid of the previous view occludes unrelated parts of the scene after a cut, everything is visible
+        if (cameraCut)
+        {
+            reprojectionData.bValid = 0;
+        }
+        
+        vkCmdUpdateBuffer(cmd, reprojectionDataBuffer, 0, sizeof(gpu::ReprojectionData), &reprojectionData);
+    }
     
-    vkCmdDispatch(cmd, GroupCount(renderContext->globals.drawCount, gpu::primitiveCullWgSize), 1, 1);
+    SetMemoryBarrier(cmd, Barriers::transferWriteToComputeReadWrite);
 
-    SetMemoryBarrier(cmd, RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh
-        ? Barriers::computeWriteToIndirectCommandRead | Barriers::computeWriteToTaskRead : Barriers::computeWriteToIndirectCommandRead);
+    DispatchCulling(cmd, clusterPassPipeline, clusterPassDescriptors, passPipeline, passDescriptors);
     
     StatsUtils::WriteTimestamp(frame.commandBuffer, frame.queryPools.timestamps, GpuTimestamp::eFirstCullingPassEnd);
 }
@@ -159,12 +425,19 @@ void PrimitiveCullStage::BuildDepthPyramid(const Frame& frame)
     
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipeline);
     
+    // With dynamic resolution depth covers the top left render extent only, mip 0 stretches it over the whole pyramid,
+    // so culling keeps testing screen UVs of the full swapchain
+    const VkExtent2D swapchainExtent = vulkanContext->GetSwapchain().GetExtent();
+    const glm::vec2 depthScale = glm::vec2(renderContext->renderExtent.width, renderContext->renderExtent.height)
+        / glm::vec2(swapchainExtent.width, swapchainExtent.height);
+    
     for (uint32_t targetMip = 0; targetMip < depthPyramidRenderTarget.image.GetDescription().mipLevelsCount; ++targetMip)
     {
         const uint32_t dstWidth = std::max(1u, pyramidExtent.width >> targetMip);
         const uint32_t dstHeight = std::max(1u, pyramidExtent.height >> targetMip);
         
         PushConstants(cmd, depthPyramidPipeline, "dstSize", glm::vec2(dstWidth, dstHeight));
+        PushConstants(cmd, depthPyramidPipeline, "srcScale", targetMip == 0 ? depthScale : glm::vec2(1.0f));
         
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipeline.GetLayout(), 0,
             1, &depthPyramidReductionDescriptors[targetMip], 0, nullptr);
@@ -174,6 +447,11 @@ void PrimitiveCullStage::BuildDepthPyramid(const Frame& frame)
         TransitionLayout(cmd, depthPyramidRenderTarget, LayoutTransitions::generalToShaderReadOnlyOptimal, Barriers::computeWriteToComputeRead, targetMip);
     }
     
+    // Next frame's first pass can reproject draws into this pyramid
+    const gpu::PushConstants& globals = renderContext->globals;
+    reprojectionData = { .view = globals.view, .projection00 = globals.projection[0][0],
+        .projection11 = globals.projection[1][1], .near = globals.cullData.near, .bValid = 1 };
+    
     StatsUtils::WriteTimestamp(frame.commandBuffer, frame.queryPools.timestamps, GpuTimestamp::eDepthPyramidEnd);
 }
 
@@ -199,6 +477,51 @@ void PrimitiveCullStage::VisualizeDepth(const Frame& frame)
         Barriers::transferWriteToColorReadWrite);
 }
 
+void PrimitiveCullStage::CopyDrawCounters(const Frame& frame)
+{
+    using namespace SynchronizationUtils;
+    
+    SetMemoryBarrier(frame.commandBuffer, Barriers::computeWriteToTransferRead);
+    BufferUtils::CopyBufferToBuffer(frame.commandBuffer, drawCountersBuffer, drawCountersReadbackBuffers[frame.index],
+        sizeof(gpu::DrawCounters));
+    
+    if (ForwardUtils::UseImpostors())
+    {
+        BufferUtils::CopyBufferToBuffer(frame.commandBuffer, renderContext->impostorDrawBuffer,
+            drawCountersReadbackBuffers[frame.index], sizeof(gpu::ImpostorCommands), 0,
+            offsetof(PrimitiveCullStageDetails::DrawCountersReadback, impostorCommands));
+    }
+    
+    SetMemoryBarrier(frame.commandBuffer, Barriers::transferWriteToHostRead);
+}
+
+void PrimitiveCullStage::GatherFrameStats(const Frame& frame, FrameRenderStats& renderStats)
+{
+    if (drawCountersReadbackBuffers.empty())
+    {
+        return;
+    }
+    
+    PrimitiveCullStageDetails::DrawCountersReadback readback;
+    std::memcpy(&readback, drawCountersReadbackBuffers[frame.index].MapMemory().data(), sizeof(readback));
+    
+    const gpu::DrawCounters& drawCounters = readback.drawCounters;
+    const gpu::ImpostorCommands& impostorCommands = readback.impostorCommands;
+    
+    renderStats.firstPassDrawCount = drawCounters.firstPassDrawCount;
+    renderStats.secondPassDrawCount = drawCounters.secondPassDrawCount;
+    renderStats.reprojectedDrawCount = drawCounters.reprojectedDrawCount;
+    renderStats.overflowCommandCount = drawCounters.overflowCommandCount;
+    renderStats.extraViewDrawCount = std::accumulate(std::begin(drawCounters.extraViewDrawCounts),
+        std::end(drawCounters.extraViewDrawCounts), 0u);
+    renderStats.impostorDrawCount = impostorCommands.firstPass.instanceCount + impostorCommands.secondPass.instanceCount;
+    
+    if (!validationGlobals.empty() && validationGlobals[frame.index])
+    {
+        ValidateCpuCulling(frame);
+    }
+}
+
 void PrimitiveCullStage::ExecuteSecondPass(const Frame& frame)
 {
     using namespace SynchronizationUtils;
@@ -208,60 +531,757 @@ void PrimitiveCullStage::ExecuteSecondPass(const Frame& frame)
     
     StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eSecondCullingPassBegin);
 
-    SetMemoryBarrier(cmd, Barriers::indirectCommandReadToTransferWrite);
-    vkCmdFillBuffer(cmd, renderContext->commandCountBuffer, 0, sizeof(uint32_t), 0);
+    ClearCullingBuffers(cmd, false);
     SetMemoryBarrier(cmd, Barriers::transferWriteToComputeReadWrite);
+    
+    DispatchCulling(cmd, clusterSecondPassPipeline, clusterSecondPassDescriptors, secondPassPipeline, secondPassDescriptors, true);
+    
+    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eSecondCullingPassEnd);
+}
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, secondPassPipeline);
+Pipeline PrimitiveCullStage::BuildPipeline(const bool occlusionCulling /* = true */, const bool firstPass /* = true */,
+    const bool reprojection /* = false */) const
+{
+    std::vector runtimeDefines = { gpu::defines::meshPipeline, gpu::defines::visualizeLods, gpu::defines::drawIndirectCount,
+        gpu::defines::clusterCulling, gpu::defines::visibilityBuffer, gpu::defines::impostors, gpu::defines::debugBounds,
+        gpu::defines::meshletCulling };
+    std::vector<ShaderDefine> defines = { { "OCCLUSION_CULLING", occlusionCulling }, { "FIRST_PASS", firstPass },
+        { "REPROJECTION", reprojection } };
+    
+    ShaderModule shader = GetShader(PrimitiveCullStageDetails::cullShaderPath, VK_SHADER_STAGE_COMPUTE_BIT, runtimeDefines, defines);
+    
+    return PrimitiveCullStageDetails::BuildChunkedDispatchPipeline(shader, *vulkanContext);
+}
 
-    PushConstants(cmd, secondPassPipeline, "globals", renderContext->globals);
+Pipeline PrimitiveCullStage::BuildClusterCullPipeline(const bool occlusionCulling /* = true */, const bool firstPass /* = true */,
+    const bool reprojection /* = false */) const
+{
+    std::vector<ShaderDefine> defines = { { "OCCLUSION_CULLING", occlusionCulling }, { "FIRST_PASS", firstPass },
+        { "REPROJECTION", reprojection } };
+    
+    ShaderModule shader = GetShader(PrimitiveCullStageDetails::clusterCullShaderPath, VK_SHADER_STAGE_COMPUTE_BIT, {}, defines);
     
-    std::vector<VkDescriptorSet> passDescriptors = secondPassDescriptors;
-    passDescriptors.push_back(depthPyramidDescriptor);
+    return PrimitiveCullStageDetails::BuildChunkedDispatchPipeline(shader, *vulkanContext);
+}
 
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, secondPassPipeline.GetLayout(), 0,
-        static_cast<uint32_t>(passDescriptors.size()), passDescriptors.data(), 0, nullptr);
+void PrimitiveCullStage::ClearCullingBuffers(const VkCommandBuffer cmd, const bool clearDrawCounters)
+{
+    using namespace SynchronizationUtils;
+    
+    const RenderOptions& renderOptions = RenderOptions::Get();
+    const bool instancedDraws = ForwardUtils::UseInstancedDraws();
+    const bool meshletCulling = ForwardUtils::UseMeshletCulling();
+    const bool impostors = ForwardUtils::UseImpostors();
+    const bool debugBounds = ForwardUtils::UseDebugBounds();
+    
+    PipelineBarrier barrier = Barriers::indirectCommandReadToTransferWrite | Barriers::transferReadToTransferWrite
+        | Barriers::computeReadToTransferWrite;
+    
+    // Visible instances (and instance lists) are read by draws of the previous pass, impostor and debug bounds draws
+    // by vertex shaders
+    if (renderOptions.GetGraphicsPipelineType() == GraphicsPipelineType::eMesh)
+    {
+        barrier = barrier | Barriers::meshReadToComputeWrite;
+        
+        if (impostors || debugBounds)
+        {
+            barrier = barrier | Barriers::vertexReadToComputeWrite;
+        }
+    }
+    else
+    {
+        barrier = barrier | Barriers::vertexReadToComputeWrite;
+    }
+    
+    // Meshlet triangles are rewritten by every pass
+    if (meshletCulling)
+    {
+        barrier = barrier | Barriers::indexReadToComputeWrite;
+    }
+    
+    SetMemoryBarrier(cmd, barrier);
+    vkCmdFillBuffer(cmd, renderContext->commandCountBuffer, 0, sizeof(uint32_t), 0);
+    
+    if (clearDrawCounters)
+    {
+        vkCmdFillBuffer(cmd, drawCountersBuffer, 0, VK_WHOLE_SIZE, 0);
+    }
+    
+    if (instancedDraws)
+    {
+        vkCmdFillBuffer(cmd, renderContext->drawBucketBuffer, 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(cmd, renderContext->instancedDrawBuffer, 0, 2 * sizeof(uint32_t), 0);
+    }
+    
+    if (meshletCulling)
+    {
+        vkCmdUpdateBuffer(cmd, renderContext->meshletDrawBuffer, 0, sizeof(gpu::MeshletDraws),
+            &PrimitiveCullStageDetails::emptyMeshletDraws);
+    }
+    
+    if (impostors && clearDrawCounters)
+    {
+        vkCmdUpdateBuffer(cmd, renderContext->impostorDrawBuffer, 0, sizeof(gpu::ImpostorCommands),
+            &PrimitiveCullStageDetails::emptyImpostorCommands);
+    }
+    else if (impostors) // Second pass impostors are appended after the first pass ones
+    {
+        constexpr size_t instanceCountOffset = offsetof(gpu::ImpostorCommands, firstPass)
+            + offsetof(gpu::VkDrawIndirectCommand, instanceCount);
+        constexpr size_t firstInstanceOffset = offsetof(gpu::ImpostorCommands, secondPass)
+            + offsetof(gpu::VkDrawIndirectCommand, firstInstance);
+        
+        SetMemoryBarrier(cmd, Barriers::computeWriteToTransferRead);
+        BufferUtils::CopyBufferToBuffer(cmd, renderContext->impostorDrawBuffer, renderContext->impostorDrawBuffer,
+            sizeof(uint32_t), instanceCountOffset, firstInstanceOffset);
+    }
+    
+    if (debugBounds && clearDrawCounters) // Both passes append to the same instances
+    {
+        PrimitiveCullStageDetails::SetDebugBoundsInstanceCount(cmd, renderContext->debugBoundsBuffer, 0);
+    }
+    
+    if (renderOptions.GetClusterCulling())
+    {
+        constexpr gpu::ClusterDispatch emptyClusterDispatch = { .command = { 0, 0, 1 }, .visibleClusterCount = 0 };
+        vkCmdUpdateBuffer(cmd, renderContext->clusterDispatchBuffer, 0, sizeof(gpu::ClusterDispatch), &emptyClusterDispatch);
+        
+        // Draws of culled clusters aren't processed at all, so their commands left from the previous pass must be emptied
+        if (renderOptions.GetGraphicsPipelineType() != GraphicsPipelineType::eMesh && !instancedDraws
+            && !vulkanContext->GetDevice().GetProperties().drawIndirectCountSupported)
+        {
+            vkCmdFillBuffer(cmd, renderContext->commandBuffer, 0, VK_WHOLE_SIZE, 0);
+        }
+    }
+}
+
+void PrimitiveCullStage::UpdateExtraViews(const VkCommandBuffer cmd) const
+{
+    const std::vector<gpu::ExtraView>& views = renderContext->extraViews;
+    Assert(views.size() <= gpu::maxExtraViewCount);
+    
+    gpu::ExtraViews extraViews = {};
+    extraViews.viewCount = static_cast<uint32_t>(views.size());
+    extraViews.commandCapacity = static_cast<uint32_t>(renderContext->extraViewCommandBuffer.GetDescription().size
+        / (gpu::maxExtraViewCount * sizeof(gpu::VkDrawIndexedIndirectCommand)));
+    std::ranges::copy(views, std::begin(extraViews.views));
+    
+    // Header and the views in use only
+    const size_t updateSize = sizeof(gpu::ExtraViews) - sizeof(extraViews.views) + views.size() * sizeof(gpu::ExtraView);
+    vkCmdUpdateBuffer(cmd, renderContext->extraViewsBuffer, 0, updateSize, &extraViews);
+}
 
-    const auto groupCountX = static_cast<uint32_t>(std::ceil(static_cast<float>(renderContext->globals.drawCount) /
-        static_cast<float>(gpu::primitiveCullWgSize)));
+void PrimitiveCullStage::DispatchCulling(const VkCommandBuffer cmd, const Pipeline& clusterPipeline,
+    const std::span<const VkDescriptorSet> clusterDescriptors, const Pipeline& cullPipeline,
+    const std::span<const VkDescriptorSet> cullDescriptors, const bool secondPass /* = false */) const
+{
+    using namespace SynchronizationUtils;
+    using namespace PipelineUtils;
+    
+    const bool clusterCulling = RenderOptions::Get().GetClusterCulling();
+    const bool meshPipeline = RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh;
+    const bool meshletCulling = ForwardUtils::UseMeshletCulling();
+    
+    const DeviceProperties& deviceProperties = vulkanContext->GetDevice().GetProperties();
+    const uint32_t maxGroupCount = deviceProperties.physicalProperties.limits.maxComputeWorkGroupCount[0];
+    
+    if (clusterCulling)
+    {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, clusterPipeline);
+        
+        PushConstants(cmd, clusterPipeline, "globals", renderContext->globals);
+        
+        PrimitiveCullStageDetails::BindDescriptors(cmd, clusterPipeline, clusterDescriptors, depthPyramidDescriptor);
+        
+        DispatchChunked(cmd, GroupCount(renderContext->globals.clusterCount, gpu::clusterCullWgSize), maxGroupCount);
+        
+        SetMemoryBarrier(cmd, Barriers::computeWriteToComputeRead | Barriers::computeWriteToIndirectCommandRead);
+    }
+    
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
 
-    vkCmdDispatch(cmd, groupCountX, 1, 1);
+    PushConstants(cmd, cullPipeline, "globals", renderContext->globals);
 
-    SetMemoryBarrier(cmd, RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh
-        ? Barriers::computeWriteToIndirectCommandRead | Barriers::computeWriteToTaskRead : Barriers::computeWriteToIndirectCommandRead);
+    PrimitiveCullStageDetails::BindDescriptors(cmd, cullPipeline, cullDescriptors, depthPyramidDescriptor);
     
-    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eSecondCullingPassEnd);
+    if (clusterCulling) // 1 workgroup per visible cluster
+    {
+        vkCmdDispatchIndirect(cmd, renderContext->clusterDispatchBuffer, offsetof(gpu::ClusterDispatch, command));
+    }
+    else
+    {
+        DispatchChunked(cmd, GroupCount(renderContext->globals.drawCount, gpu::primitiveCullWgSize), maxGroupCount);
+    }
+    
+    if (ForwardUtils::UseInstancedDraws())
+    {
+        const uint32_t bucketCount = static_cast<uint32_t>(renderContext->drawBucketBuffer.GetDescription().size / sizeof(gpu::DrawBucket));
+        
+        SetMemoryBarrier(cmd, Barriers::computeWriteToComputeRead);
+        
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, instancedCommandsPipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, instancedCommandsPipeline.GetLayout(), 0,
+            static_cast<uint32_t>(instancedCommandsDescriptors.size()), instancedCommandsDescriptors.data(), 0, nullptr);
+        DispatchChunked(cmd, GroupCount(bucketCount, gpu::primitiveCullWgSize), maxGroupCount);
+        
+        SetMemoryBarrier(cmd, Barriers::computeWriteToComputeRead);
+        
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, instancesPipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, instancesPipeline.GetLayout(), 0,
+            static_cast<uint32_t>(instancesDescriptors.size()), instancesDescriptors.data(), 0, nullptr);
+        DispatchChunked(cmd, GroupCount(renderContext->globals.drawCount, gpu::primitiveCullWgSize), maxGroupCount);
+    }
+    
+    if (meshletCulling)
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToComputeRead | Barriers::computeWriteToIndirectCommandRead);
+        DispatchMeshletCulling(cmd, secondPass);
+    }
+    else if (PrimitiveCullStageDetails::UseDrawChunks(*vulkanContext))
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToComputeRead);
+        DispatchDrawChunks(cmd);
+    }
+    
+    // Second pass impostor command is completed by a copy, see ClearCullingBuffers, debug bounds are read by DebugStage
+    if (ForwardUtils::UseImpostors() || ForwardUtils::UseDebugBounds())
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToVertexRead | Barriers::transferWriteToIndirectCommandRead);
+    }
+    
+    if (meshPipeline)
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToIndirectCommandRead | Barriers::computeWriteToTaskRead
+            | Barriers::computeWriteToMeshRead);
+    }
+    else
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToIndirectCommandRead | Barriers::computeWriteToVertexRead);
+    }
+    
+    if (meshletCulling)
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToIndexRead);
+    }
+}
+
+void PrimitiveCullStage::DispatchMeshletCulling(const VkCommandBuffer cmd, const bool secondPass) const
+{
+    using namespace SynchronizationUtils;
+    using namespace PipelineUtils;
+    
+    const Pipeline& meshletPipeline = secondPass ? meshletCullSecondPassPipeline : meshletCullPipeline;
+    const std::vector<VkDescriptorSet>& meshletDescriptors = secondPass ? meshletCullSecondPassDescriptors : meshletCullDescriptors;
+    
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, meshletPipeline);
+    
+    PushConstants(cmd, meshletPipeline, "globals", renderContext->globals);
+    
+    PrimitiveCullStageDetails::BindDescriptors(cmd, meshletPipeline, meshletDescriptors, depthPyramidDescriptor);
+    
+    // 1 workgroup per task command, sized by culling
+    vkCmdDispatchIndirect(cmd, renderContext->meshletDrawBuffer, offsetof(gpu::MeshletDraws, dispatch));
+    
+    SetMemoryBarrier(cmd, Barriers::computeWriteToComputeRead);
+    DispatchDrawChunks(cmd);
 }
 
-Pipeline PrimitiveCullStage::BuildPipeline(const bool occlusionCulling /* = true */, const bool firstPass /* = true */) const
+void PrimitiveCullStage::DispatchDrawChunks(const VkCommandBuffer cmd) const
 {
-    std::vector runtimeDefines = { gpu::defines::meshPipeline, gpu::defines::visualizeLods, gpu::defines::drawIndirectCount };
-    std::vector<ShaderDefine> defines = { { "OCCLUSION_CULLING", occlusionCulling }, { "FIRST_PASS", firstPass } };
+    using namespace PipelineUtils;
     
-    ShaderModule shader = GetShader(PrimitiveCullStageDetails::cullShaderPath, VK_SHADER_STAGE_COMPUTE_BIT, runtimeDefines, defines);
+    const bool meshPipeline = RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh;
+    const bool meshletCulling = ForwardUtils::UseMeshletCulling();
+    
+    const size_t chunkStride = meshPipeline ? sizeof(gpu::VkDrawMeshTasksIndirectCommandEXT) : sizeof(uint32_t);
+    const size_t commandStride = meshPipeline ? sizeof(gpu::TaskCommand) : sizeof(gpu::VkDrawIndexedIndirectCommand);
+    
+    const auto maxChunkCount = static_cast<uint32_t>((renderContext->drawChunkBuffer.GetDescription().size - sizeof(uint32_t)) / chunkStride);
+    const auto commandCapacity = static_cast<uint32_t>(meshletCulling
+        ? (renderContext->meshletDrawBuffer.GetDescription().size - sizeof(gpu::MeshletDraws)) / commandStride
+        : renderContext->commandBuffer.GetDescription().size / commandStride);
+    
+    // Meshlet commands are counted in the header of their buffer
+    const std::vector<VkDescriptorSet>& chunksDescriptors = meshletCulling ? meshletDrawChunksDescriptors : drawChunksDescriptors;
+    
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, drawChunksPipeline);
+    
+    PushConstants(cmd, drawChunksPipeline, "chunkSize", meshPipeline
+        ? ForwardUtils::GetTaskChunkSize(*vulkanContext) : ForwardUtils::GetDrawChunkSize(*vulkanContext));
+    PushConstants(cmd, drawChunksPipeline, "commandCapacity", commandCapacity);
+    
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, drawChunksPipeline.GetLayout(), 0,
+        static_cast<uint32_t>(chunksDescriptors.size()), chunksDescriptors.data(), 0, nullptr);
+    
+    vkCmdDispatch(cmd, GroupCount(maxChunkCount, gpu::drawChunksWgSize), 1, 1);
+}
+
+void PrimitiveCullStage::ExecuteCpuCulling(const Frame& frame)
+{
+    using namespace SynchronizationUtils;
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    const RenderOptions& renderOptions = RenderOptions::Get();
+    const bool meshPipeline = renderOptions.GetGraphicsPipelineType() == GraphicsPipelineType::eMesh;
+    const bool debugBounds = ForwardUtils::UseDebugBounds();
+    
+    if (!cpuCuller)
+    {
+        CreateCpuCuller();
+    }
+    
+    const CpuCullingCommands commands = PrimitiveCullStageDetails::GetCpuCullingCommands(*vulkanContext);
+    const size_t taskCommandCapacity = renderContext->commandBuffer.GetDescription().size / sizeof(gpu::TaskCommand);
+    
+    cpuCuller->Cull(renderContext->globals, commands, taskCommandCapacity, cpuCullingOutput);
+    
+    // Upload buffer layout: visible instances, instance LODs (only when visualized), instance primitive LODs (only for
+    // visibility buffer with vertex pipeline), commands, visible draws (only for debug bounds)
+    const std::span<const std::byte> instanceData = std::as_bytes(std::span(cpuCullingOutput.visibleInstances));
+    const std::span<const std::byte> lodData = renderOptions.GetVisualizeLods()
+        ? std::as_bytes(std::span(cpuCullingOutput.instanceLods)) : std::span<const std::byte>();
+    const std::span<const std::byte> primitiveLodData = ForwardUtils::UseVisibilityBuffer() && !meshPipeline
+        ? std::as_bytes(std::span(cpuCullingOutput.instancePrimitiveLods)) : std::span<const std::byte>();
+    const std::span<const std::byte> commandData = meshPipeline
+        ? std::as_bytes(std::span(cpuCullingOutput.taskCommands)) : std::as_bytes(std::span(cpuCullingOutput.indirectCommands));
+    const std::span<const std::byte> visibleDrawData = debugBounds
+        ? std::as_bytes(std::span(cpuCullingOutput.visibleDraws)) : std::span<const std::byte>();
+    
+    const size_t lodDataOffset = instanceData.size();
+    const size_t primitiveLodDataOffset = lodDataOffset + lodData.size();
+    const size_t commandDataOffset = primitiveLodDataOffset + primitiveLodData.size();
+    const size_t visibleDrawDataOffset = commandDataOffset + commandData.size();
+    const size_t uploadSize = visibleDrawDataOffset + visibleDrawData.size();
+    
+    Buffer& uploadBuffer = GetUploadBuffer(frame.index, uploadSize);
+    
+    const std::span<std::byte> uploadMemory = uploadBuffer.MapMemory();
+    std::ranges::copy(instanceData, uploadMemory.begin());
+    std::ranges::copy(lodData, uploadMemory.begin() + static_cast<ptrdiff_t>(lodDataOffset));
+    std::ranges::copy(primitiveLodData, uploadMemory.begin() + static_cast<ptrdiff_t>(primitiveLodDataOffset));
+    std::ranges::copy(commandData, uploadMemory.begin() + static_cast<ptrdiff_t>(commandDataOffset));
+    std::ranges::copy(visibleDrawData, uploadMemory.begin() + static_cast<ptrdiff_t>(visibleDrawDataOffset));
+    
+    const auto commandCount = static_cast<uint32_t>(commandData.size() / (meshPipeline
+        ? sizeof(gpu::TaskCommand) : sizeof(gpu::VkDrawIndexedIndirectCommand)));
+    
+    const gpu::DrawCounters drawCounters = {
+        .firstPassDrawCount = static_cast<uint32_t>(cpuCullingOutput.visibleInstances.size()),
+        .secondPassDrawCount = 0,
+        .reprojectedDrawCount = 0,
+        .overflowCommandCount = cpuCullingOutput.overflowCommandCount,
+        .extraViewDrawCounts = {} }; // Extra views are culled only on GPU
+    
+    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eFirstCullingPassBegin);
+    
+    // Outputs are read by draws and draw chunks of the previous frame, draw counters by their readback
+    SetMemoryBarrier(cmd, Barriers::indirectCommandReadToTransferWrite | Barriers::transferReadToTransferWrite
+        | Barriers::computeReadToTransferWrite
+        | (meshPipeline ? Barriers::taskAndMeshReadToTransferWrite : Barriers::vertexReadToTransferWrite));
+    
+    if (meshPipeline && debugBounds) // Debug bounds of the previous frame are drawn by the vertex pipeline
+    {
+        SetMemoryBarrier(cmd, Barriers::vertexReadToTransferWrite);
+    }
+    
+    if (!instanceData.empty())
+    {
+        BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->visibleInstanceBuffer, instanceData.size(), 0, 0);
+    }
+    
+    if (!lodData.empty())
+    {
+        BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->drawsDebugDataBuffer, lodData.size(), lodDataOffset, 0);
+    }
+    
+    if (!primitiveLodData.empty())
+    {
+        BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->instanceLodBuffer, primitiveLodData.size(),
+            primitiveLodDataOffset, 0);
+    }
+    
+    if (!commandData.empty())
+    {
+        BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->commandBuffer, commandData.size(), commandDataOffset, 0);
+    }
+    
+    vkCmdUpdateBuffer(cmd, renderContext->commandCountBuffer, 0, sizeof(uint32_t), &commandCount);
+    vkCmdUpdateBuffer(cmd, drawCountersBuffer, 0, sizeof(gpu::DrawCounters), &drawCounters);
+    
+    if (ForwardUtils::UseImpostors()) // CPU culler keeps geometry of all visible draws, so no impostors are drawn
+    {
+        vkCmdUpdateBuffer(cmd, renderContext->impostorDrawBuffer, 0, sizeof(gpu::ImpostorCommands),
+            &PrimitiveCullStageDetails::emptyImpostorCommands);
+    }
+    
+    if (debugBounds)
+    {
+        if (!visibleDrawData.empty())
+        {
+            BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->debugBoundsBuffer, visibleDrawData.size(),
+                visibleDrawDataOffset, sizeof(gpu::DebugBoundsCommands));
+        }
+        
+        PrimitiveCullStageDetails::SetDebugBoundsInstanceCount(cmd, renderContext->debugBoundsBuffer,
+            static_cast<uint32_t>(cpuCullingOutput.visibleDraws.size()));
+    }
+    
+    if (PrimitiveCullStageDetails::UseDrawChunks(*vulkanContext))
+    {
+        SetMemoryBarrier(cmd, Barriers::transferWriteToComputeRead);
+        DispatchDrawChunks(cmd);
+    }
+    
+    if (meshPipeline)
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToIndirectCommandRead | Barriers::transferWriteToIndirectCommandRead
+            | Barriers::transferWriteToTaskAndMeshRead);
+        
+        if (debugBounds)
+        {
+            SetMemoryBarrier(cmd, Barriers::transferWriteToVertexRead);
+        }
+    }
+    else
+    {
+        SetMemoryBarrier(cmd, Barriers::computeWriteToIndirectCommandRead | Barriers::transferWriteToIndirectCommandRead
+            | Barriers::transferWriteToVertexRead);
+    }
+    
+    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eFirstCullingPassEnd);
+}
+
+void PrimitiveCullStage::CreateCpuCuller()
+{
+    const RawScene& rawScene = scene->GetRaw();
+    cpuCuller = std::make_unique<CpuCuller>(vulkanContext->GetThreadPool(), rawScene.primitives, rawScene.primitiveBounds, sceneDraws);
+}
+
+void PrimitiveCullStage::CopyValidationData(const Frame& frame)
+{
+    using namespace SynchronizationUtils;
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    const size_t debugBoundsSize = renderContext->debugBoundsBuffer.GetDescription().size;
+    
+    if (validationReadbackBuffers.empty())
+    {
+        const BufferDescription readbackBufferDescription = {
+            .size = debugBoundsSize + sizeof(uint32_t),
+            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+        
+        for (uint32_t i = 0; i < VulkanConfig::maxFramesInFlight; ++i)
+        {
+            validationReadbackBuffers.emplace_back(readbackBufferDescription, false, *vulkanContext);
+        }
+        
+        validationGlobals.resize(VulkanConfig::maxFramesInFlight);
+    }
+    
+    // Layout: debug bounds commands and visible draws, then command count
+    SetMemoryBarrier(cmd, Barriers::computeWriteToTransferRead);
+    BufferUtils::CopyBufferToBuffer(cmd, renderContext->debugBoundsBuffer, validationReadbackBuffers[frame.index],
+        debugBoundsSize);
+    BufferUtils::CopyBufferToBuffer(cmd, renderContext->commandCountBuffer, validationReadbackBuffers[frame.index],
+        sizeof(uint32_t), 0, debugBoundsSize);
+    SetMemoryBarrier(cmd, Barriers::transferWriteToHostRead);
+    
+    validationGlobals[frame.index] = renderContext->globals;
+}
+
+void PrimitiveCullStage::ValidateCpuCulling(const Frame& frame)
+{
+    if (!cpuCuller)
+    {
+        CreateCpuCuller();
+    }
+    
+    const CpuCullingCommands commands = PrimitiveCullStageDetails::GetCpuCullingCommands(*vulkanContext);
+    const size_t taskCommandCapacity = renderContext->commandBuffer.GetDescription().size / sizeof(gpu::TaskCommand);
+    
+    cpuCuller->Cull(*validationGlobals[frame.index], commands, taskCommandCapacity, cpuCullingOutput);
+    validationGlobals[frame.index].reset();
+    
+    const std::span<const std::byte> readback = validationReadbackBuffers[frame.index].MapMemory();
+    const size_t debugBoundsSize = renderContext->debugBoundsBuffer.GetDescription().size;
+    
+    gpu::DebugBoundsCommands debugBoundsCommands;
+    std::memcpy(&debugBoundsCommands, readback.data(), sizeof(debugBoundsCommands));
+    
+    uint32_t gpuCommandCount = 0;
+    std::memcpy(&gpuCommandCount, readback.data() + debugBoundsSize, sizeof(gpuCommandCount));
+    
+    // GPU appends visible draws in any order, CPU culler writes them sorted
+    std::vector<uint32_t> gpuVisibleDraws(debugBoundsCommands.spheres.instanceCount);
+    std::memcpy(gpuVisibleDraws.data(), readback.data() + sizeof(debugBoundsCommands),
+        gpuVisibleDraws.size() * sizeof(uint32_t));
+    std::ranges::sort(gpuVisibleDraws);
+    
+    std::vector<uint32_t> gpuOnlyDraws;
+    std::vector<uint32_t> cpuOnlyDraws;
+    std::ranges::set_difference(gpuVisibleDraws, cpuCullingOutput.visibleDraws, std::back_inserter(gpuOnlyDraws));
+    std::ranges::set_difference(cpuCullingOutput.visibleDraws, gpuVisibleDraws, std::back_inserter(cpuOnlyDraws));
+    
+    // Per draw commands of culled draws are left in place, so only the appended ones are counted
+    const size_t cpuCommandCount = commands == CpuCullingCommands::eTask
+        ? cpuCullingOutput.taskCommands.size() : cpuCullingOutput.indirectCommands.size();
+    const bool commandCountMismatch = commands != CpuCullingCommands::eIndexedPerDraw && gpuCommandCount != cpuCommandCount;
+    
+    if (gpuOnlyDraws.empty() && cpuOnlyDraws.empty() && !commandCountMismatch)
+    {
+        return;
+    }
+    
+    LogW << "CPU culling mismatch: " << gpuVisibleDraws.size() << " visible draws on GPU, "
+        << cpuCullingOutput.visibleDraws.size() << " on CPU, " << gpuOnlyDraws.size() << " only on GPU (first "
+        << (gpuOnlyDraws.empty() ? 0 : gpuOnlyDraws.front()) << "), " << cpuOnlyDraws.size() << " only on CPU (first "
+        << (cpuOnlyDraws.empty() ? 0 : cpuOnlyDraws.front()) << "), " << gpuCommandCount << " commands on GPU, "
+        << cpuCommandCount << " on CPU\n";
+}
+
+void PrimitiveCullStage::SeedVisibility(const Frame& frame)
+{
+    using namespace SynchronizationUtils;
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    const gpu::PushConstants& globals = renderContext->globals;
+    
+    if (!softwareOcclusionCuller)
+    {
+        softwareOcclusionCuller = std::make_unique<SoftwareOcclusionCuller>(vulkanContext->GetThreadPool(),
+            scene->GetRaw(), sceneDraws, sceneDrawClusters);
+    }
+    
+    seededDrawsVisibility.resize(std::min(static_cast<size_t>(globals.drawCount), sceneDraws.size()));
+    seededClusterVisibility.resize(std::min(static_cast<size_t>(globals.clusterCount), sceneDrawClusters.size()));
+    
+    softwareOcclusionCuller->Cull(globals, seededDrawsVisibility, seededClusterVisibility);
+    
+    // Upload buffer layout: draws visibility, cluster visibility
+    const std::span<const std::byte> drawsData = std::as_bytes(std::span(seededDrawsVisibility));
+    const std::span<const std::byte> clusterData = std::as_bytes(std::span(seededClusterVisibility));
+    
+    Buffer& uploadBuffer = GetUploadBuffer(frame.index, drawsData.size() + clusterData.size());
+    
+    const std::span<std::byte> uploadMemory = uploadBuffer.MapMemory();
+    std::ranges::copy(drawsData, uploadMemory.begin());
+    std::ranges::copy(clusterData, uploadMemory.begin() + static_cast<ptrdiff_t>(drawsData.size()));
+    
+    // Visibility is written by the second pass of the previous frame
+    SetMemoryBarrier(cmd, Barriers::computeWriteToTransferWrite);
+    
+    if (!drawsData.empty())
+    {
+        BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->drawsVisibilityBuffer, drawsData.size(), 0, 0);
+    }
+    
+    if (!clusterData.empty())
+    {
+        BufferUtils::CopyBufferToBuffer(cmd, uploadBuffer, renderContext->clusterVisibilityBuffer, clusterData.size(),
+            drawsData.size(), 0);
+    }
+}
+
+Buffer& PrimitiveCullStage::GetUploadBuffer(const uint32_t frameIndex, const size_t size)
+{
+    Buffer& uploadBuffer = uploadBuffers[frameIndex];
+    
+    if (!uploadBuffer.IsValid() || uploadBuffer.GetDescription().size < size)
+    {
+        const BufferDescription uploadBufferDescription = {
+            .size = std::bit_ceil(std::max(size, sizeof(gpu::DrawCounters))),
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+        
+        uploadBuffer = Buffer(uploadBufferDescription, false, *vulkanContext);
+    }
+    
+    return uploadBuffer;
+}
+
+Pipeline PrimitiveCullStage::BuildInstancedCommandsPipeline(const bool commandPass) const
+{
+    std::vector runtimeDefines = { gpu::defines::drawIndirectCount };
+    std::vector<ShaderDefine> defines = { { "COMMAND_PASS", commandPass } };
+    
+    ShaderModule shader = GetShader(PrimitiveCullStageDetails::instancedCommandsShaderPath, VK_SHADER_STAGE_COMPUTE_BIT,
+        runtimeDefines, defines);
+    
+    return PrimitiveCullStageDetails::BuildChunkedDispatchPipeline(shader, *vulkanContext);
+}
+
+void PrimitiveCullStage::BuildInstancedCommandsDescriptors()
+{
+    ReflectiveDescriptorSetBuilder builder = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(instancedCommandsPipeline, DescriptorScope::eSceneRenderer)
+        .Bind("DrawBuckets", renderContext->drawBucketBuffer)
+        .Bind("InstancedDraws", renderContext->instancedDrawBuffer)
+        .Bind("Primitives", renderContext->primitiveBuffer)
+        .Bind("IndirectCommands", renderContext->commandBuffer);
+    
+    if (instancedCommandsPipeline.HasBinding("CommandCount"))
+    {
+        builder.Bind("CommandCount", renderContext->commandCountBuffer);
+    }
+    
+    instancedCommandsDescriptors = builder.Build();
+    
+    instancesDescriptors = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(instancesPipeline, DescriptorScope::eSceneRenderer)
+        .Bind("DrawBuckets", renderContext->drawBucketBuffer)
+        .Bind("InstancedDraws", renderContext->instancedDrawBuffer)
+        .Bind("Instances", renderContext->instanceBuffer)
+        .Build();
+}
+
+Pipeline PrimitiveCullStage::BuildDrawChunksPipeline() const
+{
+    std::vector runtimeDefines = { gpu::defines::meshPipeline };
+    
+    ShaderModule shader = GetShader(PrimitiveCullStageDetails::drawChunksShaderPath, VK_SHADER_STAGE_COMPUTE_BIT, runtimeDefines, {});
     
     return ComputePipelineBuilder(*vulkanContext)
         .SetShaderModule(shader)
         .Build();
 }
 
-std::vector<VkDescriptorSet> PrimitiveCullStage::BuildDescriptors(const Pipeline& aPipeline)
+void PrimitiveCullStage::BuildDrawChunksDescriptors()
 {
-    const bool meshPipeline = RenderOptions::Get().GetGraphicsPipelineType() == GraphicsPipelineType::eMesh;
+    drawChunksDescriptors = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(drawChunksPipeline, DescriptorScope::eSceneRenderer)
+        .Bind("CommandCount", renderContext->commandCountBuffer)
+        .Bind("DrawChunks", renderContext->drawChunkBuffer)
+        .Build();
     
+    if (renderContext->meshletDrawBuffer.IsValid())
+    {
+        meshletDrawChunksDescriptors = vulkanContext->GetDescriptorSetsManager()
+            .GetReflectiveDescriptorSetBuilder(drawChunksPipeline, DescriptorScope::eSceneRenderer)
+            .Bind("CommandCount", renderContext->meshletDrawBuffer)
+            .Bind("DrawChunks", renderContext->drawChunkBuffer)
+            .Build();
+    }
+}
+
+Pipeline PrimitiveCullStage::BuildMeshletCullPipeline(const bool occlusionCulling) const
+{
+    std::vector<ShaderDefine> defines = { { "OCCLUSION_CULLING", occlusionCulling } };
+    
+    ShaderModule shader = GetShader(PrimitiveCullStageDetails::meshletCullShaderPath, VK_SHADER_STAGE_COMPUTE_BIT, {}, defines);
+    
+    return ComputePipelineBuilder(*vulkanContext)
+        .SetShaderModule(shader)
+        .Build();
+}
+
+std::vector<VkDescriptorSet> PrimitiveCullStage::BuildMeshletCullDescriptors(const Pipeline& aPipeline)
+{
+    return vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(aPipeline, DescriptorScope::eSceneRenderer)
+        .Bind("MeshletData32", renderContext->meshletDataBuffer)
+        .Bind("Meshlets", renderContext->meshletBuffer)
+        .Bind("MeshletBoundsBuffer", renderContext->meshletBoundsBuffer)
+        .Bind("VisibleInstances", renderContext->visibleInstanceBuffer)
+        .Bind("TaskCommands", renderContext->commandBuffer)
+        .Bind("CommandCount", renderContext->commandCountBuffer)
+        .Bind("MeshletDrawsBuffer", renderContext->meshletDrawBuffer)
+        .Bind("MeshletIndices", renderContext->meshletIndexBuffer)
+        .Bind("DrawCountersBuffer", drawCountersBuffer)
+        .Build();
+}
+
+void PrimitiveCullStage::CreateDrawCountersBuffers()
+{
+    constexpr PrimitiveCullStageDetails::DrawCountersReadback zeroReadback = {};
+    const std::span zeroReadbackSpan(&zeroReadback, 1);
+    
+    // Extra view draw counts can be used as draw indirect counts
+    const BufferDescription drawCountersBufferDescription = {
+        .size = sizeof(gpu::DrawCounters),
+        .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+            | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    drawCountersBuffer = Buffer(drawCountersBufferDescription, false, *vulkanContext);
+    
+    const BufferDescription readbackBufferDescription = {
+        .size = sizeof(PrimitiveCullStageDetails::DrawCountersReadback),
+        .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+    
+    for (uint32_t i = 0; i < VulkanConfig::maxFramesInFlight; ++i)
+    {
+        drawCountersReadbackBuffers.emplace_back(readbackBufferDescription, false, zeroReadbackSpan, *vulkanContext);
+    }
+}
+
+std::vector<VkDescriptorSet> PrimitiveCullStage::BuildDescriptors(const Pipeline& aPipeline)
+{
     ReflectiveDescriptorSetBuilder builder = vulkanContext->GetDescriptorSetsManager()
         .GetReflectiveDescriptorSetBuilder(aPipeline, DescriptorScope::eSceneRenderer)
+        .Bind("PrimitiveBoundsBuffer", renderContext->primitiveBoundsBuffer)
         .Bind("Primitives", renderContext->primitiveBuffer)
         .Bind("Draws", renderContext->drawBuffer)
-        .Bind("CommandCount", renderContext->commandCountBuffer)
-        .Bind(meshPipeline ? "TaskCommands" : "IndirectCommands", renderContext->commandBuffer)
-        .Bind("Primitives", renderContext->primitiveBuffer);
+        .Bind("DrawCountersBuffer", drawCountersBuffer)
+        .Bind("VisibleInstances", renderContext->visibleInstanceBuffer);
+    
+    if (aPipeline.HasBinding("CommandCount"))
+    {
+        builder.Bind("CommandCount", renderContext->commandCountBuffer);
+        builder.Bind(aPipeline.HasBinding("TaskCommands") ? "TaskCommands" : "IndirectCommands", renderContext->commandBuffer);
+    }
+    
+    if (aPipeline.HasBinding("MeshletDrawsBuffer"))
+    {
+        builder.Bind("MeshletDrawsBuffer", renderContext->meshletDrawBuffer);
+    }
+    
+    if (aPipeline.HasBinding("DrawBuckets"))
+    {
+        builder.Bind("DrawBuckets", renderContext->drawBucketBuffer);
+        builder.Bind("InstancedDraws", renderContext->instancedDrawBuffer);
+    }
     
     if (aPipeline.HasBinding("DrawsVisibility"))
     {
         builder.Bind("DrawsVisibility", renderContext->drawsVisibilityBuffer);
     }
     
+    if (aPipeline.HasBinding("Reprojection"))
+    {
+        builder.Bind("Reprojection", reprojectionDataBuffer);
+    }
+    
+    if (aPipeline.HasBinding("ExtraViewsBuffer"))
+    {
+        builder.Bind("ExtraViewsBuffer", renderContext->extraViewsBuffer);
+        builder.Bind("ExtraViewInstances", renderContext->extraViewInstanceBuffer);
+        builder.Bind("ExtraViewCommands", renderContext->extraViewCommandBuffer);
+    }
+    
+    if (aPipeline.HasBinding("DrawClusters"))
+    {
+        builder.Bind("DrawClusters", renderContext->drawClusterBuffer);
+        builder.Bind("VisibleClusters", renderContext->visibleClustersBuffer);
+        builder.Bind("ClusterDispatchBuffer", renderContext->clusterDispatchBuffer);
+    }
+    
+    if (aPipeline.HasBinding("InstanceLods"))
+    {
+        builder.Bind("InstanceLods", renderContext->instanceLodBuffer);
+    }
+    
+    if (aPipeline.HasBinding("ImpostorDrawsBuffer"))
+    {
+        builder.Bind("ImpostorDrawsBuffer", renderContext->impostorDrawBuffer);
+    }
+    
+    if (aPipeline.HasBinding("DebugBoundsBuffer"))
+    {
+        builder.Bind("DebugBoundsBuffer", renderContext->debugBoundsBuffer);
+    }
+    
     if (RenderOptions::Get().GetVisualizeLods())
     {
         builder.Bind("DrawsDebugData", renderContext->drawsDebugDataBuffer);
@@ -270,6 +1290,74 @@ std::vector<VkDescriptorSet> PrimitiveCullStage::BuildDescriptors(const Pipeline
     return builder.Build();
 }
 
+void PrimitiveCullStage::BuildPassDescriptors()
+{
+    if (RenderOptions::Get().GetOcclusionCulling())
+    {
+        firstPassDescriptors = BuildDescriptors(firstPassPipeline);
+        reprojectionFirstPassDescriptors = BuildDescriptors(reprojectionFirstPassPipeline);
+        secondPassDescriptors = BuildDescriptors(secondPassPipeline);
+        
+        if (clusterFirstPassPipeline.IsValid())
+        {
+            clusterFirstPassDescriptors = BuildClusterCullDescriptors(clusterFirstPassPipeline);
+            clusterReprojectionFirstPassDescriptors = BuildClusterCullDescriptors(clusterReprojectionFirstPassPipeline);
+            clusterSecondPassDescriptors = BuildClusterCullDescriptors(clusterSecondPassPipeline);
+        }
+    }
+    else
+    {
+        descriptors = BuildDescriptors(pipeline);
+        
+        if (clusterCullPipeline.IsValid())
+        {
+            clusterCullDescriptors = BuildClusterCullDescriptors(clusterCullPipeline);
+        }
+    }
+    
+    // Created only for scenes with meshlets on devices with draw indirect count
+    if (renderContext->meshletDrawBuffer.IsValid() && meshletCullPipeline.IsValid())
+    {
+        meshletCullDescriptors = BuildMeshletCullDescriptors(meshletCullPipeline);
+        
+        if (meshletCullSecondPassPipeline.IsValid())
+        {
+            meshletCullSecondPassDescriptors = BuildMeshletCullDescriptors(meshletCullSecondPassPipeline);
+        }
+    }
+    
+    if (instancedCommandsPipeline.IsValid())
+    {
+        BuildInstancedCommandsDescriptors();
+    }
+    
+    if (drawChunksPipeline.IsValid())
+    {
+        BuildDrawChunksDescriptors();
+    }
+}
+
+std::vector<VkDescriptorSet> PrimitiveCullStage::BuildClusterCullDescriptors(const Pipeline& aPipeline)
+{
+    ReflectiveDescriptorSetBuilder builder = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(aPipeline, DescriptorScope::eSceneRenderer)
+        .Bind("DrawClusters", renderContext->drawClusterBuffer)
+        .Bind("VisibleClusters", renderContext->visibleClustersBuffer)
+        .Bind("ClusterDispatchBuffer", renderContext->clusterDispatchBuffer);
+    
+    if (aPipeline.HasBinding("ClusterVisibility"))
+    {
+        builder.Bind("ClusterVisibility", renderContext->clusterVisibilityBuffer);
+    }
+    
+    if (aPipeline.HasBinding("ExtraViewsBuffer"))
+    {
+        builder.Bind("ExtraViewsBuffer", renderContext->extraViewsBuffer);
+    }
+    
+    return builder.Build();
+}
+
 void PrimitiveCullStage::CreateDepthPyramidRenderTargetAndSampler()
 {
     const VkExtent2D swapchainExtent = vulkanContext->GetSwapchain().GetExtent();
@@ -289,6 +1377,7 @@ void PrimitiveCullStage::CreateDepthPyramidRenderTargetAndSampler()
         .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
     
     depthPyramidRenderTarget = RenderTarget(std::move(pyramidImageDescription), VK_IMAGE_ASPECT_COLOR_BIT, *vulkanContext);
+    reprojectionData.bValid = 0; // Nothing to reproject until it's built
     
     vulkanContext->GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
         ImageUtils::TransitionLayout(cmd, depthPyramidRenderTarget, LayoutTransitions::undefinedToShaderReadOnlyOptimal, Barriers::noneToComputeWrite);
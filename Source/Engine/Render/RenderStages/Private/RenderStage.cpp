@@ -1,12 +1,93 @@
 #include "Engine/Render/RenderStages/RenderStage.hpp"
 
+namespace RenderStageDetails
+{
+    struct PipelineBuildJob
+    {
+        Pipeline* result = nullptr;
+        const std::function<Pipeline()>* buildFunction = nullptr;
+    };
+    
+    // Set on the executing thread for the duration of a build function call, see RenderStage::GetPipelineVariant
+    static thread_local const RenderStage::PipelineVariant* buildVariant = nullptr;
+    
+    static Pipeline CallBuildFunction(const std::function<Pipeline()>& buildFunction,
+        const RenderStage::PipelineVariant& variant)
+    {
+        buildVariant = &variant;
+        
+        Pipeline pipeline = buildFunction();
+        
+        buildVariant = nullptr;
+        
+        return pipeline;
+    }
+    
+    // Jobs write only their own results, so they don't need any synchronization between each other
+    static void ExecuteJobs(const std::span<const PipelineBuildJob> jobs, const RenderStage::PipelineVariant& variant,
+        ThreadPool& threadPool)
+    {
+        threadPool.ParallelFor(jobs.size(), 1, [&](const size_t begin, const size_t end) {
+            for (const PipelineBuildJob& job : jobs.subspan(begin, end - begin))
+            {
+                *job.result = CallBuildFunction(*job.buildFunction, variant);
+            }
+        });
+    }
+    
+    static RenderStage::PipelineVariant GetCurrentVariant(const RenderContext& renderContext)
+    {
+        const RenderOptions& renderOptions = RenderOptions::Get();
+        
+        RenderStage::PipelineVariant variant;
+        
+        for (const auto& [name, getter] : renderContext.runtimeDefineGetters)
+        {
+            variant.defines.emplace_back(name, getter());
+        }
+        
+        variant.sampleCount = renderOptions.GetMsaaSampleCount();
+        variant.occlusionCulling = renderOptions.GetOcclusionCulling();
+        variant.renderPass = renderContext.renderPass;
+        variant.firstRenderPass = renderContext.firstRenderPass;
+        variant.secondRenderPass = renderContext.secondRenderPass;
+        variant.visibilityResolveRenderPass = renderContext.visibilityResolveRenderPass;
+        
+        return variant;
+    }
+    
+    static RenderStage::PipelineVariant ApplyOverrides(RenderStage::PipelineVariant variant,
+        const RenderStage::DefineOverrides& overrides)
+    {
+        for (const auto& [name, value] : overrides)
+        {
+            const auto it = std::ranges::find(variant.defines, name, &ShaderDefine::first);
+            Assert(it != variant.defines.end());
+            
+            it->second = value;
+        }
+        
+        return variant;
+    }
+}
+
+int RenderStage::PipelineVariant::GetDefine(const std::string_view name) const
+{
+    const auto it = std::ranges::find(defines, name, &ShaderDefine::first);
+    Assert(it != defines.end());
+    
+    return it->second;
+}
+
 RenderStage::RenderStage(const VulkanContext& aVulkanContext, const RenderContext& aRenderContext)
     : vulkanContext{ &aVulkanContext }
     , renderContext{ &aRenderContext }
 {}
 
 RenderStage::~RenderStage()
-{}
+{
+    Assert(precompilationJobCount == 0); // See CancelPrecompilation
+}
 
 void RenderStage::CreateRenderTargetDependentResources()
 {}
@@ -26,27 +107,150 @@ void RenderStage::Execute(const Frame& frame)
 void RenderStage::RebuildDescriptors()
 {}
 
-bool RenderStage::TryRebuildPipelines()
+void RenderStage::BuildPipelines(const std::span<RenderStage* const> renderStages)
+{
+    using namespace RenderStageDetails;
+    
+    Assert(!renderStages.empty());
+    
+    const PipelineVariant variant = GetCurrentVariant(*renderStages.front()->renderContext);
+    
+    std::vector<PipelineBuildJob> jobs;
+    
+    for (RenderStage* stage : renderStages)
+    {
+        for (PipelineData& data : stage->pipelineData)
+        {
+            if (IsRequired(data))
+            {
+                jobs.push_back({ data.pipeline, &data.buildFunction });
+            }
+        }
+    }
+    
+    ExecuteJobs(jobs, variant, renderStages.front()->vulkanContext->GetThreadPool());
+    
+    Assert(std::ranges::all_of(jobs, [](const PipelineBuildJob& job) { return job.result->IsValid(); }));
+}
+
+bool RenderStage::TryRebuildPipelines(const std::span<RenderStage* const> renderStages)
 {
-    std::ranges::transform(pipelineData, std::back_inserter(rebuiltPipelines), [&](const auto& pair) { return pair.second(); });
+    using namespace RenderStageDetails;
+    
+    Assert(!renderStages.empty());
+    
+    const PipelineVariant variant = GetCurrentVariant(*renderStages.front()->renderContext);
+    
+    std::vector<PipelineBuildJob> jobs;
+    
+    for (RenderStage* stage : renderStages)
+    {
+        Assert(stage->rebuiltPipelines.empty());
+        
+        // Unrequired ones stay invalid, so applying them releases pipelines which aren't used anymore
+        stage->rebuiltPipelines.resize(stage->pipelineData.size());
+        
+        for (size_t i = 0; i < stage->pipelineData.size(); ++i)
+        {
+            if (IsRequired(stage->pipelineData[i]))
+            {
+                jobs.push_back({ &stage->rebuiltPipelines[i], &stage->pipelineData[i].buildFunction });
+            }
+        }
+    }
+    
+    ExecuteJobs(jobs, variant, renderStages.front()->vulkanContext->GetThreadPool());
     
-    if (std::ranges::all_of(rebuiltPipelines, &Pipeline::IsValid))
+    if (std::ranges::all_of(jobs, [](const PipelineBuildJob& job) { return job.result->IsValid(); }))
     {
         return true;
     }
     
-    rebuiltPipelines.clear();
+    for (RenderStage* stage : renderStages)
+    {
+        stage->rebuiltPipelines.clear();
+    }
     
     return false;
 }
 
+bool RenderStage::HasRequiredPipelines(const std::span<RenderStage* const> renderStages)
+{
+    return std::ranges::all_of(renderStages, [](const RenderStage* stage) {
+        return std::ranges::all_of(stage->pipelineData, [](const PipelineData& data) {
+            return !IsRequired(data) || data.pipeline->IsValid();
+        });
+    });
+}
+
+void RenderStage::PrecompilePipelines(const std::span<RenderStage* const> renderStages,
+    const std::span<const DefineOverrides> overrides)
+{
+    using namespace RenderStageDetails;
+    
+    Assert(!renderStages.empty());
+    
+    CancelPrecompilation(renderStages);
+    
+    // Gathered here, so jobs don't read options and render passes which can change while they run
+    const PipelineVariant currentVariant = GetCurrentVariant(*renderStages.front()->renderContext);
+    const auto currentVariantPtr = std::make_shared<const PipelineVariant>(currentVariant);
+    
+    for (RenderStage* stage : renderStages)
+    {
+        stage->precompilationCancelled = false;
+        
+        for (size_t i = 0; i < stage->pipelineData.size(); ++i)
+        {
+            if (!IsRequired(stage->pipelineData[i]))
+            {
+                stage->SubmitPrecompilationJob(i, currentVariantPtr);
+            }
+        }
+    }
+    
+    for (const DefineOverrides& variantOverrides : overrides)
+    {
+        PipelineVariant variant = ApplyOverrides(currentVariant, variantOverrides);
+        
+        if (variant == currentVariant)
+        {
+            continue;
+        }
+        
+        const auto variantPtr = std::make_shared<const PipelineVariant>(std::move(variant));
+        
+        for (RenderStage* stage : renderStages)
+        {
+            for (size_t i = 0; i < stage->pipelineData.size(); ++i)
+            {
+                stage->SubmitPrecompilationJob(i, variantPtr);
+            }
+        }
+    }
+}
+
+void RenderStage::CancelPrecompilation(const std::span<RenderStage* const> renderStages)
+{
+    for (RenderStage* stage : renderStages)
+    {
+        stage->precompilationCancelled = true;
+    }
+    
+    for (RenderStage* stage : renderStages)
+    {
+        std::unique_lock lock(stage->precompilationMutex);
+        stage->precompilationCondition.wait(lock, [stage]() { return stage->precompilationJobCount == 0; });
+    }
+}
+
 void RenderStage::ApplyRebuiltPipelines()
 {
-    Assert(!rebuiltPipelines.empty() && rebuiltPipelines.size() == pipelineData.size());
+    Assert(rebuiltPipelines.size() == pipelineData.size());
     
     for (size_t i = 0; i < rebuiltPipelines.size(); ++i)
     {
-        *pipelineData[i].first = std::move(rebuiltPipelines[i]);
+        *pipelineData[i].pipeline = std::move(rebuiltPipelines[i]);
     }
     
     RebuildDescriptors();
@@ -54,12 +258,17 @@ void RenderStage::ApplyRebuiltPipelines()
     rebuiltPipelines.clear();
 }
 
-void RenderStage::AddPipeline(Pipeline& pipelineReference, PipelineBuildFunction buildFunction)
+void RenderStage::AddPipeline(Pipeline& pipelineReference, PipelineBuildFunction buildFunction,
+    PipelineRequirement requirement /* = {} */)
+{
+    pipelineData.push_back({ &pipelineReference, std::move(buildFunction), std::move(requirement) });
+}
+
+const RenderStage::PipelineVariant& RenderStage::GetPipelineVariant()
 {
-    pipelineData.emplace_back(&pipelineReference, buildFunction);
+    Assert(RenderStageDetails::buildVariant != nullptr); // Build functions are called only by build jobs
     
-    pipelineReference = buildFunction();
-    Assert(pipelineReference.IsValid());
+    return *RenderStageDetails::buildVariant;
 }
 
 ShaderModule RenderStage::GetShader(const std::string_view path, const VkShaderStageFlagBits shaderStage,
@@ -71,10 +280,39 @@ ShaderModule RenderStage::GetShader(const std::string_view path, const VkShaderS
     
     for (const auto& runtimDefine : runtimeDefines)
     {
-        defines.emplace_back(runtimDefine, renderContext->runtimeDefineGetters.at(runtimDefine)());
+        defines.emplace_back(runtimDefine, GetPipelineVariant().GetDefine(runtimDefine));
     }
     
     std::ranges::sort(defines, [](auto &lhs, auto &rhs) { return lhs.first < rhs.first; });
     
     return shaderManager.CreateShaderModule(FilePath(path), shaderStage, defines);
 }
+
+bool RenderStage::IsRequired(const PipelineData& data)
+{
+    return !data.requirement || data.requirement();
+}
+
+void RenderStage::SubmitPrecompilationJob(const size_t index, std::shared_ptr<const PipelineVariant> variant)
+{
+    {
+        std::scoped_lock lock(precompilationMutex);
+        ++precompilationJobCount;
+    }
+    
+    vulkanContext->GetThreadPool().SubmitBackground([this, index, variant = std::move(variant)]() {
+        if (!precompilationCancelled)
+        {
+            // Only caches are kept
+            RenderStageDetails::CallBuildFunction(pipelineData[index].buildFunction, *variant).DestroyUnused();
+        }
+        
+        // Notified under the lock, so waiting thread can't destroy the stage before it's done
+        std::scoped_lock lock(precompilationMutex);
+        
+        if (--precompilationJobCount == 0)
+        {
+            precompilationCondition.notify_all();
+        }
+    });
+}
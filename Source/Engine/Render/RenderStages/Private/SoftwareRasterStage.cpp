@@ -0,0 +1,160 @@
+#include "Engine/Render/RenderStages/SoftwareRasterStage.hpp"
+
+#include "Shaders/Common.h"
+#include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/ComputePipelineBuilder.hpp"
+#include "Engine/Render/Vulkan/Synchronization/SynchronizationUtils.hpp"
+
+namespace SoftwareRasterStageDetails
+{
+    static constexpr std::string_view shaderPath = "~/Shaders/Visibility/SoftwareRaster.comp";
+}
+
+SoftwareRasterStage::SoftwareRasterStage(const VulkanContext& aVulkanContext, RenderContext& aRenderContext)
+    : RenderStage{ aVulkanContext, aRenderContext }
+{
+    // SoftwareRaster.comp needs 64-bit buffer atomics, the option isn't supported without them
+    if (vulkanContext->GetDevice().GetProperties().bufferInt64AtomicsSupported)
+    {
+        AddPipeline(pipeline, [&]() { return BuildPipeline(); });
+    }
+}
+
+SoftwareRasterStage::~SoftwareRasterStage()
+{}
+
+void SoftwareRasterStage::CreateRenderTargetDependentResources()
+{
+    if (renderContext->softwareVisibilityBuffer.IsValid())
+    {
+        BuildVisibilityDescriptor();
+    }
+}
+
+void SoftwareRasterStage::DestroyRenderTargetDependentResources()
+{
+    visibilityDescriptor = VK_NULL_HANDLE;
+}
+
+void SoftwareRasterStage::OnSceneOpen(const Scene& scene)
+{
+    BuildDescriptors();
+}
+
+void SoftwareRasterStage::OnSceneClose()
+{
+    descriptors.clear();
+}
+
+void SoftwareRasterStage::Prepare(const Frame& frame) const
+{
+    using namespace SynchronizationUtils;
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    const VkExtent2D extent = vulkanContext->GetSwapchain().GetExtent();
+    
+    const gpu::SoftwareRaster emptySoftwareRaster = {
+        .command = { 0, 0, 1 },
+        .meshletCount = 0,
+        .screenSize = glm::uvec2(extent.width, extent.height) };
+    
+    // Both are read by rasterization and resolve of the previous frame
+    SetMemoryBarrier(cmd, Barriers::computeReadToTransferWrite | Barriers::fragmentReadToTransferWrite |
+        Barriers::indirectCommandReadToTransferWrite);
+    
+    vkCmdUpdateBuffer(cmd, renderContext->softwareRasterBuffer, 0, sizeof(gpu::SoftwareRaster), &emptySoftwareRaster);
+    vkCmdFillBuffer(cmd, renderContext->softwareVisibilityBuffer, 0, VK_WHOLE_SIZE, 0); // Farthest with reverse Z
+    
+    SetMemoryBarrier(cmd, Barriers::transferWriteToTaskReadWrite | Barriers::transferWriteToFragmentReadWrite);
+}
+
+void SoftwareRasterStage::SynchronizePasses(const Frame& frame) const
+{
+    // Second pass task shaders append after the first pass ones, its fragments merge depth over the first pass
+    SynchronizationUtils::SetMemoryBarrier(frame.commandBuffer,
+        Barriers::taskWriteToTaskReadWrite | Barriers::fragmentWriteToFragmentReadWrite);
+}
+
+void SoftwareRasterStage::Execute(const Frame& frame)
+{
+    using namespace SynchronizationUtils;
+    using namespace PipelineUtils;
+    
+    Assert(visibilityDescriptor != VK_NULL_HANDLE);
+    
+    const VkCommandBuffer cmd = frame.commandBuffer;
+    
+    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eSoftwareRasterBegin);
+    
+    SetMemoryBarrier(cmd, Barriers::taskWriteToComputeRead | Barriers::taskWriteToIndirectCommandRead |
+        Barriers::fragmentWriteToComputeReadWrite);
+    
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    
+    PushConstants(cmd, pipeline, "globals", renderContext->globals);
+    
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetLayout(), 0,
+        static_cast<uint32_t>(descriptors.size()), descriptors.data(), 0, nullptr);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.GetLayout(), 1,
+        1, &visibilityDescriptor, 0, nullptr);
+    
+    // 1 workgroup per appended meshlet, written by task shaders
+    vkCmdDispatchIndirect(cmd, renderContext->softwareRasterBuffer, offsetof(gpu::SoftwareRaster, command));
+    
+    SetMemoryBarrier(cmd, Barriers::computeWriteToFragmentRead);
+    
+    StatsUtils::WriteTimestamp(cmd, frame.queryPools.timestamps, GpuTimestamp::eSoftwareRasterEnd);
+}
+
+void SoftwareRasterStage::RebuildDescriptors()
+{
+    descriptors.clear();
+    visibilityDescriptor = VK_NULL_HANDLE;
+    
+    BuildDescriptors();
+    
+    if (renderContext->softwareVisibilityBuffer.IsValid())
+    {
+        BuildVisibilityDescriptor();
+    }
+}
+
+Pipeline SoftwareRasterStage::BuildPipeline() const
+{
+    ShaderModule shader = GetShader(SoftwareRasterStageDetails::shaderPath, VK_SHADER_STAGE_COMPUTE_BIT, {}, {});
+    
+    return ComputePipelineBuilder(*vulkanContext)
+        .SetShaderModule(shader)
+        .Build();
+}
+
+void SoftwareRasterStage::BuildDescriptors()
+{
+    Assert(descriptors.empty());
+    
+    // Created only for scenes with meshlets on devices with 64-bit buffer atomics
+    if (!renderContext->softwareRasterBuffer.IsValid())
+    {
+        return;
+    }
+    
+    descriptors = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(pipeline, DescriptorScope::eSceneRenderer)
+        .Bind("Vertices", renderContext->vertexBuffer)
+        .Bind("MeshletData32", renderContext->meshletDataBuffer)
+        .Bind("Meshlets", renderContext->meshletBuffer)
+        .Bind("VisibleInstances", renderContext->visibleInstanceBuffer)
+        .Bind("SoftwareRasterBuffer", renderContext->softwareRasterBuffer)
+        .Bind("SoftwareMeshlets", renderContext->softwareMeshletBuffer)
+        .Build();
+}
+
+void SoftwareRasterStage::BuildVisibilityDescriptor()
+{
+    Assert(visibilityDescriptor == VK_NULL_HANDLE);
+    
+    visibilityDescriptor = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(pipeline, DescriptorScope::eGlobal)
+        .Bind("SoftwareVisibility", renderContext->softwareVisibilityBuffer)
+        .Build()[0];
+}
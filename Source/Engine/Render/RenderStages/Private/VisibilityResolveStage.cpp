@@ -0,0 +1,150 @@
+#include "Engine/Render/RenderStages/VisibilityResolveStage.hpp"
+
+#include "Engine/Render/Vulkan/Pipelines/PipelineUtils.hpp"
+#include "Engine/Render/Vulkan/Pipelines/GraphicsPipelineBuilder.hpp"
+
+namespace VisibilityResolveStageDetails
+{
+    static constexpr std::string_view vertexShaderPath = "~/Shaders/Visibility/Fullscreen.vert";
+    static constexpr std::string_view fragmentShaderPath = "~/Shaders/Visibility/VisibilityResolve.frag";
+}
+
+VisibilityResolveStage::VisibilityResolveStage(const VulkanContext& aVulkanContext, RenderContext& aRenderContext)
+    : RenderStage{ aVulkanContext, aRenderContext }
+{
+    AddPipeline(pipeline, [&]() { return BuildPipeline(); });
+}
+
+VisibilityResolveStage::~VisibilityResolveStage()
+{}
+
+void VisibilityResolveStage::CreateRenderTargetDependentResources()
+{
+    if (renderContext->visibilityTarget.IsValid())
+    {
+        BuildVisibilityDescriptor();
+    }
+}
+
+void VisibilityResolveStage::DestroyRenderTargetDependentResources()
+{
+    visibilityDescriptor = VK_NULL_HANDLE;
+}
+
+void VisibilityResolveStage::OnSceneOpen(const Scene& scene)
+{
+    BuildDescriptors();
+}
+
+void VisibilityResolveStage::OnSceneClose()
+{
+    descriptors.clear();
+}
+
+void VisibilityResolveStage::Execute(const Frame& frame)
+{
+    using namespace PipelineUtils;
+    
+    Assert(visibilityDescriptor != VK_NULL_HANDLE);
+    
+    const VkCommandBuffer commandBuffer = frame.commandBuffer;
+    
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    
+    PushConstants(commandBuffer, pipeline, "globals", renderContext->globals);
+    
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetLayout(), 0,
+        static_cast<uint32_t>(descriptors.size()), descriptors.data(), 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetLayout(), 1,
+        1, &visibilityDescriptor, 0, nullptr);
+    
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0); // Fullscreen triangle
+}
+
+void VisibilityResolveStage::RebuildDescriptors()
+{
+    descriptors.clear();
+    visibilityDescriptor = VK_NULL_HANDLE;
+    
+    BuildDescriptors();
+    
+    if (renderContext->visibilityTarget.IsValid())
+    {
+        BuildVisibilityDescriptor();
+    }
+}
+
+Pipeline VisibilityResolveStage::BuildPipeline()
+{
+    using namespace VisibilityResolveStageDetails;
+    
+    std::vector runtimeDefines = { gpu::defines::meshPipeline, gpu::defines::visualizeLods,
+        gpu::defines::softwareRasterization };
+    
+    std::vector<ShaderModule> shaders;
+    
+    shaders.push_back(GetShader(vertexShaderPath, VK_SHADER_STAGE_VERTEX_BIT, {}, {}));
+    shaders.push_back(GetShader(fragmentShaderPath, VK_SHADER_STAGE_FRAGMENT_BIT, runtimeDefines, {}));
+    
+    return GraphicsPipelineBuilder(*vulkanContext)
+        .SetShaderModules(shaders)
+        .SetInputTopology(InputTopology::eTriangleList)
+        .SetPolygonMode(PolygonMode::eFill)
+        .SetCullMode(CullMode::eNone)
+        .SetMultisampling(VK_SAMPLE_COUNT_1_BIT)
+        .SetRenderPass(GetPipelineVariant().visibilityResolveRenderPass)
+        .Build();
+}
+
+void VisibilityResolveStage::BuildDescriptors()
+{
+    Assert(descriptors.empty());
+    
+    ReflectiveDescriptorSetBuilder builder = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(pipeline, DescriptorScope::eSceneRenderer)
+        .Bind("Vertices", renderContext->vertexBuffer)
+        .Bind("VisibleInstances", renderContext->visibleInstanceBuffer)
+        .Bind("LightsBuffer", renderContext->lightBuffer)
+        .Bind("LightClustersBuffer", renderContext->lightClusterBuffer);
+    
+    if (pipeline.HasBinding("Meshlets"))
+    {
+        builder.Bind("MeshletData32", renderContext->meshletDataBuffer);
+        builder.Bind("Meshlets", renderContext->meshletBuffer);
+    }
+    
+    if (pipeline.HasBinding("SoftwareMeshlets"))
+    {
+        builder.Bind("SoftwareMeshlets", renderContext->softwareMeshletBuffer);
+    }
+    
+    if (pipeline.HasBinding("InstanceLods"))
+    {
+        builder.Bind("Indices", renderContext->indexBuffer);
+        builder.Bind("Primitives", renderContext->primitiveBuffer);
+        builder.Bind("InstanceLods", renderContext->instanceLodBuffer);
+    }
+    
+    if (pipeline.HasBinding("DrawsDebugData"))
+    {
+        builder.Bind("DrawsDebugData", renderContext->drawsDebugDataBuffer);
+    }
+    
+    descriptors = builder.Build();
+}
+
+void VisibilityResolveStage::BuildVisibilityDescriptor()
+{
+    Assert(visibilityDescriptor == VK_NULL_HANDLE);
+    
+    ReflectiveDescriptorSetBuilder builder = vulkanContext->GetDescriptorSetsManager()
+        .GetReflectiveDescriptorSetBuilder(pipeline, DescriptorScope::eGlobal)
+        .Bind("visibility", renderContext->visibilityTarget.views[0], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    
+    if (pipeline.HasBinding("SoftwareVisibility") && renderContext->softwareVisibilityBuffer.IsValid())
+    {
+        builder.Bind("SoftwareVisibility", renderContext->softwareVisibilityBuffer);
+    }
+    
+    visibilityDescriptor = builder.Build()[0];
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
 #include "Engine/Scene/Scene.hpp"
 #include "Engine/Render/Vulkan/Frame.hpp"
 #include "Engine/Render/RenderContext.hpp"
@@ -8,6 +12,26 @@
 class RenderStage
 {
 public:
+    // Everything build functions depend on besides shader sources, gathered on the calling thread of BuildPipelines,
+    // TryRebuildPipelines and PrecompilePipelines, so jobs never read options or render passes, see GetPipelineVariant
+    struct PipelineVariant
+    {
+        std::vector<ShaderDefine> defines; // Values of all runtime defines, see RenderContext::runtimeDefineGetters
+        VkSampleCountFlagBits sampleCount = VK_SAMPLE_COUNT_1_BIT;
+        bool occlusionCulling = false;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkRenderPass firstRenderPass = VK_NULL_HANDLE;
+        VkRenderPass secondRenderPass = VK_NULL_HANDLE;
+        VkRenderPass visibilityResolveRenderPass = VK_NULL_HANDLE;
+        
+        int GetDefine(std::string_view name) const;
+        
+        bool operator==(const PipelineVariant&) const = default;
+    };
+    
+    // Runtime define values which replace the current ones in a precompiled variant
+    using DefineOverrides = std::vector<ShaderDefine>;
+    
     RenderStage(const VulkanContext& vulkanContext, const RenderContext& renderContext);
     virtual ~RenderStage();
     
@@ -27,14 +51,37 @@ public:
     
     virtual void RebuildDescriptors();
     
-    bool TryRebuildPipelines();
+    // Pipelines of all stages are built at once by jobs on VulkanContext thread pool, each one compiles its shaders
+    // Only the ones required by the current options are built, the others are left invalid until they're required
+    static void BuildPipelines(std::span<RenderStage* const> renderStages);
+    static bool TryRebuildPipelines(std::span<RenderStage* const> renderStages);
+    // False when a failed rebuild left pipelines required after an option change unbuilt
+    static bool HasRequiredPipelines(std::span<RenderStage* const> renderStages);
+    
+    // Builds pipelines which are likely needed next by background jobs and drops them right away, so their compiled
+    // shaders and pipeline cache entries make the later builds cheap, see ShaderCache and Device::GetPipelineCache
+    // Unrequired pipelines are built with the current variant, all pipelines with each of the overrides applied to it
+    static void PrecompilePipelines(std::span<RenderStage* const> renderStages, std::span<const DefineOverrides> overrides);
+    // Skips precompilation jobs which haven't started yet and waits for the running ones, call before destroying
+    // anything their variants refer to, e.g. render passes
+    static void CancelPrecompilation(std::span<RenderStage* const> renderStages);
+    
     void ApplyRebuiltPipelines();
     
 protected:
     using PipelineBuildFunction = std::function<Pipeline()>;
+    using PipelineRequirement = std::function<bool()>;
     
-    void AddPipeline(Pipeline& pipelineReference, PipelineBuildFunction buildFunction);
+    // Pipeline is built later by BuildPipelines, build function can be called from any thread, so it reads options and
+    // render passes only from GetPipelineVariant
+    // Requirement is checked on the calling thread of BuildPipelines and TryRebuildPipelines, so it has to depend only
+    // on the options which trigger rebuilds, empty one means the pipeline is always required
+    void AddPipeline(Pipeline& pipelineReference, PipelineBuildFunction buildFunction, PipelineRequirement requirement = {});
     
+    // Variant of the pipeline being built, valid only inside build functions
+    static const PipelineVariant& GetPipelineVariant();
+    
+    // Runtime define values are taken from GetPipelineVariant
     ShaderModule GetShader(std::string_view path, VkShaderStageFlagBits shaderStage,
         std::span<std::string_view> runtimeDefines, std::span<const ShaderDefine> defines) const;
     
@@ -42,6 +89,22 @@ protected:
     const RenderContext* const renderContext = nullptr;
     
 private:
-    std::vector<std::pair<Pipeline*, PipelineBuildFunction>> pipelineData;
+    struct PipelineData
+    {
+        Pipeline* pipeline = nullptr;
+        PipelineBuildFunction buildFunction;
+        PipelineRequirement requirement;
+    };
+    
+    static bool IsRequired(const PipelineData& data);
+    
+    void SubmitPrecompilationJob(size_t index, std::shared_ptr<const PipelineVariant> variant);
+    
+    std::vector<PipelineData> pipelineData;
     std::vector<Pipeline> rebuiltPipelines;
+    
+    std::mutex precompilationMutex;
+    std::condition_variable precompilationCondition;
+    uint32_t precompilationJobCount = 0; // Guarded by precompilationMutex
+    std::atomic<bool> precompilationCancelled = false;
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Engine/Render/RenderStages/RenderStage.hpp"
+#include "Engine/Render/Vulkan/Pipelines/Pipeline.hpp"
+
+// Rasterizes meshlets with subpixel triangles in compute into RenderContext::softwareVisibilityBuffer, where
+// Visibility.frag merges hardware depth with the same 64-bit atomics, VisibilityResolve.frag picks the closest of both
+// Meshlets are appended by Meshlet.task during geometry passes, so Prepare() goes before them and Execute() after them
+class SoftwareRasterStage : public RenderStage
+{
+public:
+    SoftwareRasterStage(const VulkanContext& vulkanContext, RenderContext& renderContext);
+    ~SoftwareRasterStage() override;
+    
+    void CreateRenderTargetDependentResources() override;
+    void DestroyRenderTargetDependentResources() override;
+    
+    void OnSceneOpen(const Scene& scene) override;
+    void OnSceneClose() override;
+    
+    void Prepare(const Frame& frame) const; // Resets appended meshlets and the software visibility buffer
+    void SynchronizePasses(const Frame& frame) const; // Between first and second geometry pass with occlusion culling
+    
+    void Execute(const Frame& frame) override;
+    
+    void RebuildDescriptors() override;
+    
+private:
+    Pipeline BuildPipeline() const;
+    void BuildDescriptors();
+    void BuildVisibilityDescriptor();
+    
+    Pipeline pipeline;
+    
+    std::vector<VkDescriptorSet> descriptors;
+    VkDescriptorSet visibilityDescriptor = VK_NULL_HANDLE;
+};
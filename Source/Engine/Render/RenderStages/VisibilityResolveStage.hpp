@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Engine/Render/RenderStages/RenderStage.hpp"
+#include "Engine/Render/Vulkan/Pipelines/Pipeline.hpp"
+
+// Fullscreen pass shading every pixel once from the (visible instance, triangle) IDs of the visibility buffer
+// Executed in RenderContext::visibilityResolveRenderPass when ForwardUtils::UseVisibilityBuffer() is true
+class VisibilityResolveStage : public RenderStage
+{
+public:
+    VisibilityResolveStage(const VulkanContext& vulkanContext, RenderContext& renderContext);
+    ~VisibilityResolveStage() override;
+    
+    void CreateRenderTargetDependentResources() override;
+    void DestroyRenderTargetDependentResources() override;
+    
+    void OnSceneOpen(const Scene& scene) override;
+    void OnSceneClose() override;
+    
+    void Execute(const Frame& frame) override;
+    
+    void RebuildDescriptors() override;
+
+private:
+    Pipeline BuildPipeline();
+    void BuildDescriptors();
+    void BuildVisibilityDescriptor();
+    
+    Pipeline pipeline;
+    
+    std::vector<VkDescriptorSet> descriptors;
+    VkDescriptorSet visibilityDescriptor = VK_NULL_HANDLE;
+};
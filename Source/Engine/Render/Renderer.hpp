@@ -10,4 +10,8 @@ public:
     virtual void Process(const Frame& frame, float deltaSeconds) = 0;
     
     virtual void Render(const Frame& frame) = 0;
+    
+    // Called once frame has finished execution on GPU, before it's recorded again
+    virtual void GatherFrameStats(const Frame& frame, FrameRenderStats& renderStats)
+    {}
 };
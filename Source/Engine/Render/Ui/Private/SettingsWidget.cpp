@@ -1,8 +1,10 @@
 #include "Engine/Render/Ui/SettingsWidget.hpp"
 
+#include "Shaders/Config.h"
 #include "Engine/EventSystem.hpp"
 #include "Engine/Render/Ui/UiStrings.hpp"
 #include "Engine/Render/Ui/UiConstants.hpp"
+#include "Engine/Render/Utils/ForwardUtils.hpp"
 #include "Engine/Render/Vulkan/VulkanContext.hpp"
 
 #include <imgui.h>
@@ -16,6 +18,18 @@ namespace SettingsWidgetDetails
     // Shadow values for checkboxes
     static bool vSync = false;
     static bool occlusionCulling = false;
+    static bool reprojectionOcclusion = false;
+    static bool softwareOcclusion = false;
+    static bool clusterCulling = false;
+    static bool instancedDraws = false;
+    static bool meshletCulling = false;
+    static bool cpuCulling = false;
+    static bool cpuCullingValidation = false;
+    static bool visibilityBuffer = false;
+    static bool softwareRasterization = false;
+    static bool impostors = false;
+    static bool dynamicResolution = false;
+    static bool qualityGovernor = false;
 
     template <typename T>
     static void Combo(const char* label, const std::span<const T> options, std::function<T()> get, std::function<void(T)> set)
@@ -73,9 +87,30 @@ SettingsWidget::SettingsWidget(EventSystem& aEventSystem, const VulkanContext& a
     
     SettingsWidgetDetails::vSync = renderOptions->GetVSync();
     SettingsWidgetDetails::occlusionCulling = renderOptions->GetOcclusionCulling();
+    SettingsWidgetDetails::reprojectionOcclusion = renderOptions->GetReprojectionOcclusion();
+    SettingsWidgetDetails::softwareOcclusion = renderOptions->GetSoftwareOcclusion();
+    SettingsWidgetDetails::clusterCulling = renderOptions->GetClusterCulling();
+    SettingsWidgetDetails::instancedDraws = renderOptions->GetInstancedDraws();
+    SettingsWidgetDetails::meshletCulling = renderOptions->GetMeshletCulling();
+    SettingsWidgetDetails::cpuCulling = renderOptions->GetCpuCulling();
+    SettingsWidgetDetails::cpuCullingValidation = renderOptions->GetCpuCullingValidation();
+    SettingsWidgetDetails::visibilityBuffer = renderOptions->GetVisibilityBuffer();
+    SettingsWidgetDetails::softwareRasterization = renderOptions->GetSoftwareRasterization();
+    SettingsWidgetDetails::impostors = renderOptions->GetImpostors();
+    SettingsWidgetDetails::dynamicResolution = renderOptions->GetDynamicResolution();
+    SettingsWidgetDetails::qualityGovernor = renderOptions->GetQualityGovernor();
     
     eventSystem->Subscribe<RenderOptions::VSyncChanged>(this, &SettingsWidget::OnVSyncChanged);
     eventSystem->Subscribe<RenderOptions::OcclusionCullingChanged>(this, &SettingsWidget::OnOcclusionCullingChanged);
+    eventSystem->Subscribe<RenderOptions::ClusterCullingChanged>(this, &SettingsWidget::OnClusterCullingChanged);
+    eventSystem->Subscribe<RenderOptions::InstancedDrawsChanged>(this, &SettingsWidget::OnInstancedDrawsChanged);
+    eventSystem->Subscribe<RenderOptions::MeshletCullingChanged>(this, &SettingsWidget::OnMeshletCullingChanged);
+    eventSystem->Subscribe<RenderOptions::CpuCullingChanged>(this, &SettingsWidget::OnCpuCullingChanged);
+    eventSystem->Subscribe<RenderOptions::VisibilityBufferChanged>(this, &SettingsWidget::OnVisibilityBufferChanged);
+    eventSystem->Subscribe<RenderOptions::SoftwareRasterizationChanged>(this, &SettingsWidget::OnSoftwareRasterizationChanged);
+    eventSystem->Subscribe<RenderOptions::ImpostorsChanged>(this, &SettingsWidget::OnImpostorsChanged);
+    eventSystem->Subscribe<RenderOptions::DynamicResolutionChanged>(this, &SettingsWidget::OnDynamicResolutionChanged);
+    eventSystem->Subscribe<RenderOptions::QualityGovernorChanged>(this, &SettingsWidget::OnQualityGovernorChanged);
 }
 
 SettingsWidget::~SettingsWidget()
@@ -122,10 +157,108 @@ void SettingsWidget::Build()
                 renderOptions->SetCurrentDrawCount(drawCount);
             }
             
+            Checkbox("Cluster culling", &clusterCulling,
+                [&](const bool aClusterCulling) { renderOptions->SetClusterCulling(aClusterCulling); });
+            
+            if (renderOptions->GetGraphicsPipelineType() == GraphicsPipelineType::eVertex)
+            {
+                Checkbox("Instanced draws", &instancedDraws,
+                    [&](const bool aInstancedDraws) { renderOptions->SetInstancedDraws(aInstancedDraws); });
+                
+                if (renderOptions->IsMeshletCullingSupported(true))
+                {
+                    Checkbox("Meshlet culling", &meshletCulling,
+                        [&](const bool aMeshletCulling) { renderOptions->SetMeshletCulling(aMeshletCulling); });
+                }
+            }
+            
+            if (renderOptions->GetOcclusionCulling())
+            {
+                Checkbox("Reprojection in first pass", &reprojectionOcclusion,
+                    [&](const bool aReprojectionOcclusion) { renderOptions->SetReprojectionOcclusion(aReprojectionOcclusion); });
+                
+                if (!reprojectionOcclusion)
+                {
+                    Checkbox("CPU occlusion on camera cuts", &softwareOcclusion,
+                        [&](const bool aSoftwareOcclusion) { renderOptions->SetSoftwareOcclusion(aSoftwareOcclusion); });
+                }
+            }
+            else
+            {
+                Checkbox("CPU culling", &cpuCulling, [&](const bool aCpuCulling) { renderOptions->SetCpuCulling(aCpuCulling); });
+                
+                if (!cpuCulling)
+                {
+                    Checkbox("Validate against CPU culling", &cpuCullingValidation,
+                        [&](const bool aCpuCullingValidation) { renderOptions->SetCpuCullingValidation(aCpuCullingValidation); });
+                }
+            }
+            
+            // Culled only on GPU, they aren't rendered yet, see draw counts in stats
+            int extraViewCount = static_cast<int>(renderOptions->GetExtraViewCount());
+            if (ImGui::SliderInt("Extra cull views", &extraViewCount, 0, static_cast<int>(gpu::maxExtraViewCount)))
+            {
+                renderOptions->SetExtraViewCount(static_cast<uint32_t>(extraViewCount));
+            }
+            
+            // Culled into light clusters every frame, see LightCull.comp
+            int lightCount = static_cast<int>(renderOptions->GetLightCount());
+            if (ImGui::SliderInt("Lights", &lightCount, 0, static_cast<int>(gpu::maxLightCount)))
+            {
+                renderOptions->SetLightCount(static_cast<uint32_t>(lightCount));
+            }
+            
             Combo<VkSampleCountFlagBits>("MSAA sample count", supportedMsaaSampleCounts,
                 [&]() { return renderOptions->GetMsaaSampleCount(); },
                 [&](auto count) { renderOptions->SetMsaaSampleCount(count); });
             
+            // Single sampled only, shading is done once per pixel
+            if (renderOptions->GetMsaaSampleCount() == VK_SAMPLE_COUNT_1_BIT && renderOptions->IsVisibilityBufferSupported(true))
+            {
+                Checkbox("Visibility buffer", &visibilityBuffer,
+                    [&](const bool aVisibilityBuffer) { renderOptions->SetVisibilityBuffer(aVisibilityBuffer); });
+                
+                // Meshlets with subpixel triangles are rasterized in compute, see SoftwareRaster.comp
+                if (visibilityBuffer && renderOptions->GetGraphicsPipelineType() == GraphicsPipelineType::eMesh &&
+                    renderOptions->IsSoftwareRasterizationSupported(true))
+                {
+                    Checkbox("Software rasterization", &softwareRasterization,
+                        [&](const bool aSoftwareRasterization) { renderOptions->SetSoftwareRasterization(aSoftwareRasterization); });
+                }
+            }
+            
+            // Far draws are drawn as quads of their baked views, see ImpostorStage
+            if (!ForwardUtils::UseVisibilityBuffer())
+            {
+                Checkbox("Impostors", &impostors, [&](const bool aImpostors) { renderOptions->SetImpostors(aImpostors); });
+                
+                // Render scale follows GPU frame time, see ForwardUtils::UpdateRenderScale
+                Checkbox("Dynamic resolution", &dynamicResolution,
+                    [&](const bool aDynamicResolution) { renderOptions->SetDynamicResolution(aDynamicResolution); });
+            }
+            
+            // LOD target and contribution threshold follow budgets, see ForwardUtils::UpdateDetailScale
+            Checkbox("Quality governor", &qualityGovernor,
+                [&](const bool aQualityGovernor) { renderOptions->SetQualityGovernor(aQualityGovernor); });
+            
+            if (qualityGovernor)
+            {
+                int triangleBudget = static_cast<int>(renderOptions->GetTriangleBudget());
+                if (ImGui::SliderInt("Triangle budget (K)", &triangleBudget, 0, 20000))
+                {
+                    renderOptions->SetTriangleBudget(static_cast<uint32_t>(triangleBudget));
+                }
+            }
+            
+            if (ForwardUtils::UseDynamicResolution() || qualityGovernor)
+            {
+                int targetGpuFrameMs = static_cast<int>(renderOptions->GetTargetGpuFrameMs());
+                if (ImGui::SliderInt("Target GPU ms", &targetGpuFrameMs, 4, 50))
+                {
+                    renderOptions->SetTargetGpuFrameMs(static_cast<uint32_t>(targetGpuFrameMs));
+                }
+            }
+            
             int depthMipToVisualize = renderOptions->GetDepthMipToVisualize();
             if (ImGui::SliderInt("Depth mip", &depthMipToVisualize, 0, renderOptions->GetMaxDepthMipToVisualize()))
             {
@@ -156,3 +289,48 @@ void SettingsWidget::OnOcclusionCullingChanged()
 {
     SettingsWidgetDetails::occlusionCulling = renderOptions->GetOcclusionCulling();
 }
+
+void SettingsWidget::OnClusterCullingChanged()
+{
+    SettingsWidgetDetails::clusterCulling = renderOptions->GetClusterCulling();
+}
+
+void SettingsWidget::OnInstancedDrawsChanged()
+{
+    SettingsWidgetDetails::instancedDraws = renderOptions->GetInstancedDraws();
+}
+
+void SettingsWidget::OnMeshletCullingChanged()
+{
+    SettingsWidgetDetails::meshletCulling = renderOptions->GetMeshletCulling();
+}
+
+void SettingsWidget::OnCpuCullingChanged()
+{
+    SettingsWidgetDetails::cpuCulling = renderOptions->GetCpuCulling();
+}
+
+void SettingsWidget::OnVisibilityBufferChanged()
+{
+    SettingsWidgetDetails::visibilityBuffer = renderOptions->GetVisibilityBuffer();
+}
+
+void SettingsWidget::OnSoftwareRasterizationChanged()
+{
+    SettingsWidgetDetails::softwareRasterization = renderOptions->GetSoftwareRasterization();
+}
+
+void SettingsWidget::OnImpostorsChanged()
+{
+    SettingsWidgetDetails::impostors = renderOptions->GetImpostors();
+}
+
+void SettingsWidget::OnDynamicResolutionChanged()
+{
+    SettingsWidgetDetails::dynamicResolution = renderOptions->GetDynamicResolution();
+}
+
+void SettingsWidget::OnQualityGovernorChanged()
+{
+    SettingsWidgetDetails::qualityGovernor = renderOptions->GetQualityGovernor();
+}
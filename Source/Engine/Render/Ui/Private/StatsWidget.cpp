@@ -2,6 +2,7 @@
 
 #include "Engine/Scene/Scene.hpp"
 #include "Engine/Render/RenderOptions.hpp"
+#include "Engine/Render/Utils/ForwardUtils.hpp"
 #include "Engine/Render/Vulkan/StatsUtils.hpp"
 #include "Engine/Render/Vulkan/VulkanContext.hpp"
 
@@ -22,8 +23,18 @@ void StatsWidget::Process(const Frame& frame, const float deltaSeconds)
     firstRenderPassTimesMs.Push(GetTimingMs(vulkanContext->GetDevice(), frame.renderStats, GpuTiming::eFirstRenderPass));
     secondRenderPassTimesMs.Push(GetTimingMs(vulkanContext->GetDevice(), frame.renderStats, GpuTiming::eSecondRenderPass));
     depthPyramidTimesMs.Push(GetTimingMs(vulkanContext->GetDevice(), frame.renderStats, GpuTiming::eDepthPyramid));
+    visibilityResolveTimesMs.Push(GetTimingMs(vulkanContext->GetDevice(), frame.renderStats, GpuTiming::eVisibilityResolve));
+    lightCullTimesMs.Push(GetTimingMs(vulkanContext->GetDevice(), frame.renderStats, GpuTiming::eLightCull));
+    softwareRasterTimesMs.Push(GetTimingMs(vulkanContext->GetDevice(), frame.renderStats, GpuTiming::eSoftwareRaster));
 
     triangleCount = frame.renderStats.triangleCount;
+    
+    firstPassDrawCount = frame.renderStats.firstPassDrawCount;
+    secondPassDrawCount = frame.renderStats.secondPassDrawCount;
+    reprojectedDrawCount = frame.renderStats.reprojectedDrawCount;
+    overflowCommandCount = frame.renderStats.overflowCommandCount;
+    extraViewDrawCount = frame.renderStats.extraViewDrawCount;
+    impostorDrawCount = frame.renderStats.impostorDrawCount;
 }
 
 void StatsWidget::Build()
@@ -63,11 +74,57 @@ void StatsWidget::Build()
             ImGui::Text("Second render pass: %.2f ms.", secondRenderPassTimesMs.GetAverage());
             ImGui::Text("Depth pyramid: %.2f ms.", depthPyramidTimesMs.GetAverage());
         }
+        
+        if (ForwardUtils::UseVisibilityBuffer())
+        {
+            ImGui::Text("Visibility resolve: %.2f ms.", visibilityResolveTimesMs.GetAverage());
+        }
+        
+        if (ForwardUtils::UseSoftwareRasterization())
+        {
+            ImGui::Text("Software raster: %.2f ms.", softwareRasterTimesMs.GetAverage());
+        }
+        
+        if (RenderOptions::Get().GetLightCount() > 0)
+        {
+            ImGui::Text("Light culling: %.2f ms.", lightCullTimesMs.GetAverage());
+        }
     }
 
     ImGui::Text("Triangles (total): %.2fM", Scene::GetTotalTriangles() / 1'000'000.0f);
     ImGui::Text("Triangles: %.2fM", triangleCount / 1'000'000.0f);
     
+    if (const RenderOptions& renderOptions = RenderOptions::Get(); renderOptions.GetOcclusionCulling())
+    {
+        ImGui::Text("Draws (first pass): %u", firstPassDrawCount);
+        
+        if (renderOptions.GetReprojectionOcclusion())
+        {
+            ImGui::Text("Draws (reprojected): %u", reprojectedDrawCount);
+        }
+        
+        ImGui::Text("Draws (second pass): %u", secondPassDrawCount);
+    }
+    else
+    {
+        ImGui::Text("Draws: %u", firstPassDrawCount);
+    }
+    
+    if (ForwardUtils::UseImpostors()) // Not included in the draws above, see ImpostorStage
+    {
+        ImGui::Text("Draws (impostors): %u", impostorDrawCount);
+    }
+    
+    if (RenderOptions::Get().GetExtraViewCount() > 0)
+    {
+        ImGui::Text("Draws (extra views): %u", extraViewDrawCount);
+    }
+    
+    if (overflowCommandCount > 0) // Command buffer budget is exceeded, these commands are dropped
+    {
+        ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Dropped commands: %u", overflowCommandCount);
+    }
+    
     ImGui::End();
 
     ImGui::PopStyleColor();
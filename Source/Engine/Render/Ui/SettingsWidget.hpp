@@ -18,6 +18,15 @@ public:
 private:
     void OnVSyncChanged();
     void OnOcclusionCullingChanged();
+    void OnClusterCullingChanged();
+    void OnInstancedDrawsChanged();
+    void OnMeshletCullingChanged();
+    void OnCpuCullingChanged();
+    void OnVisibilityBufferChanged();
+    void OnSoftwareRasterizationChanged();
+    void OnImpostorsChanged();
+    void OnDynamicResolutionChanged();
+    void OnQualityGovernorChanged();
     
 DISABLE_WARNINGS_BEGIN
     const VulkanContext* vulkanContext = nullptr;
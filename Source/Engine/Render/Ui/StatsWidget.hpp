@@ -30,6 +30,16 @@ private:
     RingAccumulator<float> firstRenderPassTimesMs;
     RingAccumulator<float> secondRenderPassTimesMs;
     RingAccumulator<float> depthPyramidTimesMs;
+    RingAccumulator<float> visibilityResolveTimesMs;
+    RingAccumulator<float> lightCullTimesMs;
+    RingAccumulator<float> softwareRasterTimesMs;
     
     uint64_t triangleCount = 0;
+    
+    uint32_t firstPassDrawCount = 0;
+    uint32_t secondPassDrawCount = 0;
+    uint32_t reprojectedDrawCount = 0;
+    uint32_t overflowCommandCount = 0;
+    uint32_t extraViewDrawCount = 0;
+    uint32_t impostorDrawCount = 0;
 };
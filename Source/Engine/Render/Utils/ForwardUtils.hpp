@@ -1,6 +1,8 @@
 #pragma once
 
+#include "Engine/Render/RenderOptionsTypes.hpp"
 #include "Engine/Render/Vulkan/RenderPass.hpp"
+#include "Engine/Render/Vulkan/Buffer/Buffer.hpp"
 #include "Engine/Render/Vulkan/Image/RenderTarget.hpp"
 
 class Swapchain;
@@ -11,8 +13,42 @@ namespace ForwardUtils
     RenderPass CreateRenderPass(VkSampleCountFlagBits sampleCount, const VulkanContext& vulkanContext);
     RenderPass CreateFirstOcclusionCullingRenderPass(VkSampleCountFlagBits sampleCount, const VulkanContext& vulkanContext);
     RenderPass CreateSecondOcclusionCullingRenderPass(VkSampleCountFlagBits sampleCount, const VulkanContext& vulkanContext);
+    
+    // Visibility buffer passes are single sampled: geometry passes write IDs and depth, resolve pass shades into swapchain
+    RenderPass CreateVisibilityRenderPass(const VulkanContext& vulkanContext);
+    RenderPass CreateFirstOcclusionCullingVisibilityRenderPass(const VulkanContext& vulkanContext);
+    RenderPass CreateSecondOcclusionCullingVisibilityRenderPass(const VulkanContext& vulkanContext);
+    RenderPass CreateVisibilityResolveRenderPass(const VulkanContext& vulkanContext);
 
     RenderTarget CreateColorTarget(VkSampleCountFlagBits sampleCount, const VulkanContext& vulkanContext);
     RenderTarget CreateDepthTarget(VkSampleCountFlagBits sampleCount, const VulkanContext& vulkanContext);
     RenderTarget CreateDepthResolveTarget(const VulkanContext& vulkanContext);
+    RenderTarget CreateVisibilityTarget(const VulkanContext& vulkanContext);
+    Buffer CreateSoftwareVisibilityBuffer(const VulkanContext& vulkanContext); // 64-bit depth and payload per pixel
+    RenderTarget CreateSceneColorTarget(const VulkanContext& vulkanContext); // Single sampled, blit source
+    
+    bool UseVisibilityBuffer(); // Visibility buffer option is ignored with MSAA
+    bool UseSoftwareRasterization(); // Only with visibility buffer and mesh pipeline
+    bool UseImpostors(); // Visibility buffer has no IDs for them
+    bool UseDynamicResolution(); // Visibility buffer resolve reads IDs at full resolution
+    bool UseDebugBounds(); // Culling appends visible draws for bounding visualization or CPU culling validation
+    bool UseMeshletCulling(); // Vertex pipeline without visibility buffer, which resolves triangles of whole LODs
+    bool UseInstancedDraws(); // Vertex pipeline, meshlet culling takes precedence as it emits its own commands
+    
+    // Same as above for the given graphics pipeline type instead of the current one, e.g. to precompile its pipelines
+    bool UseSoftwareRasterization(GraphicsPipelineType graphicsPipelineType);
+    bool UseMeshletCulling(GraphicsPipelineType graphicsPipelineType);
+    bool UseInstancedDraws(GraphicsPipelineType graphicsPipelineType);
+    
+    // Indirect draws are split into chunks to fit device limits, see DrawChunks.comp
+    uint32_t GetTaskChunkSize(const VulkanContext& vulkanContext); // Task workgroups per vkCmdDrawMeshTasksIndirect* draw
+    uint32_t GetDrawChunkSize(const VulkanContext& vulkanContext); // Commands per vkCmdDrawIndexedIndirect* call
+    
+    // Next render scale for dynamic resolution from the last measured GPU frame time, see ForwardRenderer::GatherFrameStats
+    float UpdateRenderScale(float renderScale, float frameMs, float targetFrameMs);
+    
+    // Next detail scale for the quality governor from the last measured GPU frame time and triangle count,
+    // budgets of 0 are ignored, see ForwardRenderer::GatherFrameStats
+    float UpdateDetailScale(float detailScale, float frameMs, float targetFrameMs,
+        uint64_t triangleCount, uint64_t triangleBudget);
 }
@@ -1,5 +1,7 @@
 #include "Engine/Render/Utils/ForwardUtils.hpp"
 
+#include "Shaders/Common.h"
+#include "Engine/Render/RenderOptions.hpp"
 #include "Engine/Render/Vulkan/VulkanConfig.hpp"
 #include "Engine/Render/Vulkan/VulkanContext.hpp"
 #include "Engine/Render/Vulkan/Image/ImageUtils.hpp"
@@ -8,6 +10,26 @@ namespace ForwardUtilsDetails
 {
     static constexpr VkClearColorValue clearColorValue = { { 0.73f, 0.95f, 1.0f, 1.0f } };
     static constexpr VkClearDepthStencilValue clearDepthStencilValue = { 0.0f, 0 };
+    static constexpr VkClearColorValue clearVisibilityValue = { .uint32 = { gpu::invalidVisibilityInstance,
+        gpu::invalidVisibilityInstance, 0, 0 } };
+    
+    // Dynamic resolution controller, render scale is the fraction of swapchain width and height geometry passes render
+    static constexpr float minRenderScale = 0.5f;
+    static constexpr float renderScaleStep = 0.05f; // Render extent changes in steps instead of a few pixels every frame
+    static constexpr float renderScaleDamping = 0.5f; // Timings are a few frames old, full correction would oscillate
+    
+    // Hysteresis band around the target frame time, narrower above it so spikes are corrected sooner
+    static constexpr float overTargetTolerance = 0.05f;
+    static constexpr float underTargetTolerance = 0.15f;
+    
+    // Quality governor controller, detail scale is the multiplier of LOD target error and contribution threshold
+    static constexpr float maxDetailScale = 4.0f;
+    static constexpr float detailScaleDamping = 0.25f; // LOD switches pop, so detail follows slower than resolution
+    
+    static bool IsWithinTolerance(const float ratio)
+    {
+        return ratio <= 1.0f + overTargetTolerance && ratio >= 1.0f - underTargetTolerance;
+    }
 }
 
 RenderPass ForwardUtils::CreateRenderPass(VkSampleCountFlagBits sampleCount, const VulkanContext& vulkanContext)
@@ -139,6 +161,131 @@ RenderPass ForwardUtils::CreateSecondOcclusionCullingRenderPass(const VkSampleCo
         .Build();
 }
 
+RenderPass ForwardUtils::CreateVisibilityRenderPass(const VulkanContext& vulkanContext)
+{
+    const AttachmentDescription visibilityAttachmentDescription = {
+        .format = VulkanConfig::visibilityImageFormat,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .actualLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, // Read by the resolve pass
+        .defaultClearValue = { .color = ForwardUtilsDetails::clearVisibilityValue } };
+    
+    const AttachmentDescription depthStencilAttachmentDescription = {
+        .format = VulkanConfig::depthImageFormat,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE, // Debug objects are depth tested in the resolve pass
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .actualLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .defaultClearValue = { .depthStencil = ForwardUtilsDetails::clearDepthStencilValue } };
+    
+    return RenderPassBuilder(vulkanContext)
+        .SetBindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS)
+        .SetMultisampling(VK_SAMPLE_COUNT_1_BIT)
+        .AddColorAttachment(visibilityAttachmentDescription)
+        .AddDepthStencilAttachment(depthStencilAttachmentDescription)
+        .SetPreviousBarriers({ Barriers::lateDepthStencilWriteToEarlyAndLateDepthStencilReadWrite, Barriers::colorWriteToColorReadWrite,
+            Barriers::fragmentReadToColorWrite })
+        .Build();
+}
+
+RenderPass ForwardUtils::CreateFirstOcclusionCullingVisibilityRenderPass(const VulkanContext& vulkanContext)
+{
+    const AttachmentDescription visibilityAttachmentDescription = {
+        .format = VulkanConfig::visibilityImageFormat,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .actualLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .defaultClearValue = { .color = ForwardUtilsDetails::clearVisibilityValue } };
+    
+    const AttachmentDescription depthStencilAttachmentDescription = {
+        .format = VulkanConfig::depthImageFormat,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .actualLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, // We're building depth pyramid from it
+        .defaultClearValue = { .depthStencil = ForwardUtilsDetails::clearDepthStencilValue } };
+    
+    return RenderPassBuilder(vulkanContext)
+        .SetBindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS)
+        .SetMultisampling(VK_SAMPLE_COUNT_1_BIT)
+        .AddColorAttachment(visibilityAttachmentDescription)
+        .AddDepthStencilAttachment(depthStencilAttachmentDescription)
+        .SetPreviousBarriers({ Barriers::lateDepthStencilWriteToEarlyAndLateDepthStencilReadWrite, Barriers::colorWriteToColorReadWrite,
+            Barriers::fragmentReadToColorWrite })
+        .Build();
+}
+
+RenderPass ForwardUtils::CreateSecondOcclusionCullingVisibilityRenderPass(const VulkanContext& vulkanContext)
+{
+    const AttachmentDescription visibilityAttachmentDescription = {
+        .format = VulkanConfig::visibilityImageFormat,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD, // Load in the 2nd pass
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .actualLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }; // Read by the resolve pass
+    
+    const AttachmentDescription depthStencilAttachmentDescription = {
+        .format = VulkanConfig::depthImageFormat,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE, // Debug objects are depth tested in the resolve pass
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .actualLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    
+    return RenderPassBuilder(vulkanContext)
+        .SetBindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS)
+        .SetMultisampling(VK_SAMPLE_COUNT_1_BIT)
+        .AddColorAttachment(visibilityAttachmentDescription)
+        .AddDepthStencilAttachment(depthStencilAttachmentDescription)
+        .SetPreviousBarriers({ Barriers::lateDepthStencilWriteToEarlyAndLateDepthStencilReadWrite, Barriers::colorWriteToColorReadWrite })
+        .Build();
+}
+
+RenderPass ForwardUtils::CreateVisibilityResolveRenderPass(const VulkanContext& vulkanContext)
+{
+    const AttachmentDescription colorAttachmentDescription = {
+        .format = vulkanContext.GetSwapchain().GetSurfaceFormat().format,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR, // Pixels without geometry keep the clear color
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .actualLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .defaultClearValue = { .color = ForwardUtilsDetails::clearColorValue } };
+    
+    const AttachmentDescription depthStencilAttachmentDescription = {
+        .format = VulkanConfig::depthImageFormat,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .actualLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .defaultClearValue = { .depthStencil = ForwardUtilsDetails::clearDepthStencilValue } };
+    
+    return RenderPassBuilder(vulkanContext)
+        .SetBindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS)
+        .SetMultisampling(VK_SAMPLE_COUNT_1_BIT)
+        .AddColorAttachment(colorAttachmentDescription)
+        .AddDepthStencilAttachment(depthStencilAttachmentDescription)
+        .SetPreviousBarriers({ Barriers::colorWriteToFragmentRead, Barriers::lateDepthStencilWriteToEarlyAndLateDepthStencilReadWrite,
+            Barriers::colorWriteToColorReadWrite })
+        .Build();
+}
+
 RenderTarget ForwardUtils::CreateColorTarget(const VkSampleCountFlagBits sampleCount, const VulkanContext& vulkanContext)
 {
     const Swapchain& swapchain = vulkanContext.GetSwapchain();
@@ -203,3 +350,185 @@ RenderTarget ForwardUtils::CreateDepthResolveTarget(const VulkanContext& vulkanC
     
     return renderTarget;
 }
+
+RenderTarget ForwardUtils::CreateVisibilityTarget(const VulkanContext& vulkanContext)
+{
+    const VkExtent2D swapchainExtent = vulkanContext.GetSwapchain().GetExtent();
+    
+    ImageDescription visibilityTargetDescription = {
+        .extent = { swapchainExtent.width, swapchainExtent.height, 1 },
+        .mipLevelsCount = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .format = VulkanConfig::visibilityImageFormat,
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    auto renderTarget = RenderTarget(std::move(visibilityTargetDescription), VK_IMAGE_ASPECT_COLOR_BIT, vulkanContext);
+    
+    vulkanContext.GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
+        ImageUtils::TransitionLayout(cmd, renderTarget, LayoutTransitions::undefinedToColorAttachmentOptimal, Barriers::noneToColorWrite);
+    });
+    
+    return renderTarget;
+}
+
+RenderTarget ForwardUtils::CreateSceneColorTarget(const VulkanContext& vulkanContext)
+{
+    const Swapchain& swapchain = vulkanContext.GetSwapchain();
+    const VkExtent2D swapchainExtent = swapchain.GetExtent();
+    
+    // Allocated at full resolution, so render scale changes don't recreate it, see RenderContext::renderExtent
+    ImageDescription sceneColorTargetDescription = {
+        .extent = { swapchainExtent.width, swapchainExtent.height, 1 },
+        .mipLevelsCount = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .format = swapchain.GetSurfaceFormat().format,
+        .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    auto renderTarget = RenderTarget(std::move(sceneColorTargetDescription), VK_IMAGE_ASPECT_COLOR_BIT, vulkanContext);
+    
+    vulkanContext.GetDevice().ExecuteOneTimeCommandBuffer([&](VkCommandBuffer cmd) {
+        ImageUtils::TransitionLayout(cmd, renderTarget, LayoutTransitions::undefinedToColorAttachmentOptimal, Barriers::noneToColorWrite);
+    });
+    
+    return renderTarget;
+}
+
+Buffer ForwardUtils::CreateSoftwareVisibilityBuffer(const VulkanContext& vulkanContext)
+{
+    const VkExtent2D swapchainExtent = vulkanContext.GetSwapchain().GetExtent();
+    
+    // Cleared before every frame, see SoftwareRasterStage
+    const BufferDescription softwareVisibilityBufferDescription = {
+        .size = static_cast<VkDeviceSize>(swapchainExtent.width) * swapchainExtent.height * sizeof(uint64_t),
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+    
+    return Buffer(softwareVisibilityBufferDescription, false, vulkanContext);
+}
+
+bool ForwardUtils::UseVisibilityBuffer()
+{
+    const RenderOptions& renderOptions = RenderOptions::Get();
+    
+    return renderOptions.GetVisibilityBuffer() && renderOptions.GetMsaaSampleCount() == VK_SAMPLE_COUNT_1_BIT;
+}
+
+bool ForwardUtils::UseSoftwareRasterization()
+{
+    return UseSoftwareRasterization(RenderOptions::Get().GetGraphicsPipelineType());
+}
+
+bool ForwardUtils::UseImpostors()
+{
+    return RenderOptions::Get().GetImpostors() && !UseVisibilityBuffer();
+}
+
+bool ForwardUtils::UseDynamicResolution()
+{
+    return RenderOptions::Get().GetDynamicResolution() && !UseVisibilityBuffer();
+}
+
+bool ForwardUtils::UseDebugBounds()
+{
+    const RenderOptions& renderOptions = RenderOptions::Get();
+    
+    return renderOptions.GetVisualizeBoundingSpheres() || renderOptions.GetVisualizeBoundingRectangles()
+        || renderOptions.GetCpuCullingValidation();
+}
+
+bool ForwardUtils::UseMeshletCulling()
+{
+    return UseMeshletCulling(RenderOptions::Get().GetGraphicsPipelineType());
+}
+
+bool ForwardUtils::UseInstancedDraws()
+{
+    return UseInstancedDraws(RenderOptions::Get().GetGraphicsPipelineType());
+}
+
+bool ForwardUtils::UseSoftwareRasterization(const GraphicsPipelineType graphicsPipelineType)
+{
+    return UseVisibilityBuffer() && RenderOptions::Get().GetSoftwareRasterization() &&
+        graphicsPipelineType == GraphicsPipelineType::eMesh;
+}
+
+bool ForwardUtils::UseMeshletCulling(const GraphicsPipelineType graphicsPipelineType)
+{
+    return RenderOptions::Get().GetMeshletCulling() && graphicsPipelineType == GraphicsPipelineType::eVertex
+        && !UseVisibilityBuffer();
+}
+
+bool ForwardUtils::UseInstancedDraws(const GraphicsPipelineType graphicsPipelineType)
+{
+    return RenderOptions::Get().GetInstancedDraws() && graphicsPipelineType == GraphicsPipelineType::eVertex
+        && !UseMeshletCulling(graphicsPipelineType);
+}
+
+uint32_t ForwardUtils::GetTaskChunkSize(const VulkanContext& vulkanContext)
+{
+    const DeviceProperties& deviceProperties = vulkanContext.GetDevice().GetProperties();
+    
+    return std::max(1u, std::min(deviceProperties.maxTaskWorkGroupCountX, deviceProperties.maxTaskWorkGroupTotalCount));
+}
+
+uint32_t ForwardUtils::GetDrawChunkSize(const VulkanContext& vulkanContext)
+{
+    return std::max(1u, vulkanContext.GetDevice().GetProperties().physicalProperties.limits.maxDrawIndirectCount);
+}
+
+float ForwardUtils::UpdateRenderScale(const float renderScale, const float frameMs, const float targetFrameMs)
+{
+    using namespace ForwardUtilsDetails;
+    
+    // No timings yet for the first frames in flight
+    if (frameMs <= 0.0f || targetFrameMs <= 0.0f)
+    {
+        return renderScale;
+    }
+    
+    const float frameRatio = frameMs / targetFrameMs;
+    
+    if (IsWithinTolerance(frameRatio))
+    {
+        return renderScale;
+    }
+    
+    // GPU time is assumed to follow pixel count, which goes with the square of the scale
+    const float idealScale = renderScale * std::sqrt(1.0f / frameRatio);
+    const float dampedScale = std::lerp(renderScale, idealScale, renderScaleDamping);
+    
+    return std::clamp(std::round(dampedScale / renderScaleStep) * renderScaleStep, minRenderScale, 1.0f);
+}
+
+float ForwardUtils::UpdateDetailScale(const float detailScale, const float frameMs, const float targetFrameMs,
+    const uint64_t triangleCount, const uint64_t triangleBudget)
+{
+    using namespace ForwardUtilsDetails;
+    
+    // The most exceeded budget drives the scale, so both are met once it settles
+    float budgetRatio = 0.0f;
+    
+    if (frameMs > 0.0f && targetFrameMs > 0.0f)
+    {
+        budgetRatio = frameMs / targetFrameMs;
+    }
+    
+    // Triangle count is 0 without pipeline statistics queries
+    if (triangleCount > 0 && triangleBudget > 0)
+    {
+        budgetRatio = std::max(budgetRatio, static_cast<float>(triangleCount) / static_cast<float>(triangleBudget));
+    }
+    
+    if (budgetRatio <= 0.0f || IsWithinTolerance(budgetRatio))
+    {
+        return detailScale;
+    }
+    
+    // Triangle count goes with the inverse square of the screen space error LODs are selected for
+    const float idealScale = detailScale * std::sqrt(budgetRatio);
+    const float dampedScale = std::lerp(detailScale, idealScale, detailScaleDamping);
+    
+    return std::clamp(dampedScale, 1.0f, maxDetailScale);
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <volk.h>
+#include <mutex>
 
 #include "Engine/Render/Vulkan/DescriptorSets/DescriptorSetLayout.hpp"
 #include "Engine/Render/Vulkan/DescriptorSets/DescriptorSetLayoutBuilder.hpp"
@@ -21,11 +22,13 @@ public:
     DescriptorSetLayoutCache(DescriptorSetLayoutCache&&) = delete;
     DescriptorSetLayoutCache& operator=(DescriptorSetLayoutCache&&) = delete;
 
-    DescriptorSetLayout GetLayout(DescriptorSetLayoutBuilder& layoutBuilder);
+    DescriptorSetLayout GetLayout(DescriptorSetLayoutBuilder& layoutBuilder); // Thread-safe, pipelines are built in parallel
 
 private:
     const VulkanContext* vulkanContext;
 
     std::unordered_map<LayoutHash, VkDescriptorSetLayout> layoutCache;
     std::unordered_map<LayoutHash, std::vector<VkDescriptorSetLayoutBinding>> layoutBindings;
+    
+    std::mutex mutex;
 };
\ No newline at end of file
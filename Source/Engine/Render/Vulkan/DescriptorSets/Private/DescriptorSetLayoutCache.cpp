@@ -17,6 +17,8 @@ DescriptorSetLayoutCache::~DescriptorSetLayoutCache()
 DescriptorSetLayout DescriptorSetLayoutCache::GetLayout(DescriptorSetLayoutBuilder& layoutBuilder)
 {
     const LayoutHash hash = layoutBuilder.GetHash();
+    
+    std::scoped_lock lock(mutex);
 
     if (const auto it = layoutCache.find(hash); it != layoutCache.end())
     {
@@ -24,10 +24,17 @@ struct DeviceProperties
 {
     VkPhysicalDeviceProperties physicalProperties = {};
     VkSampleCountFlagBits maxSampleCount = VK_SAMPLE_COUNT_1_BIT;
-    bool meshShadersSupported = false;
+    bool meshShadersSupported = false; // Requires shader draw parameters too
     bool pipelineStatisticsQuerySupported = false;
     bool drawIndirectCountSupported = false;
     bool samplerFilterMinmaxSupported = false;
+    bool geometryShaderSupported = false;
+    bool shaderDrawParametersSupported = false;
+    bool bufferInt64AtomicsSupported = false; // In fragment shaders too, for software rasterization
+    
+    // VK_EXT_mesh_shader limits, 0 if mesh shaders aren't supported
+    uint32_t maxTaskWorkGroupCountX = 0;
+    uint32_t maxTaskWorkGroupTotalCount = 0;
 };
 
 class Device
@@ -43,6 +50,9 @@ public:
     Device& operator=(Device&&) = delete;
 
     void WaitIdle() const;
+    
+    // Pipeline cache is loaded on creation and saved on destruction, saving in between keeps it if the app is killed
+    void SavePipelineCache() const;
 
     VkCommandPool GetCommandPool(CommandBufferType type) const;
     void ExecuteOneTimeCommandBuffer(const DeviceCommands& commands) const;
@@ -62,6 +72,11 @@ public:
         return queues;
     }
     
+    VkPipelineCache GetPipelineCache() const
+    {
+        return pipelineCache;
+    }
+    
     operator VkDevice() const
     {
         return device;
@@ -80,6 +95,9 @@ private:
     Queues queues;
 
     mutable std::unordered_map<CommandBufferType, VkCommandPool> commandPools;
+    
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    mutable size_t savedPipelineCacheHash = 0; // Of the data in the file, see SavePipelineCache
 
     VkCommandBuffer oneTimeCommandBuffer;
     CommandBufferSync oneTimeCommandBufferSync;
@@ -2,12 +2,9 @@
 
 #include <format>
 
-DISABLE_WARNINGS_BEGIN
-#include <SPIRV/GlslangToSpv.h>
-DISABLE_WARNINGS_END
-
 #include "Utils/Helpers.hpp"
 #include "Engine/Render/Vulkan/VulkanContext.hpp"
+#include "Engine/Render/Vulkan/Shaders/ShaderCache.hpp"
 #include "Engine/Render/Vulkan/Shaders/ShaderUtils.hpp"
 
 namespace ShaderManagerDetails
@@ -53,36 +50,58 @@ ShaderModule ShaderManager::CreateShaderModule(const FilePath& path, const VkSha
     
     ShaderUtils::InsertDefines(glslCode, shaderDefines);
     
-    const std::vector<uint32_t> spirv = ShaderCompiler::Compile(glslCode, shaderStage, FilePath(shadersDir));
-    
     const FilePath compiledShaderPath = CreateCompiledShaderPath(path, shaderDefines);
+    const uint64_t hash = ShaderCache::ComputeHash(glslCode, shaderStage, FilePath(shadersDir));
+    
+    // Skip compilation and reflection if nothing compilation depends on has changed
+    std::optional<ShaderCache::Entry> entry;
+    
+    {
+        std::scoped_lock lock(cacheMutex);
+        entry = ShaderCache::Load(compiledShaderPath, hash);
+    }
+    
+    if (entry)
+    {
+        Assert(entry->reflection.shaderStage == shaderStage);
+        
+        return CreateShaderModule(entry->spirv, std::move(entry->reflection));
+    }
+    
+    const std::vector<uint32_t> spirv = ShaderCompiler::Compile(glslCode, shaderStage, FilePath(shadersDir));
     
     // Create shader module on success
     if (!spirv.empty())
     {
-        FileSystem::CreateDirectories(compiledShaderPath);
-        glslang::OutputSpvBin(spirv, compiledShaderPath.GetAbsolute().c_str());
+        ShaderReflection reflection = ShaderUtils::GenerateReflection(spirv, shaderStage);
+        
+        {
+            std::scoped_lock lock(cacheMutex);
+            ShaderCache::Save(compiledShaderPath, hash, spirv, reflection);
+        }
         
-        return CreateShaderModule(spirv, shaderStage);
+        return CreateShaderModule(spirv, std::move(reflection));
     }
     
-    // Try to load shader module from cache if allowed
+    // Try to load shader module from cache if allowed, its source doesn't match anymore
     if (useCacheOnFailure && compiledShaderPath.Exists())
     {
+        std::unique_lock lock(cacheMutex);
         const std::vector<char> cachedSpirv = FileSystem::ReadFile(compiledShaderPath);
+        lock.unlock();
         
         if (!cachedSpirv.empty())
         {
             const std::span spirvSpan(reinterpret_cast<const uint32_t*>(cachedSpirv.data()), cachedSpirv.size() / sizeof(uint32_t));
             
-            return CreateShaderModule(spirvSpan, shaderStage);
+            return CreateShaderModule(spirvSpan, ShaderUtils::GenerateReflection(spirvSpan, shaderStage));
         }
     }
     
     return { VK_NULL_HANDLE, {}, vulkanContext };
 }
 
-ShaderModule ShaderManager::CreateShaderModule(const std::span<const uint32_t> spirvCode, const VkShaderStageFlagBits shaderStage) const
+ShaderModule ShaderManager::CreateShaderModule(const std::span<const uint32_t> spirvCode, ShaderReflection reflection) const
 {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -93,5 +112,5 @@ ShaderModule ShaderManager::CreateShaderModule(const std::span<const uint32_t> s
     const VkResult result = vkCreateShaderModule(vulkanContext.GetDevice(), &createInfo, nullptr, &shaderModule);
     Assert(result == VK_SUCCESS);
     
-    return { shaderModule, ShaderUtils::GenerateReflection(spirvCode, shaderStage), vulkanContext };
+    return { shaderModule, std::move(reflection), vulkanContext };
 }
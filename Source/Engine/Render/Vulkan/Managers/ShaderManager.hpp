@@ -1,11 +1,14 @@
 #pragma once
 
+#include <mutex>
+
 #include "Engine/Render/Vulkan/Shaders/ShaderModule.hpp"
 #include "Engine/Render/Vulkan/Shaders/ShaderCompiler.hpp"
 #include "Engine/FileSystem/FileSystem.hpp"
 
 class VulkanContext;
 
+// Shader modules can be created from any thread, see RenderStage::BuildPipelines
 class ShaderManager
 {
 public:
@@ -15,9 +18,11 @@ public:
         std::span<const ShaderDefine> shaderDefines, bool useCacheOnFailure = true) const;
 
 private:
-    ShaderModule CreateShaderModule(std::span<const uint32_t> spirvCode, VkShaderStageFlagBits shaderStage) const;
+    ShaderModule CreateShaderModule(std::span<const uint32_t> spirvCode, ShaderReflection reflection) const;
     
     const VulkanContext& vulkanContext;
 
     ShaderCompiler shaderCompiler;
+    
+    mutable std::mutex cacheMutex; // Same permutation can be requested by several threads at once
 };
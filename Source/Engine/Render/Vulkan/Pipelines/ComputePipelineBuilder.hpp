@@ -10,7 +10,6 @@ class VulkanContext;
 class ComputePipelineBuilder
 {
 public:
-    // TODO: Add pipeline cache and manager
     ComputePipelineBuilder(const VulkanContext& vulkanContext);
     ~ComputePipelineBuilder() = default;
 
@@ -24,10 +23,12 @@ public:
 
     ComputePipelineBuilder& SetShaderModule(const ShaderModule& shaderModule);
     ComputePipelineBuilder& SetSpecializationConstants(std::vector<SpecializationConstant> specializationConstants);
+    ComputePipelineBuilder& SetCreateFlags(VkPipelineCreateFlags createFlags);
 
 private:
     const VulkanContext* vulkanContext = nullptr;
 
     const ShaderModule* shaderModule = nullptr;
     std::vector<SpecializationConstant> specializationConstants;
+    VkPipelineCreateFlags createFlags = 0;
 };
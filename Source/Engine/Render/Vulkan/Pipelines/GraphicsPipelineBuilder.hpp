@@ -6,7 +6,6 @@
 #include "Engine/Render/Vulkan/Shaders/ShaderModule.hpp"
 
 class VulkanContext;
-class RenderPass;
 
 enum class InputTopology
 {
@@ -34,7 +33,6 @@ public:
     using VertexBindings = std::vector<VkVertexInputBindingDescription>;
     using VertexAttributes = std::vector<VkVertexInputAttributeDescription>;
 
-    // TODO: Add pipeline cache and manager
     GraphicsPipelineBuilder(const VulkanContext& vulkanContext);
     ~GraphicsPipelineBuilder() = default;
 
@@ -55,7 +53,7 @@ public:
     GraphicsPipelineBuilder& SetMultisampling(VkSampleCountFlagBits sampleCount);
     GraphicsPipelineBuilder& EnableBlending();
     GraphicsPipelineBuilder& SetDepthState(bool depthTest, bool depthWrite, VkCompareOp compareOp);
-    GraphicsPipelineBuilder& SetRenderPass(const RenderPass& renderPass, uint32_t subpass = 0);
+    GraphicsPipelineBuilder& SetRenderPass(VkRenderPass renderPass, uint32_t subpass = 0);
 
 private:
     const VulkanContext* vulkanContext = nullptr;
@@ -72,6 +70,6 @@ private:
     std::vector<VkDynamicState> dynamicStates;
     VkPipelineMultisampleStateCreateInfo multisamplingState;
     VkPipelineDepthStencilStateCreateInfo depthStencil;
-    const RenderPass* renderPass = nullptr;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
     uint32_t subpass = 0;
 };
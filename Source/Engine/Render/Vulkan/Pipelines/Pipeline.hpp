@@ -42,6 +42,10 @@ public:
     Pipeline(Pipeline&& other) noexcept;
     Pipeline& operator=(Pipeline&& other) noexcept;
     
+    // Destroys pipeline without waiting for the device, so it can't have been used by any command buffer
+    // Unlike destructor it can be called while other threads submit work, e.g. for precompiled pipelines
+    void DestroyUnused();
+    
     bool HasBinding(std::string_view name) const;
 
     VkPipelineLayout GetLayout() const
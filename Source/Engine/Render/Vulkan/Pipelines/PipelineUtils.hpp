@@ -10,6 +10,10 @@ namespace PipelineUtils
     void PushConstants(const VkCommandBuffer commandBuffer, const Pipeline& pipeline, const std::string& name, const T& value);
 
     uint32_t GroupCount(uint32_t threadCount, uint32_t groupSize);
+    
+    // Splits 1D dispatch into several ones of at most maxGroupCount workgroups each (see maxComputeWorkGroupCount),
+    // gl_WorkGroupID keeps counting across them, pipeline has to be created with VK_PIPELINE_CREATE_DISPATCH_BASE_BIT
+    void DispatchChunked(VkCommandBuffer commandBuffer, uint32_t groupCount, uint32_t maxGroupCount);
 }
 
 template<typename T>
@@ -31,6 +31,7 @@ Pipeline ComputePipelineBuilder::Build() const
     ShaderInstance shaderInstance = CreateShaderInstance(*shaderModule, specializationConstants);
     
     VkComputePipelineCreateInfo pipelineInfo = { .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    pipelineInfo.flags = createFlags;
     pipelineInfo.stage = GetShaderStageCreateInfo(shaderInstance);
     pipelineInfo.layout = pipelineLayout;
     
@@ -39,7 +40,7 @@ Pipeline ComputePipelineBuilder::Build() const
     pipelineInfo.basePipelineIndex = -1;
 
     VkPipeline pipeline;
-    const VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+    const VkResult result = vkCreateComputePipelines(device, vulkanContext->GetDevice().GetPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
     Assert(result == VK_SUCCESS);
     
     PipelineData pipelineData = {
@@ -67,3 +68,11 @@ ComputePipelineBuilder& ComputePipelineBuilder::SetSpecializationConstants(
 
     return *this;
 }
+
+
+ComputePipelineBuilder& ComputePipelineBuilder::SetCreateFlags(const VkPipelineCreateFlags aCreateFlags)
+{
+    createFlags = aCreateFlags;
+
+    return *this;
+}
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include "Engine/Render/Vulkan/Pipelines/GraphicsPipelineBuilder.hpp"
 
 #include "Utils/Helpers.hpp"
-#include "Engine/Render/Vulkan/RenderPass.hpp"
 #include "Engine/Render/Vulkan/VulkanUtils.hpp"
 #include "Engine/Render/Vulkan/VulkanContext.hpp"
 #include "Engine/Render/Vulkan/Shaders/ShaderUtils.hpp"
@@ -150,7 +149,7 @@ Pipeline GraphicsPipelineBuilder::Build() const
     using namespace ShaderUtils;
     
     Assert(!shaderModules.empty());
-    Assert(renderPass != nullptr);
+    Assert(renderPass != VK_NULL_HANDLE);
     
     if (!std::ranges::all_of(shaderModules, &ShaderModule::IsValid))
     {
@@ -185,7 +184,7 @@ Pipeline GraphicsPipelineBuilder::Build() const
     pipelineInfo.pColorBlendState = &colorBlendState;
     pipelineInfo.layout = pipelineLayout;
     pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.renderPass = *renderPass;
+    pipelineInfo.renderPass = renderPass;
     pipelineInfo.subpass = subpass;
 
     // Can be used to create pipeline from similar one (which is faster than entirely new one)
@@ -193,7 +192,7 @@ Pipeline GraphicsPipelineBuilder::Build() const
     pipelineInfo.basePipelineIndex = -1;
 
     VkPipeline pipeline;
-    const VkResult result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+    const VkResult result = vkCreateGraphicsPipelines(device, vulkanContext->GetDevice().GetPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
     Assert(result == VK_SUCCESS);
     
     PipelineData pipelineData = {
@@ -327,10 +326,10 @@ GraphicsPipelineBuilder& GraphicsPipelineBuilder::SetDepthState(const bool depth
     return *this;
 }
 
-GraphicsPipelineBuilder& GraphicsPipelineBuilder::SetRenderPass(const RenderPass& aRenderPass, 
+GraphicsPipelineBuilder& GraphicsPipelineBuilder::SetRenderPass(const VkRenderPass aRenderPass, 
     const uint32_t aSubpass /* = 0 */)
 {
-    renderPass = &aRenderPass;
+    renderPass = aRenderPass;
     subpass = aSubpass;
 
     return *this;
@@ -64,6 +64,20 @@ Pipeline& Pipeline::operator=(Pipeline&& other) noexcept
     return *this;
 }
 
+void Pipeline::DestroyUnused()
+{
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        const Device& device = vulkanContext->GetDevice();
+        
+        vkDestroyPipeline(device, pipeline, nullptr);
+        vkDestroyPipelineLayout(device, layout, nullptr);
+    }
+    
+    pipeline = VK_NULL_HANDLE;
+    layout = VK_NULL_HANDLE;
+}
+
 bool Pipeline::HasBinding(const std::string_view name) const
 {
     Assert(IsValid());
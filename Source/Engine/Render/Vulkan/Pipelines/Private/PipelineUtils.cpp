@@ -16,5 +16,22 @@ void PipelineUtils::PushConstants(const VkCommandBuffer commandBuffer, const Pip
 
 uint32_t PipelineUtils::GroupCount(const uint32_t threadCount, const uint32_t groupSize)
 {
-    return static_cast<uint32_t>(std::ceil(static_cast<float>(threadCount) / static_cast<float>(groupSize)));
+    // Integer math, float loses precision for big thread counts
+    return static_cast<uint32_t>((static_cast<uint64_t>(threadCount) + groupSize - 1) / groupSize);
+}
+
+void PipelineUtils::DispatchChunked(const VkCommandBuffer commandBuffer, const uint32_t groupCount, const uint32_t maxGroupCount)
+{
+    Assert(maxGroupCount > 0);
+    
+    uint32_t baseGroup = 0;
+    
+    while (baseGroup < groupCount)
+    {
+        const uint32_t chunkGroupCount = std::min(groupCount - baseGroup, maxGroupCount);
+        
+        vkCmdDispatchBase(commandBuffer, baseGroup, 0, 0, chunkGroupCount, 1, 1);
+        
+        baseGroup += chunkGroupCount;
+    }
 }
@@ -2,9 +2,12 @@
 
 #include "Engine/Render/Vulkan/VulkanContext.hpp"
 #include "Engine/Render/Vulkan/VulkanUtils.hpp"
+#include "Engine/FileSystem/FileSystem.hpp"
 
 namespace DeviceDetails
 {
+    constexpr std::string_view pipelineCachePath = "~/Cache/PipelineCache.bin";
+    
     static std::vector<VkExtensionProperties> GetExtensionsProperties(VkPhysicalDevice device)
     {
         uint32_t extensionCount;
@@ -53,6 +56,19 @@ namespace DeviceDetails
         return deviceFeatures;
     }
 
+    static VkPhysicalDeviceVulkan11Features GetSupported11Features(const VkPhysicalDevice device)
+    {
+        VkPhysicalDeviceVulkan11Features supported11Features = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES };
+        
+        VkPhysicalDeviceFeatures2 deviceFeatures = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &supported11Features };
+
+        vkGetPhysicalDeviceFeatures2(device, &deviceFeatures);
+        
+        return supported11Features;
+    }
+
     static VkPhysicalDeviceVulkan12Features GetSupported12Features(const VkPhysicalDevice device)
     {
         VkPhysicalDeviceVulkan12Features supported12Features = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
@@ -65,6 +81,20 @@ namespace DeviceDetails
         
         return supported12Features;
     }
+    
+    static VkPhysicalDeviceMeshShaderPropertiesEXT GetMeshShaderProperties(const VkPhysicalDevice device)
+    {
+        VkPhysicalDeviceMeshShaderPropertiesEXT meshShaderProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_PROPERTIES_EXT };
+        
+        VkPhysicalDeviceProperties2 deviceProperties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &meshShaderProperties };
+        
+        vkGetPhysicalDeviceProperties2(device, &deviceProperties);
+        
+        return meshShaderProperties;
+    }
 
     // TODO: Handle compute queue separatelly
     static std::optional<uint32_t> FindGraphicsAndComputetQueueFamilyIndex(const std::vector<VkQueueFamilyProperties>& queueFamilies)
@@ -191,21 +221,26 @@ namespace DeviceDetails
         void* meshShaderFeaturesChain = properties.meshShadersSupported ? reinterpret_cast<void*>(&meshShaderFeatures) : nullptr;
 
         VkPhysicalDeviceFeatures deviceFeatures = {
+            .geometryShader = properties.geometryShaderSupported, // For gl_PrimitiveID in fragment shaders
             .multiDrawIndirect = VK_TRUE,
             .fillModeNonSolid = VK_TRUE,
             .samplerAnisotropy = VK_TRUE,
-            .pipelineStatisticsQuery = properties.pipelineStatisticsQuerySupported };
+            .pipelineStatisticsQuery = properties.pipelineStatisticsQuerySupported,
+            .fragmentStoresAndAtomics = properties.bufferInt64AtomicsSupported,
+            .shaderInt64 = properties.bufferInt64AtomicsSupported };
 
         VkPhysicalDeviceVulkan11Features deviceFeatures11 = {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
             .pNext = meshShaderFeaturesChain,
-            .storageBuffer16BitAccess = VK_TRUE };
+            .storageBuffer16BitAccess = VK_TRUE,
+            .shaderDrawParameters = properties.shaderDrawParametersSupported };
 
         VkPhysicalDeviceVulkan12Features deviceFeatures12 = {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
             .pNext = &deviceFeatures11,
             .drawIndirectCount = properties.drawIndirectCountSupported,
             .storageBuffer8BitAccess = VK_TRUE,
+            .shaderBufferInt64Atomics = properties.bufferInt64AtomicsSupported,
             .shaderInt8 = VK_TRUE,
             .samplerFilterMinmax = properties.samplerFilterMinmaxSupported };
 
@@ -250,6 +285,57 @@ namespace DeviceDetails
         return commandPool;
     }
 
+    // Data of another device or driver version is rejected by the header, drivers aren't required to validate it
+    static bool IsPipelineCacheCompatible(const std::span<const char> data, const VkPhysicalDeviceProperties& physicalProperties)
+    {
+        VkPipelineCacheHeaderVersionOne header;
+        
+        if (data.size() < sizeof(header))
+        {
+            return false;
+        }
+        
+        std::memcpy(&header, data.data(), sizeof(header));
+        
+        return header.headerSize >= sizeof(header) && header.headerSize <= data.size()
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == physicalProperties.vendorID
+            && header.deviceID == physicalProperties.deviceID
+            && std::memcmp(header.pipelineCacheUUID, physicalProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+    
+    // Compared instead of sizes, driver can replace entries without growing the data
+    static size_t HashPipelineCacheData(const std::span<const char> data)
+    {
+        return std::hash<std::string_view>{}(std::string_view(data.data(), data.size()));
+    }
+    
+    // Also returns hash of the loaded data, so it isn't saved again unchanged
+    static std::tuple<VkPipelineCache, size_t> CreatePipelineCache(VkDevice device,
+        const VkPhysicalDeviceProperties& physicalProperties)
+    {
+        const FilePath path(pipelineCachePath);
+        
+        std::vector<char> data = path.Exists() ? FileSystem::ReadFile(path) : std::vector<char>{};
+        
+        if (!data.empty() && !IsPipelineCacheCompatible(data, physicalProperties))
+        {
+            LogI << "Pipeline cache was created by another device or driver, starting with empty one\n";
+            data.clear();
+        }
+        
+        const VkPipelineCacheCreateInfo createInfo = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .initialDataSize = data.size(),
+            .pInitialData = data.empty() ? nullptr : data.data() };
+        
+        VkPipelineCache pipelineCache;
+        const VkResult result = vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache);
+        Assert(result == VK_SUCCESS);
+        
+        return { pipelineCache, HashPipelineCacheData(data) };
+    }
+    
     static VkSampleCountFlagBits GetMaxSampleCount(const VkPhysicalDeviceProperties& physicalDeviceProperties)
     {
         VkSampleCountFlags counts = physicalDeviceProperties.limits.framebufferColorSampleCounts &
@@ -280,6 +366,8 @@ Device::Device(const VulkanContext& aVulkanContext)
     volkLoadDevice(device);
 
     queues = DeviceDetails::GetQueues(vulkanContext, physicalDevice, device);
+    
+    std::tie(pipelineCache, savedPipelineCacheHash) = CreatePipelineCache(device, properties.physicalProperties);
 
     commandPools.emplace(CommandBufferType::eLongLived, 
         CreateCommandPool(device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, queues.familyIndices.graphicsAndComputeFamily));
@@ -293,6 +381,9 @@ Device::Device(const VulkanContext& aVulkanContext)
 
 Device::~Device()
 {
+    SavePipelineCache();
+    vkDestroyPipelineCache(device, pipelineCache, nullptr);
+    
     std::ranges::for_each(commandPools, [&](auto& entry) {
         vkDestroyCommandPool(device, entry.second, nullptr);
     });
@@ -308,6 +399,46 @@ void Device::WaitIdle() const
     vkDeviceWaitIdle(device);
 }
 
+void Device::SavePipelineCache() const
+{
+    size_t size = 0;
+    VkResult result = vkGetPipelineCacheData(device, pipelineCache, &size, nullptr);
+    Assert(result == VK_SUCCESS);
+    
+    std::vector<char> data(size);
+    result = vkGetPipelineCacheData(device, pipelineCache, &size, data.data());
+    
+    // Background precompilation can grow the cache between the queries, then the data is read again with the new size
+    while (result == VK_INCOMPLETE)
+    {
+        result = vkGetPipelineCacheData(device, pipelineCache, &size, nullptr);
+        Assert(result == VK_SUCCESS);
+        
+        data.resize(size);
+        result = vkGetPipelineCacheData(device, pipelineCache, &size, data.data());
+    }
+    
+    Assert(result == VK_SUCCESS);
+    
+    data.resize(size);
+    
+    const size_t hash = DeviceDetails::HashPipelineCacheData(data);
+    
+    if (hash == savedPipelineCacheHash)
+    {
+        return;
+    }
+    
+    if (FileSystem::WriteFile(FilePath(DeviceDetails::pipelineCachePath), data))
+    {
+        savedPipelineCacheHash = hash;
+    }
+    else
+    {
+        LogW << "Failed to write pipeline cache: " << FilePath(DeviceDetails::pipelineCachePath) << "\n";
+    }
+}
+
 VkCommandPool Device::GetCommandPool(CommandBufferType type) const
 {
     return commandPools[type];
@@ -331,14 +462,32 @@ void Device::InitProperties()
     std::vector<VkExtensionProperties> availableExtensionsProperties = GetExtensionsProperties(physicalDevice);
     
     properties.maxSampleCount = GetMaxSampleCount(properties.physicalProperties);
-    properties.meshShadersSupported = ExtensionSupported(availableExtensionsProperties, VK_EXT_MESH_SHADER_EXTENSION_NAME);
     
     const VkPhysicalDeviceFeatures2 supportedFeatures = GetSupportedFeatures(physicalDevice);
     
     properties.pipelineStatisticsQuerySupported = supportedFeatures.features.pipelineStatisticsQuery;
+    properties.geometryShaderSupported = supportedFeatures.features.geometryShader;
+    
+    const VkPhysicalDeviceVulkan11Features supported11Features = GetSupported11Features(physicalDevice);
+    
+    properties.shaderDrawParametersSupported = supported11Features.shaderDrawParameters;
+    
+    // Meshlet.task picks its task commands by gl_DrawID
+    properties.meshShadersSupported = properties.shaderDrawParametersSupported &&
+        ExtensionSupported(availableExtensionsProperties, VK_EXT_MESH_SHADER_EXTENSION_NAME);
     
     const VkPhysicalDeviceVulkan12Features supported12Features = GetSupported12Features(physicalDevice);
     
     properties.drawIndirectCountSupported = supported12Features.drawIndirectCount;
     properties.samplerFilterMinmaxSupported = supported12Features.samplerFilterMinmax;
+    properties.bufferInt64AtomicsSupported = supported12Features.shaderBufferInt64Atomics &&
+        supportedFeatures.features.shaderInt64 && supportedFeatures.features.fragmentStoresAndAtomics;
+    
+    if (properties.meshShadersSupported)
+    {
+        const VkPhysicalDeviceMeshShaderPropertiesEXT meshShaderProperties = GetMeshShaderProperties(physicalDevice);
+        
+        properties.maxTaskWorkGroupCountX = meshShaderProperties.maxTaskWorkGroupCount[0];
+        properties.maxTaskWorkGroupTotalCount = meshShaderProperties.maxTaskWorkGroupTotalCount;
+    }
 }
@@ -70,13 +70,13 @@ RenderPass& RenderPass::operator=(RenderPass&& other) noexcept
     return *this;
 }
 
-VkRenderPassBeginInfo RenderPass::GetBeginInfo(const VkFramebuffer framebuffer)
+VkRenderPassBeginInfo RenderPass::GetBeginInfo(const VkFramebuffer framebuffer, const VkRect2D renderArea)
 {
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = renderPass;
     renderPassInfo.framebuffer = framebuffer;
-    renderPassInfo.renderArea = vulkanContext->GetSwapchain().GetRect();
+    renderPassInfo.renderArea = renderArea;
     renderPassInfo.clearValueCount = static_cast<uint32_t>(defaultClearValues.size());
     renderPassInfo.pClearValues = defaultClearValues.data();
     
@@ -84,13 +84,19 @@ VkRenderPassBeginInfo RenderPass::GetBeginInfo(const VkFramebuffer framebuffer)
 }
 
 void RenderPass::Begin(const Frame& frame, const VkFramebuffer framebuffer, std::optional<GpuTimestamp> timestamp /* = std::nullopt*/)
+{
+    Begin(frame, framebuffer, vulkanContext->GetSwapchain().GetRect(), timestamp);
+}
+
+void RenderPass::Begin(const Frame& frame, const VkFramebuffer framebuffer, const VkRect2D renderArea,
+    std::optional<GpuTimestamp> timestamp /* = std::nullopt*/)
 {
     if (timestamp)
     {
         StatsUtils::WriteTimestamp(frame.commandBuffer, frame.queryPools.timestamps, *timestamp);
     }
     
-    const VkRenderPassBeginInfo beginInfo = GetBeginInfo(framebuffer);
+    const VkRenderPassBeginInfo beginInfo = GetBeginInfo(framebuffer, renderArea);
     vkCmdBeginRenderPass(frame.commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
 }
 
@@ -122,6 +122,18 @@ float StatsUtils::GetTimingMs(const Device& device, const FrameRenderStats& rend
         rawBegin = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eSecondRenderPassBegin)];
         rawEnd = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eSecondRenderPassEnd)];
         break;
+    case GpuTiming::eVisibilityResolve:
+        rawBegin = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eVisibilityResolveBegin)];
+        rawEnd = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eVisibilityResolveEnd)];
+        break;
+    case GpuTiming::eLightCull:
+        rawBegin = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eLightCullBegin)];
+        rawEnd = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eLightCullEnd)];
+        break;
+    case GpuTiming::eSoftwareRaster:
+        rawBegin = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eSoftwareRasterBegin)];
+        rawEnd = renderStats.rawTimestamps[static_cast<uint32_t>(GpuTimestamp::eSoftwareRasterEnd)];
+        break;
     }
     
     const float devicePeriodNs = device.GetProperties().physicalProperties.limits.timestampPeriod;
@@ -40,6 +40,8 @@ VulkanContext::VulkanContext(const Window& window, EventSystem& aEventSystem)
     memoryManager = std::make_unique<MemoryManager>(*this);
     shaderManager = std::make_unique<ShaderManager>(*this);
     descriptorSetsManager = std::make_unique<DescriptorSetManager>(*this);
+    
+    threadPool = std::make_unique<ThreadPool>();
 
     eventSystem.Subscribe<ES::WindowResized>(this, &VulkanContext::OnResize);
     eventSystem.Subscribe<ES::BeforeWindowRecreated>(this, &VulkanContext::OnBeforeWindowRecreated);
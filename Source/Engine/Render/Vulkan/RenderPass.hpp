@@ -21,9 +21,10 @@ public:
     RenderPass(RenderPass&& other) noexcept;
     RenderPass& operator=(RenderPass&& other) noexcept;
     
-    VkRenderPassBeginInfo GetBeginInfo(VkFramebuffer framebuffer);
+    VkRenderPassBeginInfo GetBeginInfo(VkFramebuffer framebuffer, VkRect2D renderArea);
     
     void Begin(const Frame& frame, VkFramebuffer framebuffer, std::optional<GpuTimestamp> timestamp = std::nullopt);
+    void Begin(const Frame& frame, VkFramebuffer framebuffer, VkRect2D renderArea, std::optional<GpuTimestamp> timestamp = std::nullopt);
     void End(const Frame& frame, std::optional<GpuTimestamp> timestamp = std::nullopt);
 
     bool IsValid() const
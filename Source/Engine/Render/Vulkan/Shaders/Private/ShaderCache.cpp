@@ -0,0 +1,348 @@
+#include "Engine/Render/Vulkan/Shaders/ShaderCache.hpp"
+
+#include "Engine/FileSystem/FileSystem.hpp"
+#include "Engine/Render/Vulkan/Shaders/ShaderCompiler.hpp"
+
+namespace ShaderCacheDetails
+{
+    constexpr std::string_view reflectionFileExtension = ".reflection";
+    constexpr std::string_view includeDirective = "#include";
+    
+    constexpr uint32_t magic = 0x43565053; // "SPVC"
+    constexpr uint32_t formatVersion = 1; // Increment on any change of reflection layout
+    
+    // FNV-1a, stable between runs and platforms unlike std::hash
+    constexpr uint64_t hashOffsetBasis = 14695981039346656037ull;
+    constexpr uint64_t hashPrime = 1099511628211ull;
+    
+    static uint64_t Hash(const std::string_view data, uint64_t hash)
+    {
+        for (const char c : data)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= hashPrime;
+        }
+        
+        return hash;
+    }
+
+    static FilePath GetReflectionPath(const FilePath& path)
+    {
+        return FilePath(path.GetAbsolute() + std::string(reflectionFileExtension));
+    }
+
+    // Same lookup as DirStackFileIncluder: next to the including file first, then in the include dir
+    static std::optional<FilePath> ResolveInclude(const std::string_view name, const std::string& fileDir,
+        const FilePath& includeDir)
+    {
+        if (!fileDir.empty())
+        {
+            if (FilePath path = FilePath(fileDir) / name; path.Exists())
+            {
+                return path;
+            }
+        }
+        
+        if (FilePath path = includeDir / name; path.Exists())
+        {
+            return path;
+        }
+        
+        return std::nullopt;
+    }
+
+    // Includes are hashed regardless of preprocessor conditions around them, it can only cost extra misses
+    // Unresolved ones are skipped, they are C++ includes of shared headers under __cplusplus
+    static uint64_t HashIncludes(const std::string_view code, const std::string& fileDir, const FilePath& includeDir,
+        std::unordered_set<std::string>& hashedFiles, uint64_t hash)
+    {
+        size_t position = code.find(includeDirective);
+        
+        while (position != std::string_view::npos)
+        {
+            const size_t lineEnd = code.find('\n', position);
+            const std::string_view line = code.substr(position, lineEnd - position);
+            
+            position = lineEnd == std::string_view::npos ? lineEnd : code.find(includeDirective, lineEnd);
+            
+            const size_t nameBegin = line.find('"');
+            const size_t nameEnd = nameBegin == std::string_view::npos ? nameBegin : line.find('"', nameBegin + 1);
+            
+            if (nameEnd == std::string_view::npos)
+            {
+                continue;
+            }
+            
+            const std::string_view name = line.substr(nameBegin + 1, nameEnd - nameBegin - 1);
+            const std::optional<FilePath> includePath = ResolveInclude(name, fileDir, includeDir);
+            
+            if (!includePath || !hashedFiles.insert(includePath->GetAbsolute()).second)
+            {
+                continue;
+            }
+            
+            const std::vector<char> includeCode = FileSystem::ReadFile(*includePath);
+            const std::string_view includeCodeView(includeCode.data(), includeCode.size());
+            
+            hash = Hash(name, hash);
+            hash = Hash(includeCodeView, hash);
+            hash = HashIncludes(includeCodeView, includePath->GetDirectory(), includeDir, hashedFiles, hash);
+        }
+        
+        return hash;
+    }
+
+    class Writer
+    {
+    public:
+        template <typename T>
+        void Write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            
+            const auto* bytes = reinterpret_cast<const char*>(&value);
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+        
+        void Write(const std::string_view string)
+        {
+            Write(static_cast<uint32_t>(string.size()));
+            data.insert(data.end(), string.begin(), string.end());
+        }
+        
+        std::span<const char> GetData() const
+        {
+            return data;
+        }
+    
+    private:
+        std::vector<char> data;
+    };
+    
+    // Reads of truncated or corrupted data fail instead of reading past the end, failed reads return default values
+    class Reader
+    {
+    public:
+        explicit Reader(const std::span<const char> aData)
+            : data{ aData }
+        {}
+        
+        template <typename T>
+        T Read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            
+            T value{};
+            
+            if (!CanRead(sizeof(T)))
+            {
+                return value;
+            }
+            
+            std::memcpy(&value, data.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            
+            return value;
+        }
+        
+        std::string ReadString()
+        {
+            const auto size = Read<uint32_t>();
+            
+            if (!CanRead(size))
+            {
+                return {};
+            }
+            
+            std::string string(data.data() + offset, size);
+            offset += size;
+            
+            return string;
+        }
+        
+        bool IsValid() const
+        {
+            return !failed;
+        }
+    
+    private:
+        bool CanRead(const size_t size)
+        {
+            failed = failed || offset + size > data.size();
+            return !failed;
+        }
+        
+        std::span<const char> data;
+        size_t offset = 0;
+        bool failed = false;
+    };
+    
+    static void WriteReflection(Writer& writer, const ShaderReflection& reflection)
+    {
+        writer.Write(reflection.shaderStage);
+        
+        writer.Write(static_cast<uint32_t>(reflection.descriptorSets.size()));
+        
+        for (const DescriptorSetReflection& setReflection : reflection.descriptorSets)
+        {
+            writer.Write(setReflection.index);
+            writer.Write(static_cast<uint32_t>(setReflection.bindings.size()));
+            
+            for (const BindingReflection& binding : setReflection.bindings)
+            {
+                writer.Write(binding.index);
+                writer.Write(binding.type);
+                writer.Write(binding.shaderStages);
+                writer.Write(static_cast<uint32_t>(binding.names.size()));
+                
+                for (const std::string& name : binding.names)
+                {
+                    writer.Write(std::string_view(name));
+                }
+            }
+        }
+        
+        writer.Write(static_cast<uint32_t>(reflection.pushConstants.size()));
+        
+        for (const auto& [name, range] : reflection.pushConstants)
+        {
+            writer.Write(std::string_view(name));
+            writer.Write(range);
+        }
+        
+        writer.Write(static_cast<uint32_t>(reflection.specializationConstants.size()));
+        
+        for (const SpecializationConstantReflection& constant : reflection.specializationConstants)
+        {
+            writer.Write(constant.costantId);
+            writer.Write(std::string_view(constant.name));
+        }
+    }
+
+    static ShaderReflection ReadReflection(Reader& reader)
+    {
+        ShaderReflection reflection = { .shaderStage = reader.Read<VkShaderStageFlagBits>() };
+        
+        const auto setCount = reader.Read<uint32_t>();
+        
+        for (uint32_t setIndex = 0; setIndex < setCount && reader.IsValid(); ++setIndex)
+        {
+            DescriptorSetReflection& setReflection = reflection.descriptorSets.emplace_back();
+            setReflection.index = reader.Read<uint32_t>();
+            
+            const auto bindingCount = reader.Read<uint32_t>();
+            
+            for (uint32_t bindingIndex = 0; bindingIndex < bindingCount && reader.IsValid(); ++bindingIndex)
+            {
+                BindingReflection& binding = setReflection.bindings.emplace_back();
+                binding.index = reader.Read<uint32_t>();
+                binding.type = reader.Read<VkDescriptorType>();
+                binding.shaderStages = reader.Read<VkShaderStageFlags>();
+                
+                const auto nameCount = reader.Read<uint32_t>();
+                
+                for (uint32_t nameIndex = 0; nameIndex < nameCount && reader.IsValid(); ++nameIndex)
+                {
+                    binding.names.push_back(reader.ReadString());
+                }
+            }
+        }
+        
+        const auto pushConstantCount = reader.Read<uint32_t>();
+        
+        for (uint32_t index = 0; index < pushConstantCount && reader.IsValid(); ++index)
+        {
+            std::string name = reader.ReadString();
+            reflection.pushConstants.emplace(std::move(name), reader.Read<VkPushConstantRange>());
+        }
+        
+        const auto specializationConstantCount = reader.Read<uint32_t>();
+        
+        for (uint32_t index = 0; index < specializationConstantCount && reader.IsValid(); ++index)
+        {
+            const auto constantId = reader.Read<uint32_t>();
+            reflection.specializationConstants.emplace_back(constantId, reader.ReadString());
+        }
+        
+        return reflection;
+    }
+}
+
+uint64_t ShaderCache::ComputeHash(const std::string_view glslCode, const VkShaderStageFlagBits shaderStage,
+    const FilePath& includeDir)
+{
+    using namespace ShaderCacheDetails;
+    
+    static const std::string compilerVersion = ShaderCompiler::GetVersion();
+    
+    std::unordered_set<std::string> hashedFiles;
+    
+    uint64_t hash = Hash(compilerVersion, hashOffsetBasis);
+    hash = Hash(std::to_string(static_cast<uint32_t>(shaderStage)), hash);
+    hash = Hash(glslCode, hash);
+    
+    return HashIncludes(glslCode, {}, includeDir, hashedFiles, hash);
+}
+
+std::optional<ShaderCache::Entry> ShaderCache::Load(const FilePath& path, const uint64_t hash)
+{
+    using namespace ShaderCacheDetails;
+    
+    const FilePath reflectionPath = GetReflectionPath(path);
+    
+    if (!path.Exists() || !reflectionPath.Exists())
+    {
+        return std::nullopt;
+    }
+
+    const std::vector<char> reflectionData = FileSystem::ReadFile(reflectionPath);
+    Reader reader(reflectionData);
+    
+    if (reader.Read<uint32_t>() != magic || reader.Read<uint32_t>() != formatVersion || reader.Read<uint64_t>() != hash)
+    {
+        return std::nullopt;
+    }
+
+    const auto spirvSize = reader.Read<uint64_t>();
+    ShaderReflection reflection = ReadReflection(reader);
+    
+    const std::vector<char> spirvData = FileSystem::ReadFile(path);
+    
+    // Binary is written before reflection, mismatch means it was replaced afterwards, e.g. by an interrupted write
+    if (!reader.IsValid() || spirvData.size() != spirvSize || spirvSize % sizeof(uint32_t) != 0)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<uint32_t> spirv(spirvSize / sizeof(uint32_t));
+    std::memcpy(spirv.data(), spirvData.data(), spirvSize);
+    
+    return Entry{ std::move(spirv), std::move(reflection) };
+}
+
+void ShaderCache::Save(const FilePath& path, const uint64_t hash, const std::span<const uint32_t> spirv,
+    const ShaderReflection& reflection)
+{
+    using namespace ShaderCacheDetails;
+    
+    const std::span spirvData(reinterpret_cast<const char*>(spirv.data()), spirv.size_bytes());
+    
+    if (!FileSystem::WriteFile(path, spirvData))
+    {
+        LogW << "Failed to write compiled shader: " << path << "\n";
+        return;
+    }
+
+    Writer writer;
+    writer.Write(magic);
+    writer.Write(formatVersion);
+    writer.Write(hash);
+    writer.Write(static_cast<uint64_t>(spirv.size_bytes()));
+    
+    WriteReflection(writer, reflection);
+    
+    if (!FileSystem::WriteFile(GetReflectionPath(path), writer.GetData()))
+    {
+        LogW << "Failed to write shader reflection: " << path << "\n";
+    }
+}
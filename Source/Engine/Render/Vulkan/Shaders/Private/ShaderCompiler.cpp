@@ -1,6 +1,11 @@
 #include "Engine/Render/Vulkan/Shaders/ShaderCompiler.hpp"
 
+#include <format>
+#include <mutex>
+#include <atomic>
+
 DISABLE_WARNINGS_BEGIN
+#include <glslang/Public/ShaderLang.h>
 #include <glslang/Public/ResourceLimits.h>
 #include <SPIRV/GlslangToSpv.h>
 #include <StandAlone/DirStackFileIncluder.h>
@@ -11,9 +16,15 @@ DISABLE_WARNINGS_END
 
 namespace ShaderCompilerDetails
 {
-    static bool initialized = false;
+    // glslang process is initialized while any compiler exists, compilation itself can run on any thread
+    static std::mutex initializationMutex;
+    static uint32_t compilerCount = 0;
+    static std::atomic<bool> initialized = false;
+
+    static constexpr glslang::EShTargetClientVersion clientVersion = glslang::EShTargetVulkan_1_3;
+    static constexpr glslang::EShTargetLanguageVersion targetVersion = glslang::EShTargetSpv_1_5;
 
-    static std::unordered_map<VkShaderStageFlagBits, EShLanguage> glslangStages = {
+    static const std::unordered_map<VkShaderStageFlagBits, EShLanguage> glslangStages = {
         { VK_SHADER_STAGE_VERTEX_BIT, EShLangVertex },
         { VK_SHADER_STAGE_FRAGMENT_BIT, EShLangFragment },
         { VK_SHADER_STAGE_COMPUTE_BIT, EShLangCompute },
@@ -24,19 +35,27 @@ namespace ShaderCompilerDetails
 
 ShaderCompiler::ShaderCompiler()
 {
-    if (!ShaderCompilerDetails::initialized)
+    using namespace ShaderCompilerDetails;
+    
+    std::scoped_lock lock(initializationMutex);
+    
+    if (compilerCount++ == 0)
     {
         glslang::InitializeProcess();
-        ShaderCompilerDetails::initialized = true;
+        initialized = true;
     }
 }
 
 ShaderCompiler::~ShaderCompiler()
 {
-    if (ShaderCompilerDetails::initialized)
+    using namespace ShaderCompilerDetails;
+    
+    std::scoped_lock lock(initializationMutex);
+    
+    if (--compilerCount == 0)
     {
         glslang::FinalizeProcess();
-        ShaderCompilerDetails::initialized = false;
+        initialized = false;
     }
 }
 
@@ -60,8 +79,8 @@ std::vector<uint32_t> ShaderCompiler::Compile(const std::string_view glslCode, c
 
     shader.setStringsWithLengths(&code, &length, 1);
     shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
-    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_3);
-    shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_5);
+    shader.setEnvClient(glslang::EShClientVulkan, clientVersion);
+    shader.setEnvTarget(glslang::EShTargetSpv, targetVersion);
 
     DirStackFileIncluder includer;
 
@@ -102,3 +121,13 @@ std::vector<uint32_t> ShaderCompiler::Compile(const std::string_view glslCode, c
 
     return spirv;
 }
+
+std::string ShaderCompiler::GetVersion()
+{
+    using namespace ShaderCompilerDetails;
+    
+    const glslang::Version version = glslang::GetVersion();
+    
+    return std::format("glslang {}.{}.{}{} vulkan {} spirv {} generator {}", version.major, version.minor, version.patch,
+        version.flavor, static_cast<int>(clientVersion), static_cast<int>(targetVersion), glslang::GetSpirvGeneratorVersion());
+}
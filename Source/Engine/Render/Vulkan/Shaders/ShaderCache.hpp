@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Engine/Render/Vulkan/Shaders/ShaderModule.hpp"
+#include "Engine/FileSystem/FilePath.hpp"
+
+// Compiled SPIR-V is stored next to its reflection and the hash of everything compilation depends on: source with
+// inserted defines, all transitively included files, shader stage and compiler version, see ShaderCompiler::GetVersion
+// Entries with a matching hash are used instead of compiling, so unchanged shaders skip glslang and spirv-reflect
+namespace ShaderCache
+{
+    struct Entry
+    {
+        std::vector<uint32_t> spirv;
+        ShaderReflection reflection;
+    };
+
+    uint64_t ComputeHash(std::string_view glslCode, VkShaderStageFlagBits shaderStage, const FilePath& includeDir);
+
+    // Path is the one of SPIR-V binary, reflection is stored in a file next to it
+    std::optional<Entry> Load(const FilePath& path, uint64_t hash);
+    void Save(const FilePath& path, uint64_t hash, std::span<const uint32_t> spirv, const ShaderReflection& reflection);
+}
@@ -7,6 +7,9 @@ class ShaderCompiler
 {
 public:
     static std::vector<uint32_t> Compile(std::string_view glslCode, VkShaderStageFlagBits shaderStage, const FilePath& includeDir);
+    
+    // glslang and SPIR-V target versions, SPIR-V compiled by other versions isn't reused, see ShaderCache
+    static std::string GetVersion();
 
     ShaderCompiler();
     ~ShaderCompiler();
@@ -19,6 +19,12 @@ enum class GpuTimestamp : uint32_t
     eSecondCullingPassEnd,
     eSecondRenderPassBegin,
     eSecondRenderPassEnd,
+    eVisibilityResolveBegin,
+    eVisibilityResolveEnd,
+    eLightCullBegin,
+    eLightCullEnd,
+    eSoftwareRasterBegin,
+    eSoftwareRasterEnd,
     eCount
 };
 
@@ -28,6 +34,14 @@ struct FrameRenderStats
 {
     uint64_t triangleCount = 0; // VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
     uint64_t rawTimestamps[GpuTimestampsCount];
+    
+    // Read back from culling passes, see gpu::DrawCounters
+    uint32_t firstPassDrawCount = 0;
+    uint32_t secondPassDrawCount = 0;
+    uint32_t reprojectedDrawCount = 0;
+    uint32_t overflowCommandCount = 0;
+    uint32_t extraViewDrawCount = 0; // Sum over extra views
+    uint32_t impostorDrawCount = 0; // Both passes, see gpu::ImpostorCommands
 };
 
 struct FrameQueryPools
@@ -44,6 +58,9 @@ enum class GpuTiming
     eDepthPyramid,
     eSecondCullingPass,
     eSecondRenderPass,
+    eVisibilityResolve,
+    eLightCull,
+    eSoftwareRaster,
 };
 
 namespace StatsUtils
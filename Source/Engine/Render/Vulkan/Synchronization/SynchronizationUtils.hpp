@@ -24,6 +24,12 @@ namespace Barriers
         .dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
         .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
 
+    constexpr PipelineBarrier transferReadToColorWrite = {
+        .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+
     constexpr PipelineBarrier transferReadToTransferWrite = {
         .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
         .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
@@ -36,6 +42,12 @@ namespace Barriers
         .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
         .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT };
 
+    constexpr PipelineBarrier transferWriteToHostRead = {
+        .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_HOST_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT };
+
     constexpr PipelineBarrier transferWriteToComputeRead = {
         .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
         .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
@@ -66,12 +78,48 @@ namespace Barriers
         .dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
         .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
 
+    constexpr PipelineBarrier transferWriteToIndirectCommandRead = {
+        .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT };
+
+    constexpr PipelineBarrier transferWriteToVertexRead = {
+        .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
+
+    constexpr PipelineBarrier transferWriteToTaskAndMeshRead = {
+        .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
+
+    constexpr PipelineBarrier transferWriteToTaskReadWrite = {
+        .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+
+    constexpr PipelineBarrier transferWriteToFragmentReadWrite = {
+        .srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+
     constexpr PipelineBarrier computeReadToComputeWrite = {
         .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
         .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
         .dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
         .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT };
 
+    constexpr PipelineBarrier computeReadToTransferWrite = {
+        .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT };
+
     constexpr PipelineBarrier computeReadToTransferRead = {
         .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
         .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
@@ -90,18 +138,78 @@ namespace Barriers
         .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
         .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT };
 
+    constexpr PipelineBarrier computeWriteToTransferWrite = {
+        .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT };
+
     constexpr PipelineBarrier computeWriteToIndirectCommandRead = {
         .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
         .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
         .dstStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
         .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT };
 
+    constexpr PipelineBarrier computeWriteToVertexRead = {
+        .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
+
+    constexpr PipelineBarrier computeWriteToIndexRead = {
+        .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        .dstAccessMask = VK_ACCESS_INDEX_READ_BIT };
+
+    constexpr PipelineBarrier computeWriteToMeshRead = {
+        .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
+
     constexpr PipelineBarrier computeWriteToTaskRead = {
         .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
         .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
         .dstStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
         .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
 
+    constexpr PipelineBarrier computeWriteToFragmentRead = {
+        .srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
+
+    constexpr PipelineBarrier taskWriteToTaskReadWrite = {
+        .srcStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+
+    constexpr PipelineBarrier taskWriteToComputeRead = {
+        .srcStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
+
+    constexpr PipelineBarrier taskWriteToIndirectCommandRead = {
+        .srcStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT };
+
+    constexpr PipelineBarrier fragmentWriteToFragmentReadWrite = {
+        .srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+
+    constexpr PipelineBarrier fragmentWriteToComputeReadWrite = {
+        .srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT };
+
     constexpr PipelineBarrier lateDepthStencilWriteToComputeRead = {
         .srcStage = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
         .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
@@ -126,6 +234,30 @@ namespace Barriers
         .dstStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
         .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
 
+    constexpr PipelineBarrier colorWriteToTransferRead = {
+        .srcStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT };
+
+    constexpr PipelineBarrier colorWriteToFragmentRead = {
+        .srcStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT };
+
+    constexpr PipelineBarrier fragmentReadToColorWrite = {
+        .srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+
+    constexpr PipelineBarrier fragmentReadToTransferWrite = {
+        .srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT };
+
     constexpr PipelineBarrier colorWriteToComputeRead = {
         .srcStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
         .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
@@ -160,6 +292,36 @@ namespace Barriers
         .dstStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
         .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
 
+    constexpr PipelineBarrier vertexReadToComputeWrite = {
+        .srcStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT };
+
+    constexpr PipelineBarrier indexReadToComputeWrite = {
+        .srcStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        .srcAccessMask = VK_ACCESS_INDEX_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT };
+
+    constexpr PipelineBarrier meshReadToComputeWrite = {
+        .srcStage = VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT };
+
+    constexpr PipelineBarrier vertexReadToTransferWrite = {
+        .srcStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT };
+
+    constexpr PipelineBarrier taskAndMeshReadToTransferWrite = {
+        .srcStage = VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT,
+        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT };
+
     constexpr PipelineBarrier indirectCommandReadToTransferWrite = {
         .srcStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
         .srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
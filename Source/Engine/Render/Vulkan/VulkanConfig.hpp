@@ -22,6 +22,7 @@ namespace VulkanConfig
     inline constexpr uint32_t maxFramesInFlight = 2;
 
     inline constexpr VkFormat depthImageFormat = VK_FORMAT_D32_SFLOAT;
+    inline constexpr VkFormat visibilityImageFormat = VK_FORMAT_R32G32_UINT; // Visible instance and triangle
 
     inline constexpr uint32_t maxSetsInPool = 1000;
 
@@ -8,6 +8,7 @@
 #include "Engine/Render/Vulkan/Managers/MemoryManager.hpp"
 #include "Engine/Render/Vulkan/Managers/ShaderManager.hpp"
 #include "Engine/Render/Vulkan/Managers/DescriptorSetManager.hpp"
+#include "Utils/ThreadPool.hpp"
 
 namespace ES
 {
@@ -63,6 +64,12 @@ public:
     {
         return *descriptorSetsManager;
     }
+    
+    // Workers for creation of device objects off the calling thread, e.g. shader compilation and pipeline building
+    ThreadPool& GetThreadPool() const
+    {
+        return *threadPool;
+    }
 
 private:
     void OnResize(const ES::WindowResized& event);
@@ -82,4 +89,6 @@ private:
     std::unique_ptr<MemoryManager> memoryManager;
     std::unique_ptr<ShaderManager> shaderManager;
     std::unique_ptr<DescriptorSetManager> descriptorSetsManager;
+    
+    std::unique_ptr<ThreadPool> threadPool;
 };
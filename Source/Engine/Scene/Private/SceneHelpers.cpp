@@ -3,6 +3,7 @@
 #include "Utils/Math.hpp"
 #include "Utils/Helpers.hpp"
 #include "Engine/EngineConfig.hpp"
+#include "Shaders/Scene/SceneCopy.h"
 
 DISABLE_WARNINGS_BEGIN
 #define CGLTF_IMPLEMENTATION
@@ -17,6 +18,8 @@ DISABLE_WARNINGS_END
 #include <meshoptimizer.h>
 #include <random>
 
+#include <map>
+
 namespace SceneHelpersDetails
 {
     static constexpr size_t positionComponents = 3;
@@ -27,7 +30,9 @@ namespace SceneHelpersDetails
 
     static constexpr size_t vertexSize = sizeof(gpu::Vertex);
 
-    constexpr float coneWeight = 0.0f; // 0.25 will be default when we start using cone culling
+    constexpr float coneWeight = 0.25f; // Tighter normal cones for meshlet backface culling, see MeshletCull.comp
+
+    static constexpr uint32_t noMaterial = std::numeric_limits<uint32_t>::max();
 
     static void LoadVertices(const cgltf_primitive& primitive, std::span<gpu::Vertex> vertices)
     {
@@ -143,33 +148,24 @@ namespace SceneHelpersDetails
         return Math::AverageSphere(positions);
     }
 
-    static void GeneratePrimitive(const cgltf_primitive& cgltfPrimitive, RawScene& rawScene)
+    // Last vertexCount vertices of the scene are the primitive's ones, indices are relative to the first of them
+    static void AddPrimitive(uint32_t vertexCount, std::vector<uint32_t>& indices, RawScene& rawScene)
     {
-        const auto firstVertexOffset = static_cast<uint32_t>(rawScene.vertices.size());
-
-        auto vertexCount = static_cast<uint32_t>(cgltfPrimitive.attributes[0].data->count);
-        const auto indexCount = static_cast<uint32_t>(cgltfPrimitive.indices->count);
+        const auto firstVertexOffset = static_cast<uint32_t>(rawScene.vertices.size() - vertexCount);
 
-        rawScene.vertices.resize(rawScene.vertices.size() + vertexCount);
         auto vertices = std::span(rawScene.vertices).last(vertexCount);
 
-        std::vector<uint32_t> indices;
-        indices.resize(indexCount);
-
-        LoadVertices(cgltfPrimitive, vertices);
-        LoadIndices(cgltfPrimitive, indices);
-
         const uint32_t removedVertices = OptimizePrimitive(vertices, indices);
 
         rawScene.vertices.resize(rawScene.vertices.size() - removedVertices);
         vertexCount -= removedVertices;
 
-        gpu::Primitive& primitive = rawScene.primitives.emplace_back();
-
         const Sphere minSphere = GetMinSphere(vertices);
         
-        primitive.center = minSphere.center;
-        primitive.radius = minSphere.radius;
+        rawScene.primitiveBounds.push_back({ .center = minSphere.center, .radius = minSphere.radius });
+        
+        gpu::Primitive& primitive = rawScene.primitives.emplace_back();
+
         primitive.vertexOffset = firstVertexOffset;
         primitive.vertexCount = vertexCount;
         primitive.lodCount = 0;
@@ -242,6 +238,22 @@ namespace SceneHelpersDetails
         }
     }
 
+    static void GeneratePrimitive(const cgltf_primitive& cgltfPrimitive, RawScene& rawScene)
+    {
+        const auto vertexCount = static_cast<uint32_t>(cgltfPrimitive.attributes[0].data->count);
+        const auto indexCount = static_cast<uint32_t>(cgltfPrimitive.indices->count);
+
+        rawScene.vertices.resize(rawScene.vertices.size() + vertexCount);
+
+        std::vector<uint32_t> indices;
+        indices.resize(indexCount);
+
+        LoadVertices(cgltfPrimitive, std::span(rawScene.vertices).last(vertexCount));
+        LoadIndices(cgltfPrimitive, indices);
+
+        AddPrimitive(vertexCount, indices, rawScene);
+    }
+
     static gpu::Meshlet GenerateMeshlet(const meshopt_Meshlet& meshlet, const std::vector<unsigned int>& vertices,
         const std::vector<unsigned char>& triangles, std::vector<uint32_t>& meshletData,
         const uint32_t firstVertexOffset = 0)
@@ -287,7 +299,8 @@ namespace SceneHelpersDetails
     }
 
     static size_t GenerateMeshlets(const std::span<const gpu::Vertex> vertices, const std::span<const uint32_t> indices, 
-        std::vector<gpu::Meshlet>& meshlets, std::vector<uint32_t>& meshletData,
+        std::vector<gpu::Meshlet>& meshlets, std::vector<gpu::MeshletBounds>& meshletBounds,
+        std::vector<uint32_t>& meshletData,
         const uint32_t firstVertexOffset = 0 /* 1st meshlet vertex in global vertex buffer */)
     {
         using namespace SceneHelpersDetails;
@@ -321,6 +334,15 @@ namespace SceneHelpersDetails
 
             meshlets.push_back(GenerateMeshlet(meshlet, meshletVertices, meshletTriangles, meshletData, 
                 firstVertexOffset));
+
+            const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshletVertices[meshlet.vertex_offset],
+                &meshletTriangles[meshlet.triangle_offset], meshlet.triangle_count, &positions[0].x, positions.size(),
+                sizeof(glm::vec3));
+
+            meshletBounds.push_back({ .center = glm::vec3(bounds.center[0], bounds.center[1], bounds.center[2]),
+                .radius = bounds.radius,
+                .coneAxis = glm::vec3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]),
+                .coneCutoff = bounds.cone_cutoff });
         }
 
         return meshoptMeshlets.size();
@@ -349,6 +371,9 @@ namespace SceneHelpersDetails
 
                 GeneratePrimitive(primitive, rawScene);
 
+                rawScene.primitiveMaterials.push_back(primitive.material
+                    ? static_cast<uint32_t>(cgltf_material_index(&gltfData, primitive.material)) : noMaterial);
+
                 ++primitiveCount;
             }
 
@@ -379,6 +404,20 @@ namespace SceneHelpersDetails
         }
     }
 
+    static float GetMaxScale(const glm::mat4& transform)
+    {
+        const glm::vec3 axisX = glm::vec3(transform[0]);
+        const glm::vec3 axisY = glm::vec3(transform[1]);
+        const glm::vec3 axisZ = glm::vec3(transform[2]);
+
+        return std::max(std::max(glm::length(axisX), glm::length(axisY)), glm::length(axisZ));
+    }
+
+    static Sphere GetWorldBoundingSphere(const gpu::PrimitiveBounds& bounds, const glm::mat4& transform)
+    {
+        return { glm::vec3(transform * glm::vec4(bounds.center, 1.0f)), bounds.radius * GetMaxScale(transform) };
+    }
+
     static std::tuple<glm::vec3, float> CalculateSceneBoundingSphere(const RawScene& rawScene)
     {
         auto sceneMin = glm::vec3(std::numeric_limits<float>::max());
@@ -388,16 +427,7 @@ namespace SceneHelpersDetails
         {
             for (uint32_t index : std::ranges::views::iota(mesh.firstPrimitiveIndex, mesh.firstPrimitiveIndex + mesh.primitiveCount))
             {
-                const gpu::Primitive& primitive = rawScene.primitives[index];
-                
-                const glm::vec3 worldCenter = glm::vec3(mesh.transform * glm::vec4(primitive.center, 1.0f));
-                
-                const glm::vec3 axisX = glm::vec3(mesh.transform[0]);
-                const glm::vec3 axisY = glm::vec3(mesh.transform[1]);
-                const glm::vec3 axisZ = glm::vec3(mesh.transform[2]);
-
-                const float maxScale = std::max(std::max(glm::length(axisX), glm::length(axisY)), glm::length(axisZ));
-                const float worldRadius = primitive.radius * maxScale;
+                const auto [worldCenter, worldRadius] = GetWorldBoundingSphere(rawScene.primitiveBounds[index], mesh.transform);
                 
                 sceneMin = glm::min(sceneMin, worldCenter - glm::vec3(worldRadius));
                 sceneMax = glm::max(sceneMax, worldCenter + glm::vec3(worldRadius));
@@ -409,61 +439,254 @@ namespace SceneHelpersDetails
         return { sceneCenter, glm::length(sceneMax - sceneCenter) };
     }
 
-    static void RandomlyCopyScene(const RawScene& rawScene, std::vector<gpu::Draw>& draws)
+    // Copies vertices and LOD indices of the primitive into another scene, indices stay relative to its first vertex
+    static void CopyPrimitive(const RawScene& rawScene, const uint32_t primitiveIndex, RawScene& dstScene)
     {
-        static constexpr size_t maxDrawCount = gpu::primitiveCullMaxCommands;
-        
-        const size_t singleSceneDrawCount = draws.size();
-        const size_t sceneCountMultiplier = maxDrawCount / singleSceneDrawCount;
-        
-        const auto& [sceneCenter, sceneRadius] = SceneHelpersDetails::CalculateSceneBoundingSphere(rawScene);
+        gpu::Primitive primitive = rawScene.primitives[primitiveIndex];
 
-        const float cubeHalfSize = std::cbrt(static_cast<float>(sceneCountMultiplier)) * (sceneRadius * 2.0f) * 0.5f;
+        const auto vertices = std::span(rawScene.vertices).subspan(primitive.vertexOffset, primitive.vertexCount);
 
-        std::mt19937 rng(228);
+        primitive.vertexOffset = static_cast<uint32_t>(dstScene.vertices.size());
+        dstScene.vertices.insert(dstScene.vertices.end(), vertices.begin(), vertices.end());
 
-        std::uniform_real_distribution<float> positionDist(-cubeHalfSize, cubeHalfSize);
-        std::uniform_real_distribution<float> angleDist(0.0f, glm::two_pi<float>());
-        std::uniform_real_distribution<float> scaleDist(0.2f, 1.0f);
-        
-        std::vector<glm::vec3> scenePositions;
-        scenePositions.reserve(sceneCountMultiplier);
+        for (gpu::Lod& lod : std::span(primitive.lods).first(primitive.lodCount))
+        {
+            const auto indices = std::span(rawScene.indices).subspan(lod.indexOffset, lod.indexCount);
+
+            lod.indexOffset = static_cast<uint32_t>(dstScene.indices.size());
+            dstScene.indices.insert(dstScene.indices.end(), indices.begin(), indices.end());
+        }
+
+        dstScene.primitives.push_back(primitive);
+        dstScene.primitiveBounds.push_back(rawScene.primitiveBounds[primitiveIndex]);
+        dstScene.primitiveMaterials.push_back(rawScene.primitiveMaterials[primitiveIndex]);
+    }
+
+    // Primitives without normals or tangents keep zero vectors
+    static glm::vec3 SafeNormalize(const glm::vec3& vector)
+    {
+        const float length = glm::length(vector);
+
+        return length > 0.0f ? vector / length : vector;
+    }
+
+    // Appends vertices of the primitive to the vertices of a batch transformed to world space, returns whether the
+    // transform mirrors them, so their triangles have to flip the winding
+    static bool AppendWorldVertices(const RawScene& rawScene, const uint32_t primitiveIndex, const glm::mat4& transform,
+        std::vector<gpu::Vertex>& vertices)
+    {
+        const gpu::Primitive& primitive = rawScene.primitives[primitiveIndex];
+
+        const auto normalTransform = glm::mat3(glm::transpose(glm::inverse(transform)));
+        const auto tangentTransform = glm::mat3(transform);
+        const float handedness = glm::determinant(tangentTransform) < 0.0f ? -1.0f : 1.0f;
+
+        for (const gpu::Vertex& vertex : std::span(rawScene.vertices).subspan(primitive.vertexOffset, primitive.vertexCount))
+        {
+            const glm::vec3 position = transform * glm::vec4(glm::vec3(vertex.posAndU), 1.0f);
+            const glm::vec3 normal = SafeNormalize(normalTransform * glm::vec3(vertex.normalAndV));
+            const glm::vec3 tangent = SafeNormalize(tangentTransform * glm::vec3(vertex.tangent));
+
+            vertices.push_back({ .posAndU = glm::vec4(position, vertex.posAndU.w),
+                .normalAndV = glm::vec4(normal, vertex.normalAndV.w),
+                .tangent = glm::vec4(tangent, vertex.tangent.w * handedness),
+                .color = vertex.color });
+        }
+
+        return handedness < 0.0f;
+    }
+
+    static void AppendLodIndices(const RawScene& rawScene, const gpu::Lod& lod, const uint32_t firstVertex,
+        const bool mirrored, std::vector<uint32_t>& indices)
+    {
+        for (uint32_t i = 0; i < lod.indexCount; i += 3)
+        {
+            const uint32_t* triangle = &rawScene.indices[lod.indexOffset + i];
+
+            indices.push_back(firstVertex + triangle[0]);
+            indices.push_back(firstVertex + triangle[mirrored ? 2 : 1]);
+            indices.push_back(firstVertex + triangle[mirrored ? 1 : 2]);
+        }
+    }
+
+    // Batched primitives keep their own LODs instead of simplifying the batch as a whole: LOD i of the batch joins LOD i
+    // of each of them (or their last one) and has the largest of their world space errors, and the batch bounds contain
+    // theirs, so at any distance every part of the batch is at least as detailed as its primitive would be on its own
+    static void AddBatchedPrimitive(const RawScene& rawScene, const std::span<const std::pair<uint32_t, uint32_t>> primitives,
+        RawScene& batchedScene)
+    {
+        const auto firstVertexOffset = static_cast<uint32_t>(batchedScene.vertices.size());
         
-        // Preproceess positions to sort them
-        for (size_t i = 0; i < sceneCountMultiplier - 1; ++i)
+        std::vector<uint32_t> firstVertices;
+        std::vector<bool> mirrored;
+        uint32_t lodCount = 0;
+
+        for (const auto& [meshIndex, index] : primitives)
         {
-            scenePositions.push_back(glm::vec3(positionDist(rng), positionDist(rng), positionDist(rng)));
+            firstVertices.push_back(static_cast<uint32_t>(batchedScene.vertices.size()) - firstVertexOffset);
+            mirrored.push_back(AppendWorldVertices(rawScene, index, rawScene.meshes[meshIndex].transform,
+                batchedScene.vertices));
+            
+            lodCount = std::max(lodCount, rawScene.primitives[index].lodCount);
+        }
+
+        const auto vertices = std::span(batchedScene.vertices).subspan(firstVertexOffset);
+        const Sphere minSphere = GetMinSphere(vertices);
+
+        batchedScene.primitiveBounds.push_back({ .center = minSphere.center, .radius = minSphere.radius });
+
+        gpu::Primitive& primitive = batchedScene.primitives.emplace_back();
+
+        primitive.vertexOffset = firstVertexOffset;
+        primitive.vertexCount = static_cast<uint32_t>(vertices.size());
+        primitive.lodCount = lodCount;
+
+        for (uint32_t lodIndex = 0; lodIndex < lodCount; ++lodIndex)
+        {
+            gpu::Lod& lod = primitive.lods[lodIndex];
+            lod = { .indexOffset = static_cast<uint32_t>(batchedScene.indices.size()), .indexCount = 0,
+                .meshletOffset = 0, .meshletCount = 0, .error = 0.0f };
+
+            for (size_t i = 0; i < primitives.size(); ++i)
+            {
+                const auto& [meshIndex, index] = primitives[i];
+                const gpu::Primitive& source = rawScene.primitives[index];
+                const gpu::Lod& sourceLod = source.lods[std::min(lodIndex, source.lodCount - 1)];
+
+                AppendLodIndices(rawScene, sourceLod, firstVertices[i], mirrored[i], batchedScene.indices);
+
+                lod.error = std::max(lod.error, sourceLod.error * GetMaxScale(rawScene.meshes[meshIndex].transform));
+            }
+
+            lod.indexCount = static_cast<uint32_t>(batchedScene.indices.size()) - lod.indexOffset;
         }
+    }
+
+    // See EngineConfig::batchSmallPrimitives, batched primitives are replaced by 1 primitive per (material, grid cell)
+    // in world space, owned by a new mesh with identity transform
+    static void BatchSmallPrimitives(RawScene& rawScene)
+    {
+        const auto [sceneCenter, sceneRadius] = CalculateSceneBoundingSphere(rawScene);
+
+        const float maxRadius = sceneRadius * EngineConfig::smallPrimitiveRadius;
+        const float cellSize = std::max(sceneRadius * EngineConfig::primitiveBatchCellSize, 1e-6f);
+        const glm::vec3 gridOrigin = sceneCenter - glm::vec3(sceneRadius);
+
+        using BatchKey = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>; // Material, grid cell
         
-        std::ranges::sort(scenePositions, {}, [](const glm::vec3& v) { return glm::length2(v); });
+        // Ordered, so the batched scene doesn't depend on hashing, values are mesh and primitive indices
+        std::map<BatchKey, std::vector<std::pair<uint32_t, uint32_t>>> batches;
 
-        // Copy the whole scene with random transforms enough times to reach required number of issued draws
-        for (size_t i = 0; i < sceneCountMultiplier - 1; ++i)
+        for (uint32_t meshIndex = 0; meshIndex < rawScene.meshes.size(); ++meshIndex)
         {
-            const float scaleFactor = scaleDist(rng);
-            const auto sceneRotationQuat = glm::quat(glm::vec3(angleDist(rng), angleDist(rng), angleDist(rng)));
+            const Mesh& mesh = rawScene.meshes[meshIndex];
 
-            for (size_t j = 0; j < singleSceneDrawCount; ++j)
+            for (uint32_t index : std::ranges::views::iota(mesh.firstPrimitiveIndex, mesh.firstPrimitiveIndex + mesh.primitiveCount))
             {
-                if (draws.size() == gpu::primitiveCullMaxCommands)
+                const auto [worldCenter, worldRadius] = GetWorldBoundingSphere(rawScene.primitiveBounds[index], mesh.transform);
+
+                if (worldRadius >= maxRadius)
                 {
-                    return;
+                    continue;
                 }
-                
-                const auto& base = draws[j];
 
-                const glm::vec3 localPos = base.position - sceneCenter;
-                const glm::vec3 transformedPos = sceneRotationQuat * (localPos * scaleFactor);
-                const glm::vec3 finalPos = transformedPos + scenePositions[i];
-                const float finalScale = base.scale * scaleFactor;
+                const auto cell = glm::uvec3(glm::max(glm::floor((worldCenter - gridOrigin) / cellSize), glm::vec3(0.0f)));
+
+                batches[{ rawScene.primitiveMaterials[index], cell.x, cell.y, cell.z }].emplace_back(meshIndex, index);
+            }
+        }
+
+        std::erase_if(batches, [](const auto& batch) { return batch.second.size() < 2; });
+
+        if (batches.empty())
+        {
+            return;
+        }
 
-                const auto baseRotationQuat = glm::quat(base.rotation.w, base.rotation.x, base.rotation.y, base.rotation.z);
-                const glm::quat finalRotationQuat = sceneRotationQuat * baseRotationQuat;
-                const auto finalRotation = glm::vec4(finalRotationQuat.x, finalRotationQuat.y, finalRotationQuat.z, finalRotationQuat.w);
+        std::vector<bool> batched(rawScene.primitives.size(), false);
+        size_t batchedCount = 0;
 
-                draws.emplace_back(finalPos, finalScale, finalRotation, base.primitiveIndex);
+        for (const auto& [key, primitives] : batches)
+        {
+            for (const uint32_t index : primitives | std::views::values)
+            {
+                batched[index] = true;
             }
+
+            batchedCount += primitives.size();
         }
+
+        RawScene batchedScene;
+
+        for (const Mesh& mesh : rawScene.meshes)
+        {
+            const auto firstPrimitiveIndex = static_cast<uint32_t>(batchedScene.primitives.size());
+
+            for (uint32_t index : std::ranges::views::iota(mesh.firstPrimitiveIndex, mesh.firstPrimitiveIndex + mesh.primitiveCount))
+            {
+                if (!batched[index])
+                {
+                    CopyPrimitive(rawScene, index, batchedScene);
+                }
+            }
+
+            const auto primitiveCount = static_cast<uint32_t>(batchedScene.primitives.size()) - firstPrimitiveIndex;
+
+            if (primitiveCount != 0)
+            {
+                batchedScene.meshes.emplace_back(firstPrimitiveIndex, primitiveCount, mesh.transform);
+            }
+        }
+
+        for (const auto& [key, primitives] : batches)
+        {
+            AddBatchedPrimitive(rawScene, primitives, batchedScene);
+
+            batchedScene.primitiveMaterials.push_back(std::get<0>(key));
+            batchedScene.meshes.emplace_back(static_cast<uint32_t>(batchedScene.primitives.size() - 1), 1, Matrix4::identity);
+        }
+
+        LogI << "Batched " << batchedCount << " small primitives into "
+            << batches.size() << " primitives\n";
+
+        rawScene = std::move(batchedScene);
+    }
+
+    // Cell distance, cell key, Morton code, primitive index
+    using DrawKey = std::tuple<float, uint64_t, uint64_t, uint32_t>;
+    
+    static constexpr uint32_t mortonMaxCoord = (1 << 21) - 1;
+    
+    static Sphere GetDrawBoundingSphere(const gpu::Draw& draw, const RawScene& rawScene)
+    {
+        const gpu::PrimitiveBounds& bounds = rawScene.primitiveBounds[draw.primitiveIndex];
+        const glm::quat rotationQuat = Math::UnpackQuatSmallestThree(draw.rotation);
+        
+        return { rotationQuat * bounds.center * draw.scale + draw.position, bounds.radius * draw.scale };
+    }
+    
+    static gpu::DrawCluster CreateDrawCluster(const std::span<const Sphere> drawSpheres, const uint32_t firstDraw)
+    {
+        auto min = glm::vec3(std::numeric_limits<float>::max());
+        auto max = glm::vec3(-std::numeric_limits<float>::max());
+        
+        for (const auto& [center, radius] : drawSpheres)
+        {
+            min = glm::min(min, center - glm::vec3(radius));
+            max = glm::max(max, center + glm::vec3(radius));
+        }
+        
+        const glm::vec3 clusterCenter = (min + max) * 0.5f;
+        
+        float clusterRadius = 0.0f;
+        
+        for (const auto& [center, radius] : drawSpheres)
+        {
+            clusterRadius = std::max(clusterRadius, glm::length(center - clusterCenter) + radius);
+        }
+        
+        return { .center = clusterCenter, .radius = clusterRadius, .firstDraw = firstDraw,
+            .drawCount = static_cast<uint32_t>(drawSpheres.size()) };
     }
 }
 
@@ -511,6 +734,13 @@ std::optional<RawScene> SceneHelpers::LoadGltfScene(const FilePath& path)
         LoadTransforms(*gltfData, rawScene, gltfMeshToMesh);
     }
 
+    if constexpr (EngineConfig::batchSmallPrimitives)
+    {
+        ScopeTimer timer("Batch small primitives");
+
+        BatchSmallPrimitives(rawScene);
+    }
+
     return rawScene;
 }
 
@@ -530,7 +760,7 @@ void SceneHelpers::GenerateMeshlets(RawScene& rawScene)
 
             lod.meshletOffset = static_cast<uint32_t>(rawScene.meshlets.size());
             lod.meshletCount = static_cast<uint32_t>(SceneHelpersDetails::GenerateMeshlets(vertices, indices,
-                rawScene.meshlets, rawScene.meshletData, primitive.vertexOffset));
+                rawScene.meshlets, rawScene.meshletBounds, rawScene.meshletData, primitive.vertexOffset));
         }
     }
 }
@@ -550,25 +780,193 @@ std::vector<gpu::Draw> SceneHelpers::GenerateDraws(const RawScene& rawScene)
         glm::decompose(mesh.transform, scale, rotationQuat, position, skew, perspective);
         
         const float scaleScalar = (scale.x + scale.y + scale.z) / 3.0f;
-        const glm::vec4 rotation = glm::vec4(rotationQuat.x, rotationQuat.y, rotationQuat.z, rotationQuat.w);
+        const glm::uvec2 rotation = Math::PackQuatSmallestThree(glm::normalize(rotationQuat));
         
         for (uint32_t index : std::ranges::views::iota(mesh.firstPrimitiveIndex, mesh.firstPrimitiveIndex + mesh.primitiveCount))
         {
-            if (draws.size() == gpu::primitiveCullMaxCommands)
-            {
-                return draws;
-            }
+            draws.push_back({ .position = position, .scale = scaleScalar, .rotation = rotation, .primitiveIndex = index,
+                .materialIndex = 0 });
+        }
+    }
+
+    return draws;
+}
+
+std::vector<gpu::DrawCluster> SceneHelpers::GenerateDrawClusters(const RawScene& rawScene, std::vector<gpu::Draw>& draws)
+{
+    using namespace SceneHelpersDetails;
+    
+    ScopeTimer timer("Generate draw clusters");
+    
+    if (draws.empty())
+    {
+        return {};
+    }
+    
+    const std::vector<Sphere> drawSpheres = Helpers::Transform(GetDrawBoundingSphere, draws, rawScene);
+    
+    auto min = glm::vec3(std::numeric_limits<float>::max());
+    auto max = glm::vec3(-std::numeric_limits<float>::max());
+    
+    for (const Sphere& sphere : drawSpheres)
+    {
+        min = glm::min(min, sphere.center);
+        max = glm::max(max, sphere.center);
+    }
+    
+    // Loose grid: draws are assigned to cells by their centers, so cluster bounds can overlap
+    const float averageDrawsPerCluster = static_cast<float>(draws.size()) / static_cast<float>(gpu::drawClusterSize);
+    const auto cellsPerAxis = static_cast<uint32_t>(std::max(1.0f, std::ceil(std::cbrt(averageDrawsPerCluster))));
+    const glm::vec3 cellSize = glm::max((max - min) / static_cast<float>(cellsPerAxis), glm::vec3(1e-6f));
+    
+    const glm::vec3 mortonScale = static_cast<float>(mortonMaxCoord) / glm::max(max - min, glm::vec3(1e-6f));
+    
+    const auto getDrawKey = [&](const uint32_t index) {
+        const glm::vec3& position = drawSpheres[index].center;
+        
+        const auto cell = glm::uvec3(glm::clamp(glm::floor((position - min) / cellSize), glm::vec3(0.0f),
+            glm::vec3(static_cast<float>(cellsPerAxis - 1))));
+        
+        // Keep draws close to the origin first, draw count option cuts off the tail
+        const float cellDistance = glm::length2(min + (glm::vec3(cell) + 0.5f) * cellSize);
+        const uint64_t cellKey = cell.x + (cell.y + static_cast<uint64_t>(cell.z) * cellsPerAxis) * cellsPerAxis;
+        
+        if constexpr (EngineConfig::sortDrawsByMortonCode)
+        {
+            const auto mortonCoords = glm::uvec3(glm::clamp((position - min) * mortonScale, glm::vec3(0.0f),
+                glm::vec3(static_cast<float>(mortonMaxCoord))));
             
-            draws.emplace_back(position, scaleScalar, rotation, index);
+            return DrawKey{ cellDistance, cellKey, Math::MortonCode(mortonCoords), draws[index].primitiveIndex };
         }
+        
+        return DrawKey{ cellDistance, cellKey, 0, 0 };
+    };
+    
+    std::vector<uint32_t> order(draws.size());
+    std::iota(order.begin(), order.end(), 0);
+    
+    const std::vector<DrawKey> drawKeys = Helpers::Transform(getDrawKey, order);
+    
+    std::ranges::stable_sort(order, {}, [&](const uint32_t index) { return drawKeys[index]; });
+    
+    std::vector<gpu::Draw> sortedDraws;
+    std::vector<Sphere> sortedDrawSpheres;
+    sortedDraws.reserve(draws.size());
+    sortedDrawSpheres.reserve(draws.size());
+    
+    for (const uint32_t index : order)
+    {
+        sortedDraws.push_back(draws[index]);
+        sortedDrawSpheres.push_back(drawSpheres[index]);
     }
     
-    if constexpr (EngineConfig::randomlyCopyScene)
+    draws = std::move(sortedDraws);
+    
+    std::vector<gpu::DrawCluster> clusters;
+    
+    for (uint32_t first = 0; first < draws.size();)
     {
-        SceneHelpersDetails::RandomlyCopyScene(rawScene, draws);
+        const uint64_t cellKey = std::get<1>(drawKeys[order[first]]);
+        
+        uint32_t last = first + 1;
+        
+        while (last < draws.size() && last - first < gpu::drawClusterSize && std::get<1>(drawKeys[order[last]]) == cellKey)
+        {
+            ++last;
+        }
+        
+        clusters.push_back(CreateDrawCluster(std::span(sortedDrawSpheres).subspan(first, last - first), first));
+        
+        first = last;
     }
+    
+    return clusters;
+}
 
-    return draws;
+gpu::SceneCopyParams SceneHelpers::GetSceneCopyParams(const RawScene& rawScene, const size_t sceneDrawCount,
+    const size_t sceneClusterCount)
+{
+    const auto& [sceneCenter, sceneRadius] = SceneHelpersDetails::CalculateSceneBoundingSphere(rawScene);
+    
+    // Copy the whole scene enough times to reach required number of issued draws
+    size_t copyCount = 1;
+    
+    if (EngineConfig::randomlyCopyScene && sceneDrawCount > 0)
+    {
+        copyCount = std::max(copyCount, EngineConfig::randomlyCopiedSceneDrawCount / sceneDrawCount);
+    }
+    
+    return { .sceneCenter = sceneCenter, .sceneRadius = sceneRadius, .seed = EngineConfig::randomlyCopiedSceneSeed,
+        .sceneDrawCount = static_cast<uint32_t>(sceneDrawCount), .sceneClusterCount = static_cast<uint32_t>(sceneClusterCount),
+        .copyCount = static_cast<uint32_t>(copyCount) };
+}
+
+std::vector<glm::vec4> SceneHelpers::GetSceneCopyTranslations(const gpu::SceneCopyParams& params)
+{
+    const float cubeHalfSize = std::cbrt(static_cast<float>(params.copyCount)) * params.sceneRadius;
+    
+    std::mt19937 rng(params.seed);
+    std::uniform_real_distribution<float> positionDist(-cubeHalfSize, cubeHalfSize);
+    
+    std::vector<glm::vec4> translations(params.copyCount, glm::vec4(params.sceneCenter, 0.0f));
+    
+    for (size_t i = 1; i < translations.size(); ++i)
+    {
+        const float x = positionDist(rng);
+        const float y = positionDist(rng);
+        const float z = positionDist(rng);
+        
+        translations[i] = glm::vec4(x, y, z, 0.0f);
+    }
+    
+    // Closest copies go first, draw count option cuts off the tail
+    std::ranges::sort(translations.begin() + 1, translations.end(), {},
+        [](const glm::vec4& v) { return glm::length2(glm::vec3(v)); });
+    
+    return translations;
+}
+
+void SceneHelpers::RandomlyCopyScene(const gpu::SceneCopyParams& params, const std::vector<glm::vec4>& translations,
+    std::vector<gpu::Draw>& draws, std::vector<gpu::DrawCluster>& drawClusters)
+{
+    ScopeTimer timer("Randomly copy scene");
+    
+    Assert(draws.size() == params.sceneDrawCount && drawClusters.size() == params.sceneClusterCount);
+    Assert(translations.size() == params.copyCount);
+    
+    draws.reserve(static_cast<size_t>(params.copyCount) * params.sceneDrawCount);
+    drawClusters.reserve(static_cast<size_t>(params.copyCount) * params.sceneClusterCount);
+    
+    for (uint32_t copyIndex = 1; copyIndex < params.copyCount; ++copyIndex)
+    {
+        const gpu::SceneCopyTransform transform = gpu::getSceneCopyTransform(params, copyIndex,
+            glm::vec3(translations[copyIndex]));
+        const auto rotationQuat = glm::quat(transform.rotation.w, transform.rotation.x, transform.rotation.y,
+            transform.rotation.z);
+        
+        const auto transformPoint = [&](const glm::vec3& point) {
+            return rotationQuat * ((point - params.sceneCenter) * transform.scale) + transform.translation;
+        };
+        
+        for (uint32_t i = 0; i < params.sceneDrawCount; ++i)
+        {
+            const gpu::Draw base = draws[i];
+            
+            const glm::quat baseRotationQuat = Math::UnpackQuatSmallestThree(base.rotation);
+            
+            draws.push_back({ .position = transformPoint(base.position), .scale = base.scale * transform.scale,
+                .rotation = Math::PackQuatSmallestThree(glm::normalize(rotationQuat * baseRotationQuat)),
+                .primitiveIndex = base.primitiveIndex, .materialIndex = base.materialIndex });
+        }
+        
+        for (uint32_t i = 0; i < params.sceneClusterCount; ++i)
+        {
+            const gpu::DrawCluster base = drawClusters[i];
+            
+            drawClusters.push_back({ .center = transformPoint(base.center), .radius = base.radius * transform.scale,
+                .firstDraw = base.firstDraw + copyIndex * params.sceneDrawCount, .drawCount = base.drawCount });
+        }
+    }
 }
 
 std::vector<VkVertexInputBindingDescription> SceneHelpers::GetVertexBindings()
@@ -36,6 +36,11 @@ public:
         return rawScene;
     }
 
+    const RawScene& GetRaw() const
+    {
+        return rawScene;
+    }
+
 private:
     void InitTexture();
 
@@ -21,8 +21,11 @@ struct RawScene
     std::vector<uint32_t> indices;
     std::vector<uint32_t> meshletData;
     std::vector<gpu::Meshlet> meshlets;
+    std::vector<gpu::MeshletBounds> meshletBounds; // Same indexing as meshlets
     std::vector<gpu::Primitive> primitives;
+    std::vector<gpu::PrimitiveBounds> primitiveBounds; // Same indexing as primitives
 
     // CPU data
     std::vector<Mesh> meshes;
+    std::vector<uint32_t> primitiveMaterials; // glTF material index (UINT32_MAX if none), same indexing as primitives
 };
\ No newline at end of file
@@ -11,6 +11,20 @@ namespace SceneHelpers
 
     // TODO: Actually get this from scene traversal
     std::vector<gpu::Draw> GenerateDraws(const RawScene& rawScene);
+    
+    // Reorders draws so spatially close ones are stored contiguously and groups them into clusters (loose grid cells
+    // split into chunks of up to gpu::drawClusterSize draws), see EngineConfig::sortDrawsByMortonCode for order inside cells
+    std::vector<gpu::DrawCluster> GenerateDrawClusters(const RawScene& rawScene, std::vector<gpu::Draw>& draws);
+    
+    // Scene is copied with random transforms to reach EngineConfig::randomlyCopiedSceneDrawCount draws (1 copy if disabled)
+    gpu::SceneCopyParams GetSceneCopyParams(const RawScene& rawScene, size_t sceneDrawCount, size_t sceneClusterCount);
+    
+    // Random copy positions in a cube around the origin sorted by distance to it, xyz of copy i, the scene itself stays
+    std::vector<glm::vec4> GetSceneCopyTranslations(const gpu::SceneCopyParams& params);
+    
+    // Appends copies to draws and clusters of the scene, CPU reference of RandomlyCopyScene.comp
+    void RandomlyCopyScene(const gpu::SceneCopyParams& params, const std::vector<glm::vec4>& translations,
+        std::vector<gpu::Draw>& draws, std::vector<gpu::DrawCluster>& drawClusters);
 
     std::vector<VkVertexInputBindingDescription> GetVertexBindings();
     std::vector<VkVertexInputAttributeDescription> GetVertexAttributes();
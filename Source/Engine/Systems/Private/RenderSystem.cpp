@@ -93,6 +93,7 @@ void RenderSystem::Render()
     vkResetFences(device, 1, &fence);
     
     StatsUtils::GatherFrameStats(device, frame.queryPools, frame.renderStats);
+    renderer->GatherFrameStats(frame, frame.renderStats);
 
     // Acquire next image from the swapchain, frame wait semaphore will be signaled by the presentation engine when it
     // finishes using the image so we can start rendering
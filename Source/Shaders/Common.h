@@ -32,6 +32,7 @@ struct CullData
     float frustumTopY;
     float frustumTopZ;
     float near; // Distance to the near plane (so it's always positive)
+    float contributionThreshold; // NDC extent, CONTRIBUTION_CULL_THRESHOLD scaled by the quality governor
 };
 
 struct PushConstants 
@@ -41,10 +42,90 @@ struct PushConstants
     uint drawCount;
     uint bUseLods;
     float lodTarget; // lod target error at z = 1
-    uint padding;
+    uint clusterCount;
     CullData cullData;
 };
 
+// View data the current depth pyramid was built with, used to test draws against it in the next frame's first pass
+struct ReprojectionData
+{
+    mat4 view;
+    float projection00;
+    float projection11;
+    float near;
+    uint bValid;
+};
+
+// View culled by the same PrimitiveCull.comp threads as the main one (shadow cascade, reflection, secondary viewport),
+// so draw and primitive data are fetched once for all views
+struct ExtraView
+{
+    vec4 frustumPlanes[6]; // World space, normalized and pointing inside, so any projection is supported
+    vec3 position; // LODs are selected by distance from it
+    float lodTarget; // Same as PushConstants::lodTarget, but for this view
+};
+
+// Draws visible in extra view i are written to its own command stream: indexed commands (any graphics pipeline)
+// and visible instances starting from i * commandCapacity, their count is DrawCounters::extraViewDrawCounts[i]
+struct ExtraViews
+{
+    uint viewCount;
+    uint commandCapacity; // Per view
+    uint padding1;
+    uint padding2;
+    ExtraView views[MAX_EXTRA_VIEW_COUNT];
+};
+
+// Point light if cosOuterAngle is -1, otherwise spot light, both fade out to 0 at range
+struct Light
+{
+    vec3 position; // World space
+    float range;
+    vec3 color; // Premultiplied by intensity
+    float cosOuterAngle;
+    vec3 direction; // Spot lights only, normalized
+    float cosInnerAngle;
+};
+
+// View space froxel grid: LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y screen tiles, each split into LIGHT_CLUSTER_Z slices
+// exponential in view depth between near and far, where far is the farthest depth lights reach
+// Slice of view depth d is log(d) * sliceScale + sliceBias
+struct LightGrid
+{
+    vec2 tileSize; // In pixels
+    vec2 screenSize;
+    float sliceScale;
+    float sliceBias;
+    float far;
+    uint lightCount;
+};
+
+// Uploaded every frame, only the header and first lightCount lights, see LightCullStage
+struct Lights
+{
+    LightGrid grid;
+    Light lights[MAX_LIGHT_COUNT];
+};
+
+// Written by LightCull.comp: light count of each cluster, then MAX_CLUSTER_LIGHTS light indices of each cluster
+struct LightClusters
+{
+    uint lightCounts[LIGHT_CLUSTER_COUNT];
+    uint lightIndices[LIGHT_CLUSTER_COUNT * MAX_CLUSTER_LIGHTS];
+};
+
+// How many draws each culling pass has emitted, reprojected ones are also counted in first pass
+// Overflow counts commands of both passes and extra views which didn't fit into their buffers and were dropped
+// Extra view counts can exceed the capacity, so they must be clamped by it when used as draw counts
+struct DrawCounters
+{
+    uint firstPassDrawCount;
+    uint secondPassDrawCount;
+    uint reprojectedDrawCount;
+    uint overflowCommandCount;
+    uint extraViewDrawCounts[MAX_EXTRA_VIEW_COUNT];
+};
+
 // TODO: Use positions only for shadows pass: measure impact and try to separate, do the packing, now 64 bytes / vertex
 struct Vertex
 {
@@ -71,6 +152,16 @@ struct Meshlet
     uint padding2;
 };
 
+// Bounding sphere and normal cone of the meshlet in primitive space, Meshlet.task estimates its triangle size on screen
+// from the sphere, MeshletCull.comp culls backfacing meshlets by the cone (cutoff is 1.0 when it can't be culled)
+struct MeshletBounds
+{
+    vec3 center;
+    float radius;
+    vec3 coneAxis;
+    float coneCutoff;
+};
+
 struct Lod
 {
     uint indexOffset;
@@ -80,30 +171,56 @@ struct Lod
     float error;
 };
 
-struct Primitive
+// Primitive data is split by access frequency: culling reads bounds of every draw, but LOD table only of visible ones
+struct PrimitiveBounds
 {
     vec3 center;
     float radius;
+};
 
+struct Primitive
+{
     uint vertexOffset;
     uint vertexCount;
 
     uint lodCount;
-    Lod lods[MAX_LOD_COUNT];
     uint padding;
+    Lod lods[MAX_LOD_COUNT];
 };
 
-struct Draw // Per individual thread in PrimitiveCull workgroup, the "highest level" draw
+struct Draw // Per individual thread in PrimitiveCull workgroup, the "highest level" draw, 32 bytes
 {
     vec3 position;
     float scale;
-    vec4 rotation;
+    uvec2 rotation; // Smallest three quaternion, see Math::PackQuatSmallestThree and unpackRotation() in Math.glsl
 
     uint primitiveIndex;
-    // material index, etc.
+    uint materialIndex; // Not used yet
+};
+
+// Spatially close draws, stored contiguously in draw buffer starting from firstDraw, see SceneHelpers::GenerateDrawClusters
+struct DrawCluster
+{
+    vec3 center;
+    float radius;
+
+    uint firstDraw;
+    uint drawCount;
     uint padding1;
     uint padding2;
-    uint padding3; // TODO: Fix paddings
+};
+
+// Parameters of the scene copies, copy i occupies draws [i * sceneDrawCount, (i + 1) * sceneDrawCount) and clusters
+// the same way, copy 0 is the scene itself, see Scene/SceneCopy.h
+struct SceneCopyParams
+{
+    vec3 sceneCenter;
+    float sceneRadius; // Copies are placed in a cube of cbrt(copyCount) scene diameters
+
+    uint seed;
+    uint sceneDrawCount;
+    uint sceneClusterCount;
+    uint copyCount; // Including the scene itself
 };
 
 struct VkDrawIndexedIndirectCommand
@@ -115,9 +232,96 @@ struct VkDrawIndexedIndirectCommand
     uint firstInstance;
 };
 
+// Visible draw emitted by PrimitiveCull.comp, shaders use it instead of reading the draw and rotating every vertex
+// World position is vec4(position, 1.0) * transform (transposed affine 3x4 matrix)
+struct VisibleInstance
+{
+    mat3x4 transform;
+};
+
+// Visible draws of the same primitive and LOD are drawn by 1 instanced command, instance list of the bucket is stored
+// in instance buffer starting from firstInstance, see InstancedCommands.comp
+struct DrawBucket
+{
+    uint instanceCount;
+    uint firstInstance;
+};
+
+// Visible draw waiting to be written into instance list of its bucket
+struct InstancedDraw
+{
+    uint instanceIndex;
+    uint bucketIndex;
+    uint bucketSlot;
+};
+
+struct VkDispatchIndirectCommand
+{
+    uint x;
+    uint y;
+    uint z;
+};
+
+// Indirect dispatch of PrimitiveCull.comp, 1 workgroup per visible cluster, laid out in rows of CLUSTER_DISPATCH_WIDTH
+struct ClusterDispatch
+{
+    VkDispatchIndirectCommand command;
+    uint visibleClusterCount;
+};
+
+// Meshlets with subpixel triangles appended by Meshlet.task as (visible instance, meshlet) pairs instead of emitting mesh
+// shaders for them, SoftwareRaster.comp rasterizes them with 1 workgroup each, laid out in rows of CLUSTER_DISPATCH_WIDTH
+struct SoftwareRaster
+{
+    VkDispatchIndirectCommand command;
+    uint meshletCount; // Can exceed MAX_SOFTWARE_MESHLETS, appended past it aren't stored
+    uvec2 screenSize; // Software visibility buffer holds 1 uint64_t per pixel, row by row
+};
+
+struct VkDrawIndirectCommand
+{
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+};
+
+// Header of the impostor draw buffer, followed by indices of the draws culling has switched to impostors
+// 1 triangle strip quad per draw, second pass instances start after the first pass ones, see ImpostorStage
+struct ImpostorCommands
+{
+    VkDrawIndirectCommand firstPass;
+    VkDrawIndirectCommand secondPass;
+};
+
+// Header of the debug bounds buffer, followed by indices of the draws culling passes found visible this frame
+// Both commands draw all of them as instances, index counts are set by DebugStage, instance counts by culling
+struct DebugBoundsCommands
+{
+    VkDrawIndexedIndirectCommand spheres;
+    VkDrawIndexedIndirectCommand rectangles;
+};
+
+// Header of the meshlet draw buffer of vertex pipeline meshlet culling, followed by 1 indexed command per task command
+// with visible meshlets, culling passes size the dispatch by their task commands, MeshletCull.comp appends commands and
+// triangle indices of their visible meshlets
+struct MeshletDraws
+{
+    uint commandCount; // First, so DrawChunks.comp reads it as the command count, can exceed the capacity
+    uint indexCount; // Allocated in the meshlet index buffer, can exceed its capacity
+    VkDispatchIndirectCommand dispatch; // 1 workgroup per task command, laid out in rows of CLUSTER_DISPATCH_WIDTH
+};
+
+struct VkDrawMeshTasksIndirectCommandEXT
+{
+    uint groupCountX;
+    uint groupCountY;
+    uint groupCountZ;
+};
+
 struct TaskCommand
 {
-    uint drawIndex;
+    uint instanceIndex;
     uint meshletOffset;
     uint meshletCount;
     uint padding;
@@ -125,8 +329,16 @@ struct TaskCommand
 
 struct TaskPayload
 {
-    uint drawIndex;
+    uint instanceIndex;
+    uint meshletOffset;
+};
+
+// Task payload when some meshlets are rasterized in software, mesh shaders get the rest compacted
+struct CompactedTaskPayload
+{
+    uint instanceIndex;
     uint meshletOffset;
+    uint meshletIndices[TASK_WG_SIZE]; // Relative to meshletOffset, 1 per emitted mesh shader workgroup
 };
 
 #ifdef __cplusplus
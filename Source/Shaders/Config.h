@@ -2,18 +2,53 @@
 #define CONFIG_H
 
 #define PRIMITIVE_CULL_WG_SIZE 64
-#define PRIMITIVE_CULL_MAX_COMMANDS 4194304 // Based on maxTaskWorkGroupTotalCount for my 3060
 #define DEPTH_PYRAMID_WG_SIZE 32
+#define CLUSTER_CULL_WG_SIZE 64
+#define DRAW_CLUSTER_SIZE PRIMITIVE_CULL_WG_SIZE // Max draws in a cluster, 1 PrimitiveCull workgroup per visible cluster
+#define CLUSTER_DISPATCH_WIDTH 65535 // Guaranteed minimum of maxComputeWorkGroupCount, more clusters go to the next row
+#define DRAW_CHUNKS_WG_SIZE 64
+#define SCENE_COPY_WG_SIZE 64
+#define LIGHT_CULL_WG_SIZE 64 // 1 workgroup per light cluster
+#define SOFTWARE_RASTER_WG_SIZE 64 // 1 workgroup per software rasterized meshlet
 
 #define TASK_WG_SIZE 64
 #define MESH_WG_SIZE 64
 
+#ifndef TASK_CHUNK_SIZE
+    #define TASK_CHUNK_SIZE 65535 // Task workgroups per indirect mesh draw, set from device limits at runtime
+#endif
+
 #define MAX_LOD_COUNT 8
 
+#define MAX_EXTRA_VIEW_COUNT 4 // Views culled along with the main one, see gpu::ExtraViews
+
 #define MAX_MESHLET_VERTICES 64
 #define MAX_MESHLET_TRIANGLES 96
 
-#define CONTRIBUTION_CULL_THRESHOLD 0.003
+#define VISIBILITY_TRIANGLE_BITS 7 // Mesh pipeline triangle ID: meshlet index, then triangle in the meshlet
+#define INVALID_VISIBILITY_INSTANCE 0xFFFFFFFFu // Cleared visibility buffer texel, no geometry
+
+// Meshlets with smaller estimated triangle edge in pixels are rasterized in compute, see Meshlet.task
+#define SOFTWARE_RASTER_TRIANGLE_SIZE 2.0
+#define MAX_SOFTWARE_MESHLETS (1 << 20) // Per frame, the rest is left to mesh shaders, fits 32 - VISIBILITY_TRIANGLE_BITS
+#define HARDWARE_RASTER_PAYLOAD 0xFFFFFFFFu // Software visibility texel closest with a hardware rasterized triangle
+
+#define MAX_LIGHT_COUNT 4096 // Point and spot lights shaded through light clusters, see LightCull.comp
+#define MAX_CLUSTER_LIGHTS 128 // Lights past it are dropped from the cluster
+#define LIGHT_CLUSTER_X 16 // Screen tiles
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24 // Depth slices, exponential in view depth
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z)
+
+#define CONTRIBUTION_CULL_THRESHOLD 0.003 // Default of CullData::contributionThreshold
+
+// Draws with smaller NDC extent are drawn as 1 quad with the baked view of their primitive closest to the camera
+#define IMPOSTOR_THRESHOLD 0.03
+#define IMPOSTOR_FRAME_COUNT 8 // Octahedral views per side, see Impostors/Impostor.h
+#define IMPOSTOR_FRAME_SIZE 16 // In pixels
+#define IMPOSTOR_TILE_SIZE (IMPOSTOR_FRAME_COUNT * IMPOSTOR_FRAME_SIZE) // All views of a primitive
+#define IMPOSTOR_ATLAS_TILES 16 // Tiles per atlas row and column
+#define MAX_IMPOSTOR_PRIMITIVES (IMPOSTOR_ATLAS_TILES * IMPOSTOR_ATLAS_TILES) // The rest always keep their geometry
 
 #ifndef MESH_PIPELINE
     #define MESH_PIPELINE 1
@@ -25,12 +60,36 @@
 
 #define VISUALIZE_MESHLETS 0 // TODO: Toggle from render options as well
 
+#ifndef CLUSTER_CULLING
+    #define CLUSTER_CULLING 0
+#endif
+
+#ifndef INSTANCED_DRAWS // Vertex pipeline only
+    #define INSTANCED_DRAWS 0
+#endif
+
+#ifndef MESHLET_CULLING
+    #define MESHLET_CULLING 0 // Vertex pipeline: task commands are culled per meshlet by MeshletCull.comp
+#endif
+
 #ifndef VISUALIZE_LODS
     #define VISUALIZE_LODS 0 // TODO: It's not working after DRAW_INDIRECT_COUNT fallback implementation
     // not working only for meshlet pipeline, regular is fixed already, but I can't test it as I've sold my PC and will
     // get the new one only in like 5 months :(
 #endif
 
+#ifndef VISIBILITY_BUFFER
+    #define VISIBILITY_BUFFER 0 // Draws write (visible instance, triangle) IDs, see VisibilityResolve.frag
+#endif
+
+#ifndef SOFTWARE_RASTERIZATION
+    #define SOFTWARE_RASTERIZATION 0 // Mesh pipeline visibility buffer only, see SoftwareRasterStage
+#endif
+
+#ifndef IMPOSTORS
+    #define IMPOSTORS 0 // Culling appends far draws for ImpostorStage instead of emitting their geometry
+#endif
+
 #define DEBUG_VERTEX_COLOR VISUALIZE_MESHLETS || VISUALIZE_LODS
 
 #ifdef __cplusplus
@@ -39,23 +98,56 @@
 namespace gpu 
 {   
     constexpr uint32_t primitiveCullWgSize = PRIMITIVE_CULL_WG_SIZE;
-    constexpr uint32_t primitiveCullMaxCommands = PRIMITIVE_CULL_MAX_COMMANDS;
     constexpr uint32_t depthPyramidWgSize = DEPTH_PYRAMID_WG_SIZE;
+    constexpr uint32_t clusterCullWgSize = CLUSTER_CULL_WG_SIZE;
+    constexpr uint32_t drawClusterSize = DRAW_CLUSTER_SIZE;
+    constexpr uint32_t clusterDispatchWidth = CLUSTER_DISPATCH_WIDTH;
+    constexpr uint32_t drawChunksWgSize = DRAW_CHUNKS_WG_SIZE;
+    constexpr uint32_t sceneCopyWgSize = SCENE_COPY_WG_SIZE;
+    constexpr uint32_t lightCullWgSize = LIGHT_CULL_WG_SIZE;
+    constexpr uint32_t softwareRasterWgSize = SOFTWARE_RASTER_WG_SIZE;
 
     constexpr uint32_t taskWgSize = TASK_WG_SIZE;
     constexpr uint32_t meshWgSize = MESH_WG_SIZE;
 
     constexpr uint32_t maxLodCount = MAX_LOD_COUNT;
 
+    constexpr uint32_t maxExtraViewCount = MAX_EXTRA_VIEW_COUNT;
+
     constexpr uint32_t maxMeshletVertices = MAX_MESHLET_VERTICES;
     constexpr uint32_t maxMeshletTriangles = MAX_MESHLET_TRIANGLES;
+
+    constexpr uint32_t invalidVisibilityInstance = INVALID_VISIBILITY_INSTANCE;
+
+    constexpr uint32_t maxSoftwareMeshlets = MAX_SOFTWARE_MESHLETS;
+
+    constexpr uint32_t maxLightCount = MAX_LIGHT_COUNT;
+    constexpr uint32_t maxClusterLights = MAX_CLUSTER_LIGHTS;
+    constexpr uint32_t lightClusterX = LIGHT_CLUSTER_X;
+    constexpr uint32_t lightClusterY = LIGHT_CLUSTER_Y;
+    constexpr uint32_t lightClusterZ = LIGHT_CLUSTER_Z;
+    constexpr uint32_t lightClusterCount = LIGHT_CLUSTER_COUNT;
+
+    constexpr uint32_t impostorFrameCount = IMPOSTOR_FRAME_COUNT;
+    constexpr uint32_t impostorFrameSize = IMPOSTOR_FRAME_SIZE;
+    constexpr uint32_t impostorTileSize = IMPOSTOR_TILE_SIZE;
+    constexpr uint32_t impostorAtlasTiles = IMPOSTOR_ATLAS_TILES;
+    constexpr uint32_t maxImpostorPrimitives = MAX_IMPOSTOR_PRIMITIVES;
 }
 
 namespace gpu::defines
 {
     constexpr std::string_view meshPipeline = "MESH_PIPELINE";
     constexpr std::string_view drawIndirectCount = "DRAW_INDIRECT_COUNT";
+    constexpr std::string_view clusterCulling = "CLUSTER_CULLING";
+    constexpr std::string_view instancedDraws = "INSTANCED_DRAWS";
+    constexpr std::string_view meshletCulling = "MESHLET_CULLING";
     constexpr std::string_view visualizeLods = "VISUALIZE_LODS";
+    constexpr std::string_view taskChunkSize = "TASK_CHUNK_SIZE";
+    constexpr std::string_view visibilityBuffer = "VISIBILITY_BUFFER";
+    constexpr std::string_view softwareRasterization = "SOFTWARE_RASTERIZATION";
+    constexpr std::string_view impostors = "IMPOSTORS";
+    constexpr std::string_view debugBounds = "DEBUG_BOUNDS";
 }
 
 #endif
@@ -0,0 +1,88 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+// Visible cluster entries store cluster index and these bits: if cluster was visible last frame and if it's culled
+// for the main view, but visible in extra views (see gpu::ExtraViews)
+#define CLUSTER_VISIBLE_LAST_FRAME_BIT 0x80000000u
+#define CLUSTER_MAIN_VIEW_CULLED_BIT 0x40000000u
+#define CLUSTER_INDEX_MASK 0x3FFFFFFFu
+
+// Culling passes visiting every draw (main view without occlusion culling or its first pass) cull extra views too
+#define EXTRA_VIEWS (!OCCLUSION_CULLING || FIRST_PASS)
+
+// Center is in view space
+bool frustumCull(CullData cullData, vec3 center, float radius)
+{
+    bool bCulled = false;
+
+    // Utilize symmetry: left + right, bottom + top
+    bCulled = bCulled || cullData.frustumRightX * abs(center.x) + cullData.frustumRightZ * center.z < -radius;
+    bCulled = bCulled || cullData.frustumTopY * abs(center.y) + cullData.frustumTopZ * center.z < -radius;
+
+    bCulled = bCulled || center.z - radius > -cullData.near;
+    // Note: infinite far
+
+    return bCulled;
+}
+
+// Center is in world space, planes are normalized and point inside
+bool frustumPlanesCull(vec4 planes[6], vec3 center, float radius)
+{
+    bool bCulled = false;
+
+    for (uint i = 0; i < 6; ++i)
+    {
+        bCulled = bCulled || dot(planes[i].xyz, center) + planes[i].w < -radius;
+    }
+
+    return bCulled;
+}
+
+// lbrt is NDC rect of the sphere (view space center and radius) for the projection depth pyramid was built with
+bool occlusionCull(sampler2D depthPyramid, vec4 lbrt, vec3 center, float radius, float near)
+{
+    vec4 lbrtUv = vec4(ndcToUv(lbrt.xy), ndcToUv(lbrt.zw));
+
+    // TODO: Support samplerFilterMinmax implementation when we'll have it available ;)
+    // We use ceil() here to reduce rectangle to 1x1 texel or smaller, which can cover 2x2 texels (as it's arbitrarily offset)
+    // Sampler does nearest filtering and we sample 4 corners to be conservative
+    vec2 extentsInTexels = vec2(textureSize(depthPyramid, 0)) * (lbrtUv.zy - lbrtUv.xw); // in UV b > t, so it's y - w
+    float mipLevel = ceil(log2((max(extentsInTexels.x, extentsInTexels.y))));
+
+    float d0 = textureLod(depthPyramid, lbrtUv.xy, mipLevel).r;
+    float d1 = textureLod(depthPyramid, lbrtUv.zy, mipLevel).r;
+    float d2 = textureLod(depthPyramid, lbrtUv.xw, mipLevel).r;
+    float d3 = textureLod(depthPyramid, lbrtUv.zw, mipLevel).r;
+
+    float minDepth = min(min(d0, d1), min(d2, d3));
+
+    float sphereDepth = -near / (center.z + radius); // near is positive, but camera looks in -z direction
+    return sphereDepth < minDepth;
+}
+
+// Conservative: we cull only when the sphere (world space center) is completely inside the view depth pyramid was built with
+// and occluded by its depth, everything we have no information about is considered visible
+bool reprojectionOcclusionCull(sampler2D depthPyramid, ReprojectionData reprojection, vec3 worldCenter, float radius)
+{
+    if (reprojection.bValid == 0)
+    {
+        return false;
+    }
+
+    vec3 center = (reprojection.view * vec4(worldCenter, 1.0)).xyz;
+
+    vec4 lbrt;
+    if (!sphereNdcExtents(center, radius, reprojection.projection00, reprojection.projection11, reprojection.near, lbrt))
+    {
+        return false;
+    }
+
+    if (any(lessThan(lbrt.xy, vec2(-1.0))) || any(greaterThan(lbrt.zw, vec2(1.0))))
+    {
+        return false;
+    }
+
+    return occlusionCull(depthPyramid, lbrt, center, radius, reprojection.near);
+}
+
+#endif
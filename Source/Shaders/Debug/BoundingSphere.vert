@@ -17,20 +17,26 @@ layout(set = 0, binding = 0) readonly buffer Draws
     Draw draws[]; 
 };
 
-layout(set = 0, binding = 1) readonly buffer Primitives 
+layout(set = 0, binding = 1) readonly buffer PrimitiveBoundsBuffer
 {
-    Primitive primitives[]; 
+    PrimitiveBounds primitiveBounds[];
+};
+
+layout(set = 0, binding = 2) readonly buffer DebugBoundsBuffer
+{
+    DebugBoundsCommands debugBoundsCommands;
+    uint debugBoundsDraws[]; // Instances are the draws culling found visible
 };
 
 void main()
 {
     vec3 position = inPos;
 
-    Draw draw = draws[gl_InstanceIndex];
-    Primitive primitive = primitives[draw.primitiveIndex];
+    Draw draw = draws[debugBoundsDraws[gl_InstanceIndex]];
+    PrimitiveBounds bounds = primitiveBounds[draw.primitiveIndex];
 
-    vec3 primitiveCenterWorldPos = rotateQuat(primitive.center, draw.rotation) * draw.scale + draw.position;
-    position = position * primitive.radius * draw.scale + primitiveCenterWorldPos;
+    vec3 primitiveCenterWorldPos = rotateQuat(bounds.center, unpackRotation(draw.rotation)) * draw.scale + draw.position;
+    position = position * bounds.radius * draw.scale + primitiveCenterWorldPos;
 
     vec4 clip = globals.projection * globals.view * vec4(position, 1.0);
 
@@ -15,20 +15,26 @@ layout(set = 0, binding = 0) readonly buffer Draws
     Draw draws[]; 
 };
 
-layout(set = 0, binding = 1) readonly buffer Primitives 
+layout(set = 0, binding = 1) readonly buffer PrimitiveBoundsBuffer
 {
-    Primitive primitives[]; 
+    PrimitiveBounds primitiveBounds[];
+};
+
+layout(set = 0, binding = 2) readonly buffer DebugBoundsBuffer
+{
+    DebugBoundsCommands debugBoundsCommands;
+    uint debugBoundsDraws[]; // Instances are the draws culling found visible
 };
 
 void main()
 {
-    Draw draw = draws[gl_InstanceIndex];    
-    Primitive primitive = primitives[draw.primitiveIndex];
+    Draw draw = draws[debugBoundsDraws[gl_InstanceIndex]];    
+    PrimitiveBounds bounds = primitiveBounds[draw.primitiveIndex];
 
-    vec3 center = rotateQuat(primitive.center, draw.rotation) * draw.scale + draw.position;
+    vec3 center = rotateQuat(bounds.center, unpackRotation(draw.rotation)) * draw.scale + draw.position;
     center = (globals.cullData.view * vec4(center, 1.0)).xyz;
 
-    float radius = primitive.radius * draw.scale;
+    float radius = bounds.radius * draw.scale;
 
     vec4 lbrt;
     bool validExtents = sphereNdcExtents(center, radius, globals.projection[0][0], globals.projection[1][1], globals.cullData.near, lbrt);
@@ -2,12 +2,30 @@
 
 #extension GL_GOOGLE_include_directive: require
 
-#include "Config.h"
+#include "Common.h"
+
+layout(push_constant) uniform Globals
+{
+    PushConstants globals;
+};
+
+layout(set = 0, binding = 8) readonly buffer LightsBuffer
+{
+    Lights lightData;
+};
+
+layout(set = 0, binding = 9) readonly buffer LightClustersBuffer
+{
+    LightClusters lightClusters;
+};
+
+#include "Lighting/Lighting.glsl"
 
 layout(location = 0) in vec3 inNormal;
 layout(location = 1) in vec4 inTangent;
 layout(location = 2) in vec2 inUv;
 layout(location = 3) in vec4 inColor;
+layout(location = 4) in vec3 inPosition; // World space
 
 // layout(set = 0, binding = 6) uniform texture2D texImage;
 // layout(set = 0, binding = 7) uniform sampler texSampler;
@@ -21,8 +39,11 @@ void main()
 
     float intensity = max(dot(normal, lightDir), 0.0);
 
+    float viewDepth = -(globals.view * vec4(inPosition, 1.0)).z;
+    vec3 lighting = calculateClusteredLights(inPosition, viewDepth, normal, gl_FragCoord.xy);
+
     vec4 baseColor = vec4(normal, 1.0);
-    vec3 diffuse = baseColor.rgb * intensity;
+    vec3 diffuse = baseColor.rgb * (intensity + lighting);
     vec3 ambient = baseColor.rgb * 0.2;
 
     #if DEBUG_VERTEX_COLOR
@@ -30,4 +51,4 @@ void main()
     #else
         outColor = vec4(diffuse + ambient, baseColor.a);
     #endif
-}
\ No newline at end of file
+}
@@ -15,22 +15,34 @@ layout(push_constant) uniform Globals
     PushConstants globals;
 };
 
-layout(set = 0, binding = 0) readonly buffer Draws 
+layout(set = 0, binding = 0) readonly buffer VisibleInstances
 {
-    Draw draws[]; 
+    VisibleInstance visibleInstances[];
 };
 
-#if VISUALIZE_LODS
+#if VISUALIZE_LODS && !VISIBILITY_BUFFER
 layout(set = 0, binding = 1) readonly buffer DrawsDebugData
 {
     uint drawsDebugData[];
 };
 #endif
 
+#if INSTANCED_DRAWS
+layout(set = 0, binding = 2) readonly buffer Instances
+{
+    uint instances[]; // Visible instance indices of (primitive, LOD) buckets, see InstancedCommands.comp
+};
+#endif
+
+#if VISIBILITY_BUFFER
+layout(location = 0) flat out uint outInstanceIndex; // Attributes are reconstructed by VisibilityResolve.frag
+#else
 layout(location = 0) out vec3 outNormal;
 layout(location = 1) out vec4 outTangent;
 layout(location = 2) out vec2 outUv;
 layout(location = 3) out vec4 outColor;
+layout(location = 4) out vec3 outPosition; // World space, for clustered lights
+#endif
 
 void main()
 {
@@ -40,21 +52,33 @@ void main()
     vec2 uv = vec2(inPosAndU.w, inNormalAndV.w);
     vec4 color = inColor;
 
-    Draw draw = draws[gl_InstanceIndex];
+    #if INSTANCED_DRAWS
+        uint instanceIndex = instances[gl_InstanceIndex];
+    #else
+        uint instanceIndex = gl_InstanceIndex;
+    #endif
 
-    position = rotateQuat(position, draw.rotation) * draw.scale + draw.position;
-    normal = rotateQuat(normal, draw.rotation);    
+    mat3x4 transform = visibleInstances[instanceIndex].transform;
+
+    position = vec4(position, 1.0) * transform;
+    normal = vec4(normal, 0.0) * transform; // Uniform scale only, normalized in fragment shader
 
     vec4 clip = globals.projection * globals.view * vec4(position, 1.0);
 
     gl_Position = clip;
-    outNormal = normal;
-    outTangent = tangent;
-    outUv = uv;
 
-    #if VISUALIZE_LODS
-        outColor = hashToColor(hash(drawsDebugData[gl_InstanceIndex]));
+    #if VISIBILITY_BUFFER
+        outInstanceIndex = instanceIndex;
     #else
-        outColor = color;
+        outNormal = normal;
+        outTangent = tangent;
+        outUv = uv;
+        outPosition = position;
+
+        #if VISUALIZE_LODS
+            outColor = hashToColor(hash(drawsDebugData[instanceIndex]));
+        #else
+            outColor = color;
+        #endif
     #endif
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive: require
+
+#include "Common.h"
+#include "Math.glsl"
+
+layout(push_constant) uniform Globals
+{
+    PushConstants globals;
+};
+
+layout(set = 0, binding = 3) uniform sampler2D impostorAtlas;
+
+layout(set = 0, binding = 8) readonly buffer LightsBuffer
+{
+    Lights lightData;
+};
+
+layout(set = 0, binding = 9) readonly buffer LightClustersBuffer
+{
+    LightClusters lightClusters;
+};
+
+#include "Lighting/Lighting.glsl"
+
+layout(location = 0) in vec2 inFrameUv;
+layout(location = 1) flat in uvec2 inFrameOrigin;
+layout(location = 2) in vec3 inPosition; // World space
+layout(location = 3) flat in vec4 inRotation;
+layout(location = 4) flat in vec3 inFrameDirection; // World space
+layout(location = 5) flat in float inRadius;
+
+layout(location = 0) out vec4 outColor;
+
+// Atlas texel holds normal and depth of the baked frame, see ImpostorBake.frag, the surface is moved from the quad
+// along the frame direction by the depth, so impostors are depth tested against each other and the geometry
+// Shading is the same as in Default.frag
+void main()
+{
+    ivec2 texel = ivec2(inFrameOrigin) + min(ivec2(inFrameUv * float(IMPOSTOR_FRAME_SIZE)), ivec2(IMPOSTOR_FRAME_SIZE - 1));
+    vec4 normalAndDepth = texelFetch(impostorAtlas, texel, 0);
+
+    if (normalAndDepth.a == 0.0)
+    {
+        discard;
+    }
+
+    vec3 normal = normalize(rotateQuat(normalAndDepth.xyz * 2.0 - 1.0, inRotation));
+    vec3 position = inPosition + inFrameDirection * inRadius * (normalAndDepth.a * 2.0 - 1.0);
+
+    vec4 clip = globals.projection * globals.view * vec4(position, 1.0);
+    gl_FragDepth = clip.z / clip.w;
+
+    vec3 lightDir = normalize(vec3(0.5, 0.5, 1.0));
+
+    float intensity = max(dot(normal, lightDir), 0.0);
+
+    float viewDepth = -(globals.view * vec4(position, 1.0)).z;
+    vec3 lighting = calculateClusteredLights(position, viewDepth, normal, gl_FragCoord.xy);
+
+    vec4 baseColor = vec4(normal, 1.0);
+    vec3 diffuse = baseColor.rgb * (intensity + lighting);
+    vec3 ambient = baseColor.rgb * 0.2;
+
+    #if VISUALIZE_LODS
+        outColor = hashToColor(hash(uint(MAX_LOD_COUNT))); // Past the LODs of the primitive
+    #else
+        outColor = vec4(diffuse + ambient, baseColor.a);
+    #endif
+}
@@ -0,0 +1,81 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+// Shared by ImpostorStage baking and Impostor.vert, so the view picked for drawing is the one baked into the atlas
+// Views of a primitive are laid out on IMPOSTOR_FRAME_COUNT^2 frames of its atlas tile by octahedral mapping of their
+// directions (from the primitive to the camera, in primitive space), each frame is an orthographic view of the bounds
+
+#ifdef __cplusplus
+#pragma once
+
+#include "Shaders/Common.h"
+
+namespace gpu
+{
+#define SHARED_FUNCTION inline
+#else
+#include "Common.h"
+
+#define SHARED_FUNCTION
+#endif
+
+// Unit direction to [-1, 1] square, lower hemisphere is folded over the diagonals
+SHARED_FUNCTION vec2 octahedralEncode(vec3 direction)
+{
+    vec3 n = direction / dot(abs(direction), vec3(1.0f));
+
+    if (n.z >= 0.0f)
+    {
+        return vec2(n.x, n.y);
+    }
+
+    return vec2((1.0f - abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f), (1.0f - abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+SHARED_FUNCTION vec3 octahedralDecode(vec2 p)
+{
+    vec3 n = vec3(p.x, p.y, 1.0f - dot(abs(p), vec2(1.0f)));
+    float t = max(-n.z, 0.0f);
+
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+
+    return normalize(n);
+}
+
+// Frame whose view direction is the closest to the given one
+SHARED_FUNCTION uvec2 getImpostorFrame(vec3 direction)
+{
+    vec2 p = octahedralEncode(direction) * 0.5f + 0.5f;
+
+    return min(uvec2(p * float(IMPOSTOR_FRAME_COUNT)), uvec2(IMPOSTOR_FRAME_COUNT - 1));
+}
+
+SHARED_FUNCTION vec3 getImpostorFrameDirection(uvec2 frame)
+{
+    return octahedralDecode((vec2(frame) + 0.5f) / float(IMPOSTOR_FRAME_COUNT) * 2.0f - 1.0f);
+}
+
+// Frame X axis, Y axis is cross(direction, right), the same basis glm::lookAt builds looking against the direction
+SHARED_FUNCTION vec3 getImpostorFrameRight(vec3 direction)
+{
+    vec3 upHint = abs(direction.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+
+    return normalize(cross(upHint, direction));
+}
+
+// Top left pixel of the frame in the atlas
+SHARED_FUNCTION uvec2 getImpostorFrameOrigin(uint primitiveIndex, uvec2 frame)
+{
+    uvec2 tile = uvec2(primitiveIndex % IMPOSTOR_ATLAS_TILES, primitiveIndex / IMPOSTOR_ATLAS_TILES);
+
+    return tile * uint(IMPOSTOR_TILE_SIZE) + frame * uint(IMPOSTOR_FRAME_SIZE);
+}
+
+#undef SHARED_FUNCTION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
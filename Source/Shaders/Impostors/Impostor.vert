@@ -0,0 +1,69 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive: require
+
+#include "Common.h"
+#include "Math.glsl"
+#include "Impostors/Impostor.h"
+
+layout(push_constant) uniform Globals
+{
+    PushConstants globals;
+};
+
+layout(set = 0, binding = 0) readonly buffer Draws
+{
+    Draw draws[];
+};
+
+layout(set = 0, binding = 1) readonly buffer PrimitiveBoundsBuffer
+{
+    PrimitiveBounds primitiveBounds[];
+};
+
+layout(set = 0, binding = 2) readonly buffer ImpostorDrawsBuffer
+{
+    ImpostorCommands impostorCommands;
+    uint impostorDraws[];
+};
+
+layout(location = 0) out vec2 outFrameUv;
+layout(location = 1) flat out uvec2 outFrameOrigin; // In atlas pixels
+layout(location = 2) out vec3 outPosition; // World space, on the frame plane through the bounds center
+layout(location = 3) flat out vec4 outRotation;
+layout(location = 4) flat out vec3 outFrameDirection; // World space
+layout(location = 5) flat out float outRadius;
+
+// 1 instance per draw appended by PrimitiveCull.comp, second pass draws start from firstInstance of its command
+// The quad covers the bounds in the plane of the frame closest to the camera direction, so its texels map 1 to 1
+void main()
+{
+    Draw draw = draws[impostorDraws[gl_InstanceIndex]];
+    PrimitiveBounds bounds = primitiveBounds[draw.primitiveIndex];
+
+    vec4 rotation = unpackRotation(draw.rotation);
+    vec4 inverseRotation = vec4(-rotation.xyz, rotation.w);
+
+    vec3 worldCenter = rotateQuat(bounds.center, rotation) * draw.scale + draw.position;
+    float radius = bounds.radius * draw.scale;
+
+    vec3 cameraPosition = -(transpose(mat3(globals.view)) * globals.view[3].xyz);
+    vec3 direction = rotateQuat(normalize(cameraPosition - worldCenter), inverseRotation);
+
+    uvec2 frame = getImpostorFrame(direction);
+    vec3 frameDirection = getImpostorFrameDirection(frame);
+    vec3 right = getImpostorFrameRight(frameDirection);
+    vec3 up = cross(frameDirection, right);
+
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1) * 2.0 - 1.0;
+    vec3 position = worldCenter + rotateQuat(right * corner.x + up * corner.y, rotation) * radius;
+
+    gl_Position = globals.projection * globals.view * vec4(position, 1.0);
+
+    outFrameUv = vec2(corner.x * 0.5 + 0.5, 0.5 - corner.y * 0.5); // Frames are baked with Y flipped projection
+    outFrameOrigin = getImpostorFrameOrigin(draw.primitiveIndex, frame);
+    outPosition = position;
+    outRotation = rotation;
+    outFrameDirection = rotateQuat(frameDirection, rotation);
+    outRadius = radius;
+}
@@ -0,0 +1,18 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive: require
+
+#include "Common.h"
+
+layout(location = 0) in vec3 inNormal; // Primitive space, Default.vert is drawn with identity transform
+
+layout(location = 0) out vec4 outNormalAndDepth;
+
+// Frames are orthographic views of the bounding sphere, so depth is linear between its front (1) and back (0),
+// 0 is left for empty texels, Impostor.frag discards them
+void main()
+{
+    vec3 normal = normalize(inNormal);
+
+    outNormalAndDepth = vec4(normal * 0.5 + 0.5, max(gl_FragCoord.z, 1.0 / 255.0));
+}
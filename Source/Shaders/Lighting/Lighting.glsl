@@ -0,0 +1,60 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+// Shading of the point and spot lights binned into light clusters by LightCull.comp
+// Including shader declares lightData (LightsBuffer) and lightClusters (LightClustersBuffer)
+
+// Diffuse lighting of a point or spot light, inverse square falloff windowed to reach 0 at the range
+vec3 calculateLight(Light light, vec3 position, vec3 normal)
+{
+    vec3 toLight = light.position - position;
+    float distanceSq = dot(toLight, toLight);
+    float rangeSq = light.range * light.range;
+
+    if (distanceSq >= rangeSq)
+    {
+        return vec3(0.0);
+    }
+
+    vec3 lightDir = toLight * inversesqrt(distanceSq);
+
+    float window = 1.0 - (distanceSq * distanceSq) / (rangeSq * rangeSq);
+    float attenuation = window * window / (distanceSq + 1.0);
+
+    if (light.cosOuterAngle > -1.0)
+    {
+        attenuation *= smoothstep(light.cosOuterAngle, light.cosInnerAngle, dot(-lightDir, light.direction));
+    }
+
+    return light.color * attenuation * max(dot(normal, lightDir), 0.0);
+}
+
+// Lighting of the lights in the cluster of the fragment, position is in world space
+// Fragments farther than the light grid aren't reached by any light
+vec3 calculateClusteredLights(vec3 position, float viewDepth, vec3 normal, vec2 fragCoord)
+{
+    LightGrid grid = lightData.grid;
+
+    if (grid.lightCount == 0 || viewDepth >= grid.far)
+    {
+        return vec3(0.0);
+    }
+
+    uvec2 tile = min(uvec2(fragCoord / grid.tileSize), uvec2(LIGHT_CLUSTER_X - 1, LIGHT_CLUSTER_Y - 1));
+    uint slice = uint(clamp(log(viewDepth) * grid.sliceScale + grid.sliceBias, 0.0, float(LIGHT_CLUSTER_Z - 1)));
+    uint clusterIndex = tile.x + LIGHT_CLUSTER_X * (tile.y + LIGHT_CLUSTER_Y * slice);
+
+    uint lightCount = lightClusters.lightCounts[clusterIndex];
+
+    vec3 lighting = vec3(0.0);
+
+    for (uint i = 0; i < lightCount; ++i)
+    {
+        uint lightIndex = lightClusters.lightIndices[clusterIndex * MAX_CLUSTER_LIGHTS + i];
+        lighting += calculateLight(lightData.lights[lightIndex], position, normal);
+    }
+
+    return lighting;
+}
+
+#endif
@@ -24,6 +24,79 @@ vec3 rotateQuat(vec3 v, vec4 q)
 	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
 }
 
+// Decodes smallest three quaternion of gpu::Draw, see Math::PackQuatSmallestThree
+vec4 unpackRotation(uvec2 packedRotation)
+{
+    const float range = 0.70710678; // All components except the largest one are within [-1 / sqrt(2), 1 / sqrt(2)]
+
+    uvec3 quantized = uvec3(packedRotation.x & 0xFFFF, packedRotation.x >> 16, packedRotation.y & 0xFFFF);
+    vec3 smallest = (vec3(quantized) / 65535.0 * 2.0 - 1.0) * range;
+    float largest = sqrt(max(1.0 - dot(smallest, smallest), 0.0));
+
+    switch ((packedRotation.y >> 16) & 3)
+    {
+        case 0: return vec4(largest, smallest);
+        case 1: return vec4(smallest.x, largest, smallest.yz);
+        case 2: return vec4(smallest.xy, largest, smallest.z);
+        default: return vec4(smallest, largest);
+    }
+}
+
+// Encodes unit quaternion the same way as Math::PackQuatSmallestThree
+uvec2 packRotation(vec4 rotation)
+{
+    const float range = 0.70710678;
+
+    uint largestIndex = 0;
+
+    for (uint i = 1; i < 4; ++i)
+    {
+        if (abs(rotation[i]) > abs(rotation[largestIndex]))
+        {
+            largestIndex = i;
+        }
+    }
+
+    // q and -q are the same rotation, keep the largest component positive to restore it from the unit length
+    rotation = rotation[largestIndex] < 0.0 ? -rotation : rotation;
+
+    vec3 smallest;
+
+    switch (largestIndex)
+    {
+        case 0: smallest = rotation.yzw; break;
+        case 1: smallest = rotation.xzw; break;
+        case 2: smallest = rotation.xyw; break;
+        default: smallest = rotation.xyz; break;
+    }
+
+    // roundEven() as round() halfway cases are implementation defined, matches glm::roundEven on CPU
+    uvec3 quantized = uvec3(roundEven(clamp(smallest / range * 0.5 + 0.5, 0.0, 1.0) * 65535.0));
+
+    return uvec2(quantized.x | (quantized.y << 16), quantized.z | (largestIndex << 16));
+}
+
+// Hamilton product a * b (apply b, then a), xyzw
+vec4 multiplyQuat(vec4 a, vec4 b)
+{
+    return vec4(a.w * b.xyz + b.w * a.xyz + cross(a.xyz, b.xyz), a.w * b.w - dot(a.xyz, b.xyz));
+}
+
+// Transposed affine 3x4 matrix (use as vec4(v, 1.0) * transform) of scale, then rotation, then translation
+mat3x4 composeTransform(vec3 translation, vec4 rotation, float scale)
+{
+    vec3 q2 = rotation.xyz * 2.0;
+
+    float xx = rotation.x * q2.x, yy = rotation.y * q2.y, zz = rotation.z * q2.z;
+    float xy = rotation.x * q2.y, xz = rotation.x * q2.z, yz = rotation.y * q2.z;
+    float wx = rotation.w * q2.x, wy = rotation.w * q2.y, wz = rotation.w * q2.z;
+
+    return mat3x4(
+        vec4(vec3(1.0 - (yy + zz), xy - wz, xz + wy) * scale, translation.x),
+        vec4(vec3(xy + wz, 1.0 - (xx + zz), yz - wx) * scale, translation.y),
+        vec4(vec3(xz - wy, yz + wx, 1.0 - (xx + yy)) * scale, translation.z));
+}
+
 // Adapted version of https://gist.github.com/JarkkoPFC/1186bc8a861dae3c8339b0cda4e6cdb3
 // Negated all entries of center.z (except squares) as original implementation assumes camera looks in +z
 // Negated P11 (as by default we flip Y with it) to make this function return this kind of NDC:
@@ -0,0 +1,81 @@
+#ifndef SCENE_COPY_H
+#define SCENE_COPY_H
+
+// Shared by SceneHelpers::RandomlyCopyScene and RandomlyCopyScene.comp, so both produce the same copies for a seed
+
+#ifdef __cplusplus
+#pragma once
+
+#include "Shaders/Common.h"
+
+namespace gpu
+{
+#define SHARED_FUNCTION inline
+#else
+#include "Common.h"
+
+#define SHARED_FUNCTION
+#endif
+
+#define SCENE_COPY_RANDOM_STRIDE 4u // Random values reserved per copy
+
+// PCG hash, see https://www.reedbeta.com/blog/hash-functions-for-gpu-rendering/
+SHARED_FUNCTION uint pcgHash(uint value)
+{
+    uint state = value * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+
+    return (word >> 22u) ^ word;
+}
+
+// Counter-based: value depends only on (seed, counter), so any thread can generate any value of the sequence
+// Uniform in [0, 1), 24 bits are converted to float exactly, so the result is bit identical on CPU and GPU
+SHARED_FUNCTION float randomFloat(uint seed, uint counter)
+{
+    return float(pcgHash(pcgHash(seed) ^ counter) >> 8u) * (1.0f / 16777216.0f);
+}
+
+// Same as glm::quat(eulerAngles), returns xyzw
+SHARED_FUNCTION vec4 quatFromEuler(vec3 angles)
+{
+    vec3 c = cos(angles * 0.5f);
+    vec3 s = sin(angles * 0.5f);
+
+    return vec4(
+        s.x * c.y * c.z - c.x * s.y * s.z,
+        c.x * s.y * c.z + s.x * c.y * s.z,
+        c.x * c.y * s.z - s.x * s.y * c.z,
+        c.x * c.y * c.z + s.x * s.y * s.z);
+}
+
+// Transform applied to the scene around its center
+struct SceneCopyTransform
+{
+    vec3 translation;
+    float scale;
+    vec4 rotation; // Quaternion xyzw
+};
+
+// Translations are sorted by distance on CPU and passed in, see SceneHelpers::GetSceneCopyTranslations
+SHARED_FUNCTION SceneCopyTransform getSceneCopyTransform(SceneCopyParams params, uint copyIndex, vec3 translation)
+{
+    uint counter = copyIndex * SCENE_COPY_RANDOM_STRIDE;
+
+    vec3 angles = vec3(randomFloat(params.seed, counter), randomFloat(params.seed, counter + 1u),
+        randomFloat(params.seed, counter + 2u)) * 6.28318531f;
+
+    SceneCopyTransform transform;
+    transform.translation = translation;
+    transform.scale = 0.2f + 0.8f * randomFloat(params.seed, counter + 3u);
+    transform.rotation = quatFromEuler(angles);
+
+    return transform;
+}
+
+#undef SHARED_FUNCTION
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,9 @@
+#version 450
+
+// 1 triangle covering the whole screen, draw it with 3 vertices
+void main()
+{
+    vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
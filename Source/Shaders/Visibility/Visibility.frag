@@ -0,0 +1,43 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive: require
+
+#if SOFTWARE_RASTERIZATION
+#extension GL_EXT_shader_explicit_arithmetic_types_int64: require
+#extension GL_EXT_shader_atomic_int64: require
+#endif
+
+#include "Common.h"
+
+#if SOFTWARE_RASTERIZATION
+layout(set = 0, binding = 6) readonly buffer SoftwareRasterBuffer
+{
+    SoftwareRaster softwareRaster;
+};
+
+layout(set = 1, binding = 0) buffer SoftwareVisibility
+{
+    uint64_t softwareVisibility[];
+};
+#endif
+
+layout(early_fragment_tests) in;
+
+layout(location = 0) flat in uint inInstanceIndex;
+
+layout(location = 0) out uvec2 outVisibility;
+
+// Writes only what's needed to find the closest triangle again, shading is done once per pixel by VisibilityResolve.frag
+// Vertex pipeline primitive ID is the triangle index in the LOD, mesh pipeline writes meshlet and triangle in it instead
+void main()
+{
+    outVisibility = uvec2(inInstanceIndex, uint(gl_PrimitiveID));
+
+    // Software rasterized triangles replace the payload only where they are closer, see SoftwareRaster.comp
+    #if SOFTWARE_RASTERIZATION
+        uvec2 pixel = uvec2(gl_FragCoord.xy);
+        uint64_t depthAndPayload = (uint64_t(floatBitsToUint(gl_FragCoord.z)) << 32) | uint64_t(HARDWARE_RASTER_PAYLOAD);
+
+        atomicMax(softwareVisibility[pixel.y * softwareRaster.screenSize.x + pixel.x], depthAndPayload);
+    #endif
+}
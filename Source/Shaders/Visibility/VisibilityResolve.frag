@@ -0,0 +1,217 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive: require
+#extension GL_EXT_samplerless_texture_functions: require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64: require
+
+#include "Common.h"
+#include "Math.glsl"
+
+layout(push_constant) uniform Globals
+{
+    PushConstants globals;
+};
+
+layout(set = 0, binding = 0) readonly buffer Vertices
+{
+    Vertex vertices[];
+};
+
+#if MESH_PIPELINE
+layout(set = 0, binding = 1) readonly buffer MeshletData8
+{
+    uint8_t meshletData8[];
+};
+
+layout(set = 0, binding = 1) readonly buffer MeshletData16
+{
+    uint16_t meshletData16[];
+};
+
+layout(set = 0, binding = 1) readonly buffer MeshletData32
+{
+    uint meshletData32[];
+};
+
+layout(set = 0, binding = 2) readonly buffer Meshlets
+{
+    Meshlet meshlets[];
+};
+#else
+layout(set = 0, binding = 1) readonly buffer Indices
+{
+    uint indices[];
+};
+
+layout(set = 0, binding = 2) readonly buffer Primitives
+{
+    Primitive primitives[];
+};
+
+layout(set = 0, binding = 3) readonly buffer InstanceLods
+{
+    uint instanceLods[]; // primitiveIndex * MAX_LOD_COUNT + LOD index of visible instances, see PrimitiveCull.comp
+};
+#endif
+
+layout(set = 0, binding = 4) readonly buffer VisibleInstances
+{
+    VisibleInstance visibleInstances[];
+};
+
+#if VISUALIZE_LODS
+layout(set = 0, binding = 5) readonly buffer DrawsDebugData
+{
+    uint drawsDebugData[];
+};
+#endif
+
+layout(set = 0, binding = 6) readonly buffer LightsBuffer
+{
+    Lights lightData;
+};
+
+layout(set = 0, binding = 7) readonly buffer LightClustersBuffer
+{
+    LightClusters lightClusters;
+};
+
+#if SOFTWARE_RASTERIZATION
+layout(set = 0, binding = 8) readonly buffer SoftwareMeshlets
+{
+    uvec2 softwareMeshlets[]; // (visible instance, meshlet)
+};
+#endif
+
+#include "Lighting/Lighting.glsl"
+
+layout(set = 1, binding = 0) uniform utexture2D visibility;
+
+#if SOFTWARE_RASTERIZATION
+layout(set = 1, binding = 1) readonly buffer SoftwareVisibility
+{
+    uint64_t softwareVisibility[]; // Closest depth and payload of both rasterizers, see SoftwareRaster.comp
+};
+#endif
+
+layout(location = 0) out vec4 outColor;
+
+// Absolute vertex indices of the triangle stored in the visibility buffer
+uvec3 getTriangleVertices(uint instanceIndex, uint triangleId)
+{
+    #if MESH_PIPELINE
+        uint meshletIndex = triangleId >> VISIBILITY_TRIANGLE_BITS;
+        uint triangleIndex = triangleId & ((1u << VISIBILITY_TRIANGLE_BITS) - 1);
+
+        uint dataOffset = meshlets[meshletIndex].dataOffset;
+        uint firstVertexOffset = meshlets[meshletIndex].firstVertexOffset;
+        bool bShortVertexOffsets = uint(meshlets[meshletIndex].bShortVertexOffsets) == 1;
+        uint vertexCount = uint(meshlets[meshletIndex].vertexCount);
+
+        // Same layout as in Meshlet.mesh: vertex offsets, then 8-bit local indices
+        uint indexOffset = (dataOffset + (bShortVertexOffsets ? (vertexCount + 1) / 2 : vertexCount)) * 4 + triangleIndex * 3;
+
+        uvec3 vertexIndices;
+
+        for (uint i = 0; i < 3; ++i)
+        {
+            uint localIndex = uint(meshletData8[indexOffset + i]);
+
+            vertexIndices[i] = firstVertexOffset + (bShortVertexOffsets ? uint(meshletData16[dataOffset * 2 + localIndex])
+                : meshletData32[dataOffset + localIndex]);
+        }
+
+        return vertexIndices;
+    #else
+        uint primitiveLod = instanceLods[instanceIndex];
+        uint primitiveIndex = primitiveLod / MAX_LOD_COUNT;
+        uint lodIndex = primitiveLod % MAX_LOD_COUNT;
+
+        uint firstIndex = primitives[primitiveIndex].lods[lodIndex].indexOffset + triangleId * 3;
+        uint vertexOffset = primitives[primitiveIndex].vertexOffset;
+
+        return uvec3(indices[firstIndex], indices[firstIndex + 1], indices[firstIndex + 2]) + vertexOffset;
+    #endif
+}
+
+// Perspective correct barycentrics of the pixel: clip positions (x, y, w) weighted by them pass through its NDC
+// Unlike division by w it also works for triangles with vertices behind the camera
+vec3 calculateBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 ndc)
+{
+    vec3 weights = inverse(mat3(clip0.xyw, clip1.xyw, clip2.xyw)) * vec3(ndc, 1.0);
+
+    return weights / (weights.x + weights.y + weights.z);
+}
+
+// Shades every pixel once with the attributes of the closest triangle, which the geometry passes stored
+void main()
+{
+    uvec2 visibilityId = texelFetch(visibility, ivec2(gl_FragCoord.xy), 0).xy;
+
+    // Software rasterized triangle is the closest one unless hardware rasterization has written its payload
+    #if SOFTWARE_RASTERIZATION
+        uvec2 pixel = uvec2(gl_FragCoord.xy);
+        uint64_t depthAndPayload = softwareVisibility[pixel.y * uint(textureSize(visibility, 0).x) + pixel.x];
+        uint payload = uint(depthAndPayload & 0xFFFFFFFFul);
+
+        if (depthAndPayload != 0ul && payload != HARDWARE_RASTER_PAYLOAD)
+        {
+            uvec2 softwareMeshlet = softwareMeshlets[payload >> VISIBILITY_TRIANGLE_BITS];
+            uint triangleIndex = payload & ((1u << VISIBILITY_TRIANGLE_BITS) - 1);
+
+            visibilityId = uvec2(softwareMeshlet.x, (softwareMeshlet.y << VISIBILITY_TRIANGLE_BITS) | triangleIndex);
+        }
+    #endif
+
+    uint instanceIndex = visibilityId.x;
+
+    if (instanceIndex == INVALID_VISIBILITY_INSTANCE)
+    {
+        discard; // Keeps the clear color of the pass
+    }
+
+    uvec3 vertexIndices = getTriangleVertices(instanceIndex, visibilityId.y);
+
+    mat3x4 transform = visibleInstances[instanceIndex].transform;
+    mat4 viewProjection = globals.projection * globals.view;
+
+    vec4 clip[3];
+    vec3 positions[3];
+    vec3 normals[3];
+
+    for (uint i = 0; i < 3; ++i)
+    {
+        positions[i] = vec4(vertices[vertexIndices[i]].posAndU.xyz, 1.0) * transform;
+
+        clip[i] = viewProjection * vec4(positions[i], 1.0);
+        normals[i] = vec4(vertices[vertexIndices[i]].normalAndV.xyz, 0.0) * transform;
+    }
+
+    vec2 ndc = gl_FragCoord.xy / vec2(textureSize(visibility, 0)) * 2.0 - 1.0;
+    vec3 barycentrics = calculateBarycentrics(clip[0], clip[1], clip[2], ndc);
+
+    // Same shading as Default.frag
+    vec3 normal = normalize(mat3(normals[0], normals[1], normals[2]) * barycentrics);
+    vec3 lightDir = normalize(vec3(0.5, 0.5, 1.0));
+
+    float intensity = max(dot(normal, lightDir), 0.0);
+
+    vec3 position = mat3(positions[0], positions[1], positions[2]) * barycentrics;
+    float viewDepth = -(globals.view * vec4(position, 1.0)).z;
+    vec3 lighting = calculateClusteredLights(position, viewDepth, normal, gl_FragCoord.xy);
+
+    vec4 baseColor = vec4(normal, 1.0);
+    vec3 diffuse = baseColor.rgb * (intensity + lighting);
+    vec3 ambient = baseColor.rgb * 0.2;
+
+    #if VISUALIZE_LODS
+        outColor = hashToColor(hash(drawsDebugData[instanceIndex]));
+    #elif VISUALIZE_MESHLETS && MESH_PIPELINE
+        outColor = hashToColor(hash(visibilityId.y >> VISIBILITY_TRIANGLE_BITS));
+    #elif DEBUG_VERTEX_COLOR
+        outColor = mat3x4(vertices[vertexIndices[0]].color, vertices[vertexIndices[1]].color,
+            vertices[vertexIndices[2]].color) * barycentrics;
+    #else
+        outColor = vec4(diffuse + ambient, baseColor.a);
+    #endif
+}
@@ -2,6 +2,7 @@
 
 DISABLE_WARNINGS_BEGIN
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 DISABLE_WARNINGS_END
 
 #include "Utils/DataStructures.hpp"
@@ -15,4 +16,16 @@ namespace Math
     Sphere AverageSphere(const std::vector<glm::vec3>& points);
 
     glm::vec4 NormalizePlane(const glm::vec4 plane);
+    
+    // Normalized planes pointing inside (left, right, bottom, top, near, far) for [0, 1] depth range,
+    // degenerate far plane of infinite projection is replaced by the one which never culls
+    std::array<glm::vec4, 6> FrustumPlanes(const glm::mat4& viewProjection);
+    
+    // Interleaves lower 21 bits of each coordinate
+    uint64_t MortonCode(const glm::uvec3& coords);
+    
+    // Smallest three quaternion encoding: 3 smallest components quantized to 16 bits each (x: 0, 1; y: 2),
+    // index of the omitted largest one in bits 16-17 of y, see unpackRotation() in Math.glsl
+    glm::uvec2 PackQuatSmallestThree(const glm::quat& quat);
+    glm::quat UnpackQuatSmallestThree(const glm::uvec2& packedQuat);
 }
@@ -13,6 +13,9 @@ DISABLE_WARNINGS_END
 namespace MathDetails
 {
     static std::mt19937 rng(std::random_device{}());
+    
+    // All quaternion components except the largest one are within [-1 / sqrt(2), 1 / sqrt(2)]
+    static constexpr float smallestThreeRange = 0.70710678f;
 
     static float Dist(const glm::vec3& a, const glm::vec3& b)
     {
@@ -24,6 +27,19 @@ namespace MathDetails
         return Dist(s.center, p) <= s.radius + 1e-6f;
     }
 
+    // Inserts 2 zero bits between each of the lower 21 bits
+    static uint64_t SpreadBits(uint64_t x)
+    {
+        x &= 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffff;
+        x = (x | x << 16) & 0x1f0000ff0000ff;
+        x = (x | x << 8) & 0x100f00f00f00f00f;
+        x = (x | x << 4) & 0x10c30c30c30c30c3;
+        x = (x | x << 2) & 0x1249249249249249;
+        
+        return x;
+    }
+
     static Sphere SphereFrom(const glm::vec3& a)
     {
         return { a, 0.0f };
@@ -239,3 +255,85 @@ glm::vec4 Math::NormalizePlane(const glm::vec4 plane)
 {
     return plane / glm::length(glm::vec3(plane));
 }
+
+std::array<glm::vec4, 6> Math::FrustumPlanes(const glm::mat4& viewProjection)
+{
+    const glm::mat4 rows = glm::transpose(viewProjection);
+
+    std::array<glm::vec4, 6> planes = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1],
+        rows[2], rows[3] - rows[2] };
+
+    for (glm::vec4& plane : planes)
+    {
+        plane = glm::length(glm::vec3(plane)) > 0.0f ? NormalizePlane(plane) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    return planes;
+}
+
+uint64_t Math::MortonCode(const glm::uvec3& coords)
+{
+    using namespace MathDetails;
+    
+    return SpreadBits(coords.x) | SpreadBits(coords.y) << 1 | SpreadBits(coords.z) << 2;
+}
+
+glm::uvec2 Math::PackQuatSmallestThree(const glm::quat& quat)
+{
+    using namespace MathDetails;
+    
+    auto components = glm::vec4(quat.x, quat.y, quat.z, quat.w);
+    
+    uint32_t largestIndex = 0;
+    
+    for (uint32_t i = 1; i < 4; ++i)
+    {
+        if (std::abs(components[i]) > std::abs(components[largestIndex]))
+        {
+            largestIndex = i;
+        }
+    }
+    
+    // q and -q are the same rotation, keep the largest component positive to restore it from the unit length
+    if (components[largestIndex] < 0.0f)
+    {
+        components = -components;
+    }
+    
+    std::array<uint32_t, 3> quantized = {};
+    
+    for (uint32_t i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != largestIndex)
+        {
+            const float normalized = glm::clamp(components[i] / smallestThreeRange * 0.5f + 0.5f, 0.0f, 1.0f);
+            quantized[j++] = static_cast<uint32_t>(glm::roundEven(normalized * 65535.0f)); // Same as packRotation in GLSL
+        }
+    }
+    
+    return { quantized[0] | quantized[1] << 16, quantized[2] | largestIndex << 16 };
+}
+
+glm::quat Math::UnpackQuatSmallestThree(const glm::uvec2& packedQuat)
+{
+    using namespace MathDetails;
+    
+    const std::array<uint32_t, 3> quantized = { packedQuat.x & 0xffff, packedQuat.x >> 16, packedQuat.y & 0xffff };
+    const uint32_t largestIndex = (packedQuat.y >> 16) & 3;
+    
+    glm::vec4 components;
+    float lengthSquared = 0.0f;
+    
+    for (uint32_t i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != largestIndex)
+        {
+            components[i] = (static_cast<float>(quantized[j++]) / 65535.0f * 2.0f - 1.0f) * smallestThreeRange;
+            lengthSquared += components[i] * components[i];
+        }
+    }
+    
+    components[largestIndex] = std::sqrt(std::max(1.0f - lengthSquared, 0.0f));
+    
+    return { components.w, components.x, components.y, components.z };
+}
@@ -0,0 +1,134 @@
+#include "Utils/ThreadPool.hpp"
+
+#include <atomic>
+
+ThreadPool::ThreadPool(const uint32_t threadCount /* = std::max(std::thread::hardware_concurrency(), 2u) - 1 */)
+    : maxBackgroundTaskCount{ std::max(threadCount / 2, 1u) }
+{
+    workers.reserve(threadCount);
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back([this](const std::stop_token stopToken) { WorkerLoop(stopToken); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    // Stop all at once, waiting workers are woken up by their stop tokens, then joined by jthread destructors
+    for (std::jthread& worker : workers)
+    {
+        worker.request_stop();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    {
+        std::scoped_lock lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+
+    condition.notify_one();
+}
+
+void ThreadPool::SubmitBackground(std::function<void()> task)
+{
+    {
+        std::scoped_lock lock(mutex);
+        backgroundTasks.push_back(std::move(task));
+    }
+
+    condition.notify_one();
+}
+
+void ThreadPool::ParallelFor(const size_t count, const size_t chunkSize, const std::function<void(size_t, size_t)>& function)
+{
+    Assert(chunkSize > 0);
+
+    const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    if (chunkCount == 0)
+    {
+        return;
+    }
+
+    struct Progress
+    {
+        std::atomic<size_t> nextChunk = 0;
+        std::atomic<size_t> doneChunkCount = 0;
+    };
+
+    // Pool is shared, so helpers can start after the loop has returned, they only see that all chunks are taken
+    const auto progress = std::make_shared<Progress>();
+
+    const auto processChunks = [progress, chunkCount, chunkSize, count, &function]() {
+        for (size_t chunk = progress->nextChunk++; chunk < chunkCount; chunk = progress->nextChunk++)
+        {
+            const size_t begin = chunk * chunkSize;
+            function(begin, std::min(begin + chunkSize, count));
+
+            if (++progress->doneChunkCount == chunkCount)
+            {
+                progress->doneChunkCount.notify_all();
+            }
+        }
+    };
+
+    const auto helperCount = static_cast<uint32_t>(std::min(static_cast<size_t>(GetThreadCount()), chunkCount - 1));
+
+    for (uint32_t i = 0; i < helperCount; ++i)
+    {
+        Submit(processChunks);
+    }
+
+    processChunks();
+
+    // Waits for the chunks only, not for the helpers queued behind other tasks
+    for (size_t done = progress->doneChunkCount; done < chunkCount; done = progress->doneChunkCount)
+    {
+        progress->doneChunkCount.wait(done);
+    }
+}
+
+void ThreadPool::WorkerLoop(const std::stop_token stopToken)
+{
+    while (true)
+    {
+        std::function<void()> task;
+        bool background = false;
+
+        {
+            std::unique_lock lock(mutex);
+
+            const auto canTakeTask = [&]() {
+                return !tasks.empty() || (!backgroundTasks.empty() && runningBackgroundTaskCount < maxBackgroundTaskCount);
+            };
+
+            if (!condition.wait(lock, stopToken, canTakeTask))
+            {
+                return;
+            }
+
+            background = tasks.empty();
+            std::deque<std::function<void()>>& queue = background ? backgroundTasks : tasks;
+
+            task = std::move(queue.front());
+            queue.pop_front();
+
+            runningBackgroundTaskCount += background ? 1 : 0;
+        }
+
+        task();
+
+        if (background)
+        {
+            {
+                std::scoped_lock lock(mutex);
+                --runningBackgroundTaskCount;
+            }
+
+            condition.notify_one(); // Next background task can be taken now
+        }
+    }
+}
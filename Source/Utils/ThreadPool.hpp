@@ -0,0 +1,49 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// Fixed set of worker threads executing tasks in submission order, background tasks only when there are no others
+class ThreadPool
+{
+public:
+    // By default leaves 1 hardware thread for the calling thread, which participates in ParallelFor
+    explicit ThreadPool(uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    uint32_t GetThreadCount() const
+    {
+        return static_cast<uint32_t>(workers.size());
+    }
+
+    void Submit(std::function<void()> task);
+    
+    // For long low priority work, e.g. RenderStage::PrecompilePipelines, at most half of the workers execute them at once,
+    // so the others stay available for Submit and ParallelFor
+    void SubmitBackground(std::function<void()> task);
+
+    // Splits [0, count) into chunks of chunkSize and blocks until function(begin, end) is executed for all of them,
+    // chunks are taken by the workers and the calling thread in increasing order, the calling thread alone finishes
+    // them if the workers are busy with earlier tasks
+    void ParallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& function);
+
+private:
+    void WorkerLoop(std::stop_token stopToken);
+
+    std::mutex mutex;
+    std::condition_variable_any condition;
+    std::deque<std::function<void()>> tasks;
+    std::deque<std::function<void()>> backgroundTasks;
+    uint32_t maxBackgroundTaskCount = 0;
+    uint32_t runningBackgroundTaskCount = 0; // Guarded by mutex
+
+    std::vector<std::jthread> workers;
+};